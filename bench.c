@@ -0,0 +1,523 @@
+/***************************************************************************
+*               Benchmark for Run Length Encoding Library
+*
+*   File    : bench.c
+*   Purpose : Measure the speed of the run length encoding library codecs
+*             on synthetic data.  Each codec is timed encoding and decoding
+*             one large buffer and encoding and decoding many small
+*             messages (100 to 4000 bytes) with a reusable context.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* BENCH: Benchmark for the Run Length Encoding Library
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rle.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define BULK_SIZE       (4UL * 1024 * 1024) /* size of bulk test data */
+#define MSG_COUNT       1024                /* number of small messages */
+#define MSG_MIN         100                 /* smallest message */
+#define MSG_MAX         4000                /* largest message */
+#define MIN_TIME        0.5                 /* seconds to run each test */
+#define SCRATCH_SIZE    4096                /* context scratch buffers */
+#define BATCH_THREADS   4                   /* threads for threaded batch */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef int (*buffer_codec_t)(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen);
+
+typedef int (*batch_codec_t)(const rle_message_t *messages, size_t count,
+    unsigned char *arena, size_t arenaSize, size_t *offsets, size_t *lengths,
+    unsigned int threads);
+
+typedef struct
+{
+    const char *name;                   /* name of the codec */
+    buffer_codec_t encode;              /* encoder */
+    buffer_codec_t decode;              /* decoder */
+    batch_codec_t batch;                /* batch encoder */
+} codec_t;
+
+typedef struct
+{
+    const char *name;                   /* description of the data */
+    size_t minRun;                      /* shortest run */
+    size_t maxRun;                      /* longest run */
+    unsigned int alphabet;              /* number of different symbols */
+} data_set_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static void MakeData(const data_set_t *set, unsigned char *data,
+    size_t len);
+static unsigned long NextRandom(void);
+static double Seconds(void);
+static int BenchBulk(const codec_t *codec, const data_set_t *set,
+    const unsigned char *data, unsigned char *enc, unsigned char *dec);
+static void PickMessages(void);
+static int BenchMessages(const codec_t *codec, const data_set_t *set,
+    const unsigned char *data, unsigned char *enc, unsigned char *dec);
+static int BenchBatch(const codec_t *codec, const data_set_t *set,
+    const unsigned char *data, unsigned char *enc, unsigned char *dec,
+    unsigned int threads);
+
+/***************************************************************************
+*                            GLOBAL VARIABLES
+***************************************************************************/
+static const codec_t codecs[] =
+{
+    {"rle", RleEncodeBuffer, RleDecodeBuffer, RleEncodeBatch},
+    {"vpackbits", VPackBitsEncodeBuffer, VPackBitsDecodeBuffer,
+        VPackBitsEncodeBatch}
+};
+
+static const data_set_t dataSets[] =
+{
+    {"random", 1, 1, 256},
+    {"short", 1, 4, 4},
+    {"mixed", 1, 40, 256},
+    {"long", 100, 2000, 3}
+};
+
+static unsigned long randomState = 1;
+
+/* the small messages, taken from the test data */
+static size_t msgOffsets[MSG_COUNT];
+static size_t msgSizes[MSG_COUNT];
+static size_t msgTotal;
+
+#define NUM_CODECS      (sizeof(codecs) / sizeof(codecs[0]))
+#define NUM_DATA_SETS   (sizeof(dataSets) / sizeof(dataSets[0]))
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : main
+*   Description: This is the main function for this program.  It builds
+*                each data set and runs the bulk, small message, and batch
+*                tests on it for every codec.
+*   Parameters : argc - number of parameters (unused)
+*                argv - parameter list (unused)
+*   Effects    : Benchmark results are written to stdout
+*   Returned   : 0 for success, 1 for failure.
+***************************************************************************/
+int main(int argc, char *argv[])
+{
+    unsigned char *data;
+    unsigned char *enc;
+    unsigned char *dec;
+    size_t i, j;
+    int result;
+
+    (void)argc;
+    (void)argv;
+
+    data = (unsigned char *)malloc(BULK_SIZE);
+    enc = (unsigned char *)malloc(2 * BULK_SIZE);
+    dec = (unsigned char *)malloc(BULK_SIZE);
+    result = 0;
+
+    if ((NULL == data) || (NULL == enc) || (NULL == dec))
+    {
+        perror("Allocating test data");
+        free(data);
+        free(enc);
+        free(dec);
+        return 1;
+    }
+
+    PickMessages();
+    printf("scan kernels: %s\n\n", RleKernelVariant());
+    printf("%-10s %-7s %-9s %8s %10s %10s %12s\n", "codec", "data",
+        "test", "ratio", "enc MB/s", "dec MB/s", "enc msgs/s");
+
+    for (i = 0; (i < NUM_DATA_SETS) && (0 == result); i++)
+    {
+        MakeData(&dataSets[i], data, BULK_SIZE);
+
+        for (j = 0; (j < NUM_CODECS) && (0 == result); j++)
+        {
+            result = BenchBulk(&codecs[j], &dataSets[i], data, enc, dec);
+
+            if (0 == result)
+            {
+                result = BenchMessages(&codecs[j], &dataSets[i], data, enc,
+                    dec);
+            }
+
+            if (0 == result)
+            {
+                result = BenchBatch(&codecs[j], &dataSets[i], data, enc, dec,
+                    1);
+            }
+
+            if (0 == result)
+            {
+                result = BenchBatch(&codecs[j], &dataSets[i], data, enc, dec,
+                    BATCH_THREADS);
+            }
+        }
+    }
+
+    free(data);
+    free(enc);
+    free(dec);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : MakeData
+*   Description: This function fills a buffer with runs whose lengths and
+*                symbols are chosen at random within the limits of a data
+*                set.
+*   Parameters : set - Pointer to the data set description
+*                data - Buffer to fill
+*                len - Size of data
+*   Effects    : data is filled
+*   Returned   : None
+***************************************************************************/
+static void MakeData(const data_set_t *set, unsigned char *data, size_t len)
+{
+    size_t i;
+
+    randomState = 1;
+    i = 0;
+
+    while (i < len)
+    {
+        size_t run;
+        unsigned char c;
+
+        run = set->minRun + (NextRandom() % (set->maxRun - set->minRun + 1));
+        c = (unsigned char)(NextRandom() % set->alphabet);
+
+        for (; (run > 0) && (i < len); run--, i++)
+        {
+            data[i] = c;
+        }
+    }
+}
+
+/***************************************************************************
+*   Function   : NextRandom
+*   Description: This function returns the next value of a simple linear
+*                congruential generator, so every run uses the same data.
+*   Parameters : None
+*   Effects    : randomState is advanced
+*   Returned   : A pseudo random value from 0 to 32767
+***************************************************************************/
+static unsigned long NextRandom(void)
+{
+    randomState = (randomState * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+    return (randomState >> 16) & 0x7FFF;
+}
+
+/***************************************************************************
+*   Function   : Seconds
+*   Description: This function returns the processor time used so far.
+*   Parameters : None
+*   Effects    : None
+*   Returned   : Processor time in seconds
+***************************************************************************/
+static double Seconds(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/***************************************************************************
+*   Function   : BenchBulk
+*   Description: This function times encoding and decoding all of the test
+*                data in one call and verifies the round trip.
+*   Parameters : codec - Pointer to the codec being tested
+*                set - Pointer to the data set description
+*                data - Test data (BULK_SIZE bytes)
+*                enc - Buffer for encoded data (2 * BULK_SIZE bytes)
+*                dec - Buffer for decoded data (BULK_SIZE bytes)
+*   Effects    : Results are written to stdout
+*   Returned   : 0 for success, 1 for failure.
+***************************************************************************/
+static int BenchBulk(const codec_t *codec, const data_set_t *set,
+    const unsigned char *data, unsigned char *enc, unsigned char *dec)
+{
+    size_t encLen, decLen;
+    double start, encTime, decTime;
+    unsigned long reps;
+
+    start = Seconds();
+    reps = 0;
+
+    do
+    {
+        if (codec->encode(NULL, data, BULK_SIZE, enc, 2 * BULK_SIZE,
+            &encLen))
+        {
+            perror("Encoding");
+            return 1;
+        }
+
+        reps++;
+        encTime = Seconds() - start;
+    } while (encTime < MIN_TIME);
+
+    encTime /= reps;
+    start = Seconds();
+    reps = 0;
+
+    do
+    {
+        if (codec->decode(NULL, enc, encLen, dec, BULK_SIZE, &decLen))
+        {
+            perror("Decoding");
+            return 1;
+        }
+
+        reps++;
+        decTime = Seconds() - start;
+    } while (decTime < MIN_TIME);
+
+    decTime /= reps;
+
+    if ((decLen != BULK_SIZE) || memcmp(data, dec, BULK_SIZE))
+    {
+        fprintf(stderr, "%s %s: decoded data doesn't match\n", codec->name,
+            set->name);
+        return 1;
+    }
+
+    printf("%-10s %-7s %-9s %8.3f %10.1f %10.1f %12s\n", codec->name,
+        set->name, "bulk", (double)encLen / BULK_SIZE,
+        BULK_SIZE / encTime / 1e6, BULK_SIZE / decTime / 1e6, "-");
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : PickMessages
+*   Description: This function picks MSG_COUNT messages of MSG_MIN to
+*                MSG_MAX bytes from random places in the test data.  The
+*                same messages are used for every data set.
+*   Parameters : None
+*   Effects    : msgOffsets, msgSizes, and msgTotal are set
+*   Returned   : None
+***************************************************************************/
+static void PickMessages(void)
+{
+    size_t i;
+
+    randomState = 7;
+    msgTotal = 0;
+
+    for (i = 0; i < MSG_COUNT; i++)
+    {
+        msgSizes[i] = MSG_MIN + (NextRandom() % (MSG_MAX - MSG_MIN + 1));
+        msgOffsets[i] = NextRandom() * 64 % (BULK_SIZE - MSG_MAX);
+        msgTotal += msgSizes[i];
+    }
+}
+
+/***************************************************************************
+*   Function   : BenchMessages
+*   Description: This function times encoding then decoding MSG_COUNT
+*                messages of MSG_MIN to MSG_MAX bytes taken from the test
+*                data.  Every message goes through the same context, which
+*                lives on the stack, so no memory is allocated while timing.
+*   Parameters : codec - Pointer to the codec being tested
+*                set - Pointer to the data set description
+*                data - Test data (BULK_SIZE bytes)
+*                enc - Buffer for encoded data (2 * BULK_SIZE bytes)
+*                dec - Buffer for decoded data (BULK_SIZE bytes)
+*   Effects    : Results are written to stdout
+*   Returned   : 0 for success, 1 for failure.
+***************************************************************************/
+static int BenchMessages(const codec_t *codec, const data_set_t *set,
+    const unsigned char *data, unsigned char *enc, unsigned char *dec)
+{
+    static size_t encSizes[MSG_COUNT];
+    unsigned char arena[2 * SCRATCH_SIZE + 256];
+    rle_context_t *ctx;
+    size_t i, encTotal, len;
+    double start, encTime, decTime;
+    unsigned long reps;
+
+    ctx = RleContextInit(arena, sizeof(arena));
+
+    if (NULL == ctx)
+    {
+        perror("Creating context");
+        return 1;
+    }
+
+    start = Seconds();
+    reps = 0;
+
+    do
+    {
+        encTotal = 0;
+
+        for (i = 0; i < MSG_COUNT; i++)
+        {
+            if (codec->encode(ctx, data + msgOffsets[i], msgSizes[i],
+                enc + encTotal, 2 * MSG_MAX, &encSizes[i]))
+            {
+                perror("Encoding message");
+                return 1;
+            }
+
+            encTotal += encSizes[i];
+        }
+
+        reps++;
+        encTime = Seconds() - start;
+    } while (encTime < MIN_TIME);
+
+    encTime /= reps;
+    start = Seconds();
+    reps = 0;
+
+    do
+    {
+        size_t encPos, decPos;
+
+        encPos = 0;
+        decPos = 0;
+
+        for (i = 0; i < MSG_COUNT; i++)
+        {
+            if (codec->decode(ctx, enc + encPos, encSizes[i], dec + decPos,
+                MSG_MAX, &len) || (len != msgSizes[i]))
+            {
+                perror("Decoding message");
+                return 1;
+            }
+
+            encPos += encSizes[i];
+            decPos += len;
+        }
+
+        reps++;
+        decTime = Seconds() - start;
+    } while (decTime < MIN_TIME);
+
+    decTime /= reps;
+
+    for (i = 0, len = 0; i < MSG_COUNT; len += msgSizes[i], i++)
+    {
+        if (memcmp(data + msgOffsets[i], dec + len, msgSizes[i]))
+        {
+            fprintf(stderr, "%s %s: decoded message doesn't match\n",
+                codec->name, set->name);
+            return 1;
+        }
+    }
+
+    printf("%-10s %-7s %-9s %8.3f %10.1f %10.1f %12.0f\n", codec->name,
+        set->name, "messages", (double)encTotal / msgTotal,
+        msgTotal / encTime / 1e6, msgTotal / decTime / 1e6,
+        MSG_COUNT / encTime);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : BenchBatch
+*   Description: This function times encoding the MSG_COUNT small messages
+*                with one batch call, then verifies each encoded message by
+*                decoding it.
+*   Parameters : codec - Pointer to the codec being tested
+*                set - Pointer to the data set description
+*                data - Test data (BULK_SIZE bytes)
+*                enc - Buffer for encoded data (2 * BULK_SIZE bytes)
+*                dec - Buffer for decoded data (BULK_SIZE bytes)
+*                threads - Number of threads the batch may use
+*   Effects    : Results are written to stdout
+*   Returned   : 0 for success, 1 for failure.
+***************************************************************************/
+static int BenchBatch(const codec_t *codec, const data_set_t *set,
+    const unsigned char *data, unsigned char *enc, unsigned char *dec,
+    unsigned int threads)
+{
+    static rle_message_t messages[MSG_COUNT];
+    static size_t encOffsets[MSG_COUNT];
+    static size_t encSizes[MSG_COUNT];
+    char name[16];
+    size_t i, len;
+    double start, encTime;
+    unsigned long reps;
+
+    for (i = 0; i < MSG_COUNT; i++)
+    {
+        messages[i].data = data + msgOffsets[i];
+        messages[i].length = msgSizes[i];
+    }
+
+    start = Seconds();
+    reps = 0;
+
+    do
+    {
+        if (codec->batch(messages, MSG_COUNT, enc, 2 * BULK_SIZE,
+            encOffsets, encSizes, threads))
+        {
+            perror("Encoding batch");
+            return 1;
+        }
+
+        reps++;
+        encTime = Seconds() - start;
+    } while (encTime < MIN_TIME);
+
+    encTime /= reps;
+
+    for (i = 0; i < MSG_COUNT; i++)
+    {
+        if (codec->decode(NULL, enc + encOffsets[i], encSizes[i], dec,
+            MSG_MAX, &len) || (len != msgSizes[i]) ||
+            memcmp(data + msgOffsets[i], dec, len))
+        {
+            fprintf(stderr, "%s %s: batch message doesn't match\n",
+                codec->name, set->name);
+            return 1;
+        }
+    }
+
+    /* processor time adds up across threads, so this is per thread */
+    sprintf(name, "batch x%u", threads);
+    len = encOffsets[MSG_COUNT - 1] + encSizes[MSG_COUNT - 1];
+    printf("%-10s %-7s %-9s %8.3f %10.1f %10s %12.0f\n", codec->name,
+        set->name, name, (double)len / msgTotal, msgTotal / encTime / 1e6,
+        "-", MSG_COUNT / encTime);
+    return 0;
+}
@@ -0,0 +1,868 @@
+/***************************************************************************
+*             Kernel Microbenchmark for Run Length Encoding Library
+*
+*   File    : kbench.c
+*   Purpose : Time the pieces of the codecs one at a time on controlled
+*             data, so a change in speed can be traced to the scan that
+*             caused it.  Each scan kernel (run scan, pair and triple
+*             search, periodic pattern search) is walked over data with a
+*             fixed run length and literal ratio, at a chosen alignment,
+*             for every kernel set the CPU can run.  The encoders and
+*             decoders are timed on the same data, which separates literal
+*             copying (all literal data) from header parsing (short runs)
+*             and run filling (long runs).  Where Linux allows it,
+*             perf_event_open counts cycles, instructions, branch misses,
+*             and cache misses, and results are reported per byte.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* KBENCH: Kernel Microbenchmark for the Run Length Encoding Library
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if defined(__linux__)
+#define _GNU_SOURCE                     /* for syscall */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "rle.h"
+#include "rlescan.h"
+#include "optlist/optlist.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__NR_perf_event_open)
+#define HAVE_PERF_EVENTS
+#endif
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define DATA_SIZE       (1024UL * 1024) /* size of test data */
+#define ALIGNMENT       64              /* test data starts this aligned */
+#define MIN_TIME        0.1             /* seconds to run each test */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef enum
+{
+    counter_cycles = 0,
+    counter_instructions,
+    counter_branch_misses,
+    counter_cache_misses,
+    NUM_COUNTERS
+} counter_t;
+
+typedef struct
+{
+    const char *name;                   /* description of the data */
+    size_t runLen;                      /* length of each run (0 for none) */
+    size_t period;                      /* symbols in the repeated pattern */
+    size_t litLen;                      /* literals between runs */
+} data_set_t;
+
+typedef struct
+{
+    const scan_kernels_t *kernels;      /* kernels used by scan tests */
+    const unsigned char *data;          /* test data */
+    size_t len;                         /* length of data */
+    unsigned char *enc;                 /* encoded data */
+    size_t encSize;                     /* size of enc */
+    size_t encLen;                      /* length of encoded data */
+    unsigned char *dec;                 /* decoded data (len bytes) */
+} job_t;
+
+/* runs a test once, returning a value that depends on all of the work */
+typedef size_t (*test_fn_t)(job_t *job);
+
+typedef struct
+{
+    const char *name;                   /* name of the test */
+    test_fn_t run;                      /* the test */
+} test_t;
+
+typedef struct
+{
+    double seconds;                     /* processor time */
+    double counts[NUM_COUNTERS];        /* counter values */
+    int valid[NUM_COUNTERS];            /* non-zero if counted */
+} measure_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static void ShowUsage(const char *progName);
+static void MakeData(const data_set_t *set, unsigned char *data,
+    size_t len);
+static unsigned char Literal(unsigned char prev);
+static unsigned long NextRandom(void);
+static double Seconds(void);
+static void OpenCounters(void);
+static void CloseCounters(void);
+static void StartCounters(void);
+static void StopCounters(measure_t *result);
+static void Measure(const test_t *test, job_t *job, measure_t *result);
+static void Report(const char *test, const char *kernels,
+    const char *data, size_t len, const measure_t *result);
+static void PrintPerByte(double value, int valid, int width);
+
+static size_t WalkScanRun(job_t *job);
+static size_t WalkFindPair(job_t *job);
+static size_t WalkFindTriple(job_t *job);
+static size_t WalkFindPeriodic(job_t *job);
+static size_t RleEncodeJob(job_t *job);
+static size_t RleDecodeJob(job_t *job);
+static size_t VPackBitsEncodeJob(job_t *job);
+static size_t VPackBitsDecodeJob(job_t *job);
+
+/***************************************************************************
+*                            GLOBAL VARIABLES
+***************************************************************************/
+static const scan_kernels_t genericKernels =
+{
+    "generic", ScanRunGeneric, FindPairGeneric, FindTripleGeneric,
+    MatchShiftedGeneric, FindPeriodicGeneric
+};
+
+static const test_t scanTests[] =
+{
+    {"scanrun", WalkScanRun},
+    {"findpair", WalkFindPair},
+    {"findtriple", WalkFindTriple},
+    {"periodic", WalkFindPeriodic}
+};
+
+/* encoders must come before their decoders */
+static const test_t codecTests[] =
+{
+    {"rle-enc", RleEncodeJob},
+    {"rle-dec", RleDecodeJob},
+    {"vpb-enc", VPackBitsEncodeJob},
+    {"vpb-dec", VPackBitsDecodeJob}
+};
+
+static const data_set_t dataSets[] =
+{
+    {"literal", 0, 1, 64},
+    {"run4", 4, 1, 0},
+    {"run32", 32, 1, 0},
+    {"run1k", 1024, 1, 0},
+    {"lit25", 24, 1, 8},
+    {"lit75", 8, 1, 24},
+    {"rgb1k", 1024, 3, 0}
+};
+
+static unsigned long randomState = 1;
+
+/* results of the tests, kept so the work isn't optimized away */
+static volatile size_t workDone;
+
+#if defined(HAVE_PERF_EVENTS)
+static const unsigned long counterConfigs[NUM_COUNTERS] =
+{
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_MISSES
+};
+#endif
+
+/* descriptors of the open counters, -1 if a counter isn't available.  the
+ * cycle counter leads the group. */
+static int counterFds[NUM_COUNTERS];
+
+#define NUM_SCAN_TESTS  (sizeof(scanTests) / sizeof(scanTests[0]))
+#define NUM_CODEC_TESTS (sizeof(codecTests) / sizeof(codecTests[0]))
+#define NUM_DATA_SETS   (sizeof(dataSets) / sizeof(dataSets[0]))
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : main
+*   Description: This is the main function for this program.  It builds
+*                each data set and runs every scan test with each kernel
+*                set the CPU can run, then every codec test with the
+*                kernels the library chose.
+*   Parameters : argc - number of parameters
+*                argv - parameter list
+*   Effects    : Benchmark results are written to stdout
+*   Returned   : 0 for success, 1 for failure.
+***************************************************************************/
+int main(int argc, char *argv[])
+{
+    option_t *optList;
+    option_t *thisOpt;
+    const scan_kernels_t *sets[4];
+    const char *only;
+    unsigned char *block;
+    job_t job;
+    measure_t result;
+    size_t numSets, offset, i, j, k;
+
+    only = NULL;
+    offset = 0;
+
+    /* parse command line */
+    optList = GetOptList(argc, argv, "k:a:h?");
+    thisOpt = optList;
+
+    while (thisOpt != NULL)
+    {
+        switch(thisOpt->option)
+        {
+            case 'k':       /* only test one kernel set */
+                only = thisOpt->argument;
+                break;
+
+            case 'a':       /* offset from alignment */
+                offset = (size_t)atoi(thisOpt->argument) % ALIGNMENT;
+                break;
+
+            case 'h':
+            case '?':
+                ShowUsage(argv[0]);
+                FreeOptList(optList);
+                return 0;
+        }
+
+        optList = thisOpt->next;
+        free(thisOpt);
+        thisOpt = optList;
+    }
+
+    /* the kernel sets this CPU can run */
+    numSets = 0;
+    sets[numSets++] = &genericKernels;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+
+    if ((NULL != sse2Kernels.scanRun) && __builtin_cpu_supports("sse2"))
+    {
+        sets[numSets++] = &sse2Kernels;
+    }
+
+    if ((NULL != avx2Kernels.scanRun) && __builtin_cpu_supports("avx2"))
+    {
+        sets[numSets++] = &avx2Kernels;
+    }
+
+    if ((NULL != avx512Kernels.scanRun) &&
+        __builtin_cpu_supports("avx512bw"))
+    {
+        sets[numSets++] = &avx512Kernels;
+    }
+#endif
+
+    block = (unsigned char *)malloc(DATA_SIZE + (2 * ALIGNMENT));
+    job.encSize = (2 * DATA_SIZE) + ALIGNMENT;
+    job.enc = (unsigned char *)malloc(job.encSize);
+    job.dec = (unsigned char *)malloc(DATA_SIZE);
+
+    if ((NULL == block) || (NULL == job.enc) || (NULL == job.dec))
+    {
+        perror("Allocating test data");
+        free(block);
+        free(job.enc);
+        free(job.dec);
+        return 1;
+    }
+
+    /* test data starts offset bytes after an aligned address */
+    job.data = block + ALIGNMENT -
+        ((size_t)block % ALIGNMENT) + offset;
+    job.len = DATA_SIZE;
+
+    OpenCounters();
+    printf("codec kernels: %s, data offset: %u\n",
+        RleKernelVariant(), (unsigned int)offset);
+
+    if (counterFds[counter_cycles] < 0)
+    {
+        printf("performance counters unavailable, only times reported\n");
+    }
+
+    printf("\n%-10s %-8s %-8s %7s %7s %5s %9s %9s %7s\n", "test",
+        "kernels", "data", "cyc/B", "ins/B", "IPC", "brmiss/KB",
+        "cmiss/KB", "ns/B");
+
+    for (i = 0; i < NUM_DATA_SETS; i++)
+    {
+        MakeData(&dataSets[i], (unsigned char *)job.data, job.len);
+
+        for (j = 0; j < numSets; j++)
+        {
+            if ((NULL != only) && strcmp(only, sets[j]->name))
+            {
+                continue;
+            }
+
+            job.kernels = sets[j];
+
+            for (k = 0; k < NUM_SCAN_TESTS; k++)
+            {
+                Measure(&scanTests[k], &job, &result);
+                Report(scanTests[k].name, sets[j]->name, dataSets[i].name,
+                    job.len, &result);
+            }
+        }
+
+        job.kernels = NULL;
+
+        for (k = 0; k < NUM_CODEC_TESTS; k++)
+        {
+            Measure(&codecTests[k], &job, &result);
+
+            if ((0 == (k & 1)) && (0 == job.encLen))
+            {
+                fprintf(stderr, "%s %s: encoding failed\n",
+                    codecTests[k].name, dataSets[i].name);
+                break;
+            }
+
+            if ((1 == (k & 1)) && memcmp(job.data, job.dec, job.len))
+            {
+                fprintf(stderr, "%s %s: decoded data doesn't match\n",
+                    codecTests[k].name, dataSets[i].name);
+                break;
+            }
+
+            Report(codecTests[k].name, RleKernelVariant(),
+                dataSets[i].name, job.len, &result);
+        }
+    }
+
+    CloseCounters();
+    free(block);
+    free(job.enc);
+    free(job.dec);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : ShowUsage
+*   Description: This function sends instructions for using this program to
+*                stdout.
+*   Parameters : progName - the name of the executable version of this
+*                           program.
+*   Effects    : Usage instructions are sent to stdout.
+*   Returned   : None
+***************************************************************************/
+static void ShowUsage(const char *progName)
+{
+    printf("Usage: %s <options>\n\n", FindFileName(progName));
+    printf("options:\n");
+    printf("  -k <kernels> : Only run scan tests with kernels (generic, sse2,"
+        " avx2,\n                 or avx512).\n");
+    printf("  -a <offset> : Start test data offset bytes past a 64 byte"
+        " boundary.\n");
+    printf("  -h | ?  : Print out command line options.\n\n");
+    printf("Set RLE_KERNELS to choose the kernels used by the codec"
+        " tests.\n");
+}
+
+/***************************************************************************
+*   Function   : MakeData
+*   Description: This function fills a buffer with runs of a data set's
+*                length separated by a data set's number of literals.  A
+*                run repeats a random pattern of the data set's period.
+*                Literals never match the symbol before them, so they
+*                never form runs.
+*   Parameters : set - Pointer to the data set description
+*                data - Buffer to fill
+*                len - Size of data
+*   Effects    : data is filled
+*   Returned   : None
+***************************************************************************/
+static void MakeData(const data_set_t *set, unsigned char *data, size_t len)
+{
+    unsigned char pattern[SCAN_MAX_PERIOD];
+    unsigned char prev;
+    size_t i, n;
+
+    randomState = 1;
+    prev = 0;
+    i = 0;
+
+    while (i < len)
+    {
+        for (n = 0; (n < set->litLen) && (i < len); n++, i++)
+        {
+            prev = Literal(prev);
+            data[i] = prev;
+        }
+
+        for (n = 0; n < set->period; n++)
+        {
+            prev = Literal(prev);
+            pattern[n] = prev;
+        }
+
+        for (n = 0; (n < set->runLen) && (i < len); n++, i++)
+        {
+            data[i] = pattern[n % set->period];
+        }
+
+        prev = data[i - 1];
+    }
+}
+
+/***************************************************************************
+*   Function   : Literal
+*   Description: This function returns a random symbol that doesn't match
+*                the symbol before it.
+*   Parameters : prev - The symbol before the new one
+*   Effects    : randomState is advanced
+*   Returned   : A symbol other than prev
+***************************************************************************/
+static unsigned char Literal(unsigned char prev)
+{
+    unsigned char c;
+
+    c = (unsigned char)NextRandom();
+    return (c == prev) ? (unsigned char)(c + 1) : c;
+}
+
+/***************************************************************************
+*   Function   : NextRandom
+*   Description: This function returns the next value of a simple linear
+*                congruential generator, so every run uses the same data.
+*   Parameters : None
+*   Effects    : randomState is advanced
+*   Returned   : A pseudo random value from 0 to 32767
+***************************************************************************/
+static unsigned long NextRandom(void)
+{
+    randomState = (randomState * 1103515245UL + 12345UL) & 0xFFFFFFFFUL;
+    return (randomState >> 16) & 0x7FFF;
+}
+
+/***************************************************************************
+*   Function   : Seconds
+*   Description: This function returns the processor time used so far.
+*   Parameters : None
+*   Effects    : None
+*   Returned   : Processor time in seconds
+***************************************************************************/
+static double Seconds(void)
+{
+    return (double)clock() / CLOCKS_PER_SEC;
+}
+
+/***************************************************************************
+*   Function   : OpenCounters
+*   Description: This function opens a group of hardware counters for this
+*                thread, counting user mode only.  Counters the kernel or
+*                CPU won't provide are left out.  If the cycle counter
+*                can't be opened there are no counters at all.
+*   Parameters : None
+*   Effects    : counterFds is set
+*   Returned   : None
+***************************************************************************/
+static void OpenCounters(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_COUNTERS; i++)
+    {
+        counterFds[i] = -1;
+    }
+
+#if defined(HAVE_PERF_EVENTS)
+    for (i = 0; i < NUM_COUNTERS; i++)
+    {
+        struct perf_event_attr attr;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = counterConfigs[i];
+        attr.disabled = (counter_cycles == i);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP |
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        counterFds[i] = (int)syscall(__NR_perf_event_open, &attr, 0, -1,
+            counterFds[counter_cycles], 0);
+
+        if ((counter_cycles == i) && (counterFds[i] < 0))
+        {
+            break;                      /* no group to join */
+        }
+    }
+#endif
+}
+
+/***************************************************************************
+*   Function   : CloseCounters
+*   Description: This function closes the counters opened by OpenCounters.
+*   Parameters : None
+*   Effects    : The counters are closed
+*   Returned   : None
+***************************************************************************/
+static void CloseCounters(void)
+{
+#if defined(HAVE_PERF_EVENTS)
+    int i;
+
+    for (i = NUM_COUNTERS - 1; i >= 0; i--)
+    {
+        if (counterFds[i] >= 0)
+        {
+            close(counterFds[i]);
+            counterFds[i] = -1;
+        }
+    }
+#endif
+}
+
+/***************************************************************************
+*   Function   : StartCounters
+*   Description: This function zeroes and starts the counter group.
+*   Parameters : None
+*   Effects    : The counters run
+*   Returned   : None
+***************************************************************************/
+static void StartCounters(void)
+{
+#if defined(HAVE_PERF_EVENTS)
+    if (counterFds[counter_cycles] >= 0)
+    {
+        ioctl(counterFds[counter_cycles], PERF_EVENT_IOC_RESET,
+            PERF_IOC_FLAG_GROUP);
+        ioctl(counterFds[counter_cycles], PERF_EVENT_IOC_ENABLE,
+            PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+/***************************************************************************
+*   Function   : StopCounters
+*   Description: This function stops the counter group and reads it.  If
+*                the kernel had to share the counters with other users,
+*                the counts are scaled up to the whole time they were
+*                enabled.
+*   Parameters : result - Set to the counts read
+*   Effects    : The counters stop
+*   Returned   : None
+***************************************************************************/
+static void StopCounters(measure_t *result)
+{
+    int i;
+
+    for (i = 0; i < NUM_COUNTERS; i++)
+    {
+        result->counts[i] = 0;
+        result->valid[i] = 0;
+    }
+
+#if defined(HAVE_PERF_EVENTS)
+    if (counterFds[counter_cycles] >= 0)
+    {
+        __u64 values[3 + NUM_COUNTERS]; /* nr, enabled, running, counts */
+        double scale;
+        int n;
+
+        ioctl(counterFds[counter_cycles], PERF_EVENT_IOC_DISABLE,
+            PERF_IOC_FLAG_GROUP);
+
+        if ((read(counterFds[counter_cycles], values, sizeof(values)) <= 0)
+            || (0 == values[2]))
+        {
+            return;                     /* the group never got to run */
+        }
+
+        scale = (double)values[1] / (double)values[2];
+
+        /* the values are in the order the counters were opened */
+        for (i = 0, n = 0; (i < NUM_COUNTERS) && (n < (int)values[0]); i++)
+        {
+            if (counterFds[i] >= 0)
+            {
+                result->counts[i] = (double)values[3 + n] * scale;
+                result->valid[i] = 1;
+                n++;
+            }
+        }
+    }
+#endif
+}
+
+/***************************************************************************
+*   Function   : Measure
+*   Description: This function runs a test once to warm the caches and
+*                branch predictors, then runs it repeatedly for at least
+*                MIN_TIME seconds with the counters running.
+*   Parameters : test - Pointer to the test
+*                job - Pointer to the data for the test
+*                result - Set to the time and counts per run of the test
+*   Effects    : The test is run
+*   Returned   : None
+***************************************************************************/
+static void Measure(const test_t *test, job_t *job, measure_t *result)
+{
+    unsigned long reps;
+    double start;
+    int i;
+
+    workDone = test->run(job);
+    reps = 0;
+    StartCounters();
+    start = Seconds();
+
+    do
+    {
+        workDone = test->run(job);
+        reps++;
+        result->seconds = Seconds() - start;
+    } while (result->seconds < MIN_TIME);
+
+    StopCounters(result);
+    result->seconds /= reps;
+
+    for (i = 0; i < NUM_COUNTERS; i++)
+    {
+        result->counts[i] /= reps;
+    }
+}
+
+/***************************************************************************
+*   Function   : Report
+*   Description: This function writes a line of results, with the counts
+*                per byte (misses per KB) of test data.
+*   Parameters : test - Name of the test
+*                kernels - Name of the kernels used
+*                data - Name of the data set
+*                len - Bytes of test data
+*                result - Pointer to the results of one run of the test
+*   Effects    : Results are written to stdout
+*   Returned   : None
+***************************************************************************/
+static void Report(const char *test, const char *kernels,
+    const char *data, size_t len, const measure_t *result)
+{
+    const double *counts;
+    const int *valid;
+
+    counts = result->counts;
+    valid = result->valid;
+    printf("%-10s %-8s %-8s", test, kernels, data);
+    PrintPerByte(counts[counter_cycles] / len, valid[counter_cycles], 7);
+    PrintPerByte(counts[counter_instructions] / len,
+        valid[counter_instructions], 7);
+
+    if (valid[counter_cycles] && valid[counter_instructions] &&
+        (counts[counter_cycles] > 0))
+    {
+        printf(" %5.2f",
+            counts[counter_instructions] / counts[counter_cycles]);
+    }
+    else
+    {
+        printf(" %5s", "-");
+    }
+
+    PrintPerByte(counts[counter_branch_misses] * 1024 / len,
+        valid[counter_branch_misses], 9);
+    PrintPerByte(counts[counter_cache_misses] * 1024 / len,
+        valid[counter_cache_misses], 9);
+    PrintPerByte(result->seconds * 1e9 / len, 1, 7);
+    printf("\n");
+}
+
+/***************************************************************************
+*   Function   : PrintPerByte
+*   Description: This function writes one column of results.
+*   Parameters : value - The value to write
+*                valid - Zero if the value wasn't measured
+*                width - Width of the column
+*   Effects    : The value, or - if it's not valid, is written to stdout
+*   Returned   : None
+***************************************************************************/
+static void PrintPerByte(double value, int valid, int width)
+{
+    if (valid)
+    {
+        printf(" %*.3f", width, value);
+    }
+    else
+    {
+        printf(" %*s", width, "-");
+    }
+}
+
+/***************************************************************************
+*   Function   : WalkScanRun, WalkFindPair, WalkFindTriple,
+*                WalkFindPeriodic
+*   Description: These functions step through the test data the way the
+*                encoders do, with one scan kernel.  WalkScanRun measures
+*                every run.  WalkFindPair and WalkFindTriple search for the
+*                start of each run and, like the encoders, skip the run
+*                with ScanRun, so they time literal scanning.
+*                WalkFindPeriodic finds each pattern and measures it with
+*                MatchShifted.
+*   Parameters : job - Pointer to the test data and kernels
+*   Effects    : None
+*   Returned   : Number of steps taken
+***************************************************************************/
+static size_t WalkScanRun(job_t *job)
+{
+    const unsigned char *data;
+    size_t pos, steps;
+
+    data = job->data;
+
+    for (pos = 0, steps = 0; pos < job->len; steps++)
+    {
+        pos += job->kernels->scanRun(data + pos, job->len - pos, data[pos]);
+    }
+
+    return steps;
+}
+
+static size_t WalkFindPair(job_t *job)
+{
+    size_t pos, steps;
+
+    for (pos = 0, steps = 0; pos < job->len; steps++)
+    {
+        pos += job->kernels->findPair(job->data + pos, job->len - pos);
+
+        if (pos < job->len)
+        {
+            pos += job->kernels->scanRun(job->data + pos, job->len - pos,
+                job->data[pos]);
+        }
+    }
+
+    return steps;
+}
+
+static size_t WalkFindTriple(job_t *job)
+{
+    size_t pos, steps;
+
+    for (pos = 0, steps = 0; pos < job->len; steps++)
+    {
+        pos += job->kernels->findTriple(job->data + pos, job->len - pos);
+
+        if (pos < job->len)
+        {
+            pos += job->kernels->scanRun(job->data + pos, job->len - pos,
+                job->data[pos]);
+        }
+    }
+
+    return steps;
+}
+
+static size_t WalkFindPeriodic(job_t *job)
+{
+    size_t pos, steps, period;
+
+    for (pos = 0, steps = 0; pos < job->len; steps++)
+    {
+        pos += job->kernels->findPeriodic(job->data + pos, job->len - pos,
+            &period);
+
+        if (pos < job->len)
+        {
+            pos += period + job->kernels->matchShifted(job->data + pos,
+                job->len - pos, period);
+        }
+    }
+
+    return steps;
+}
+
+/***************************************************************************
+*   Function   : RleEncodeJob, RleDecodeJob, VPackBitsEncodeJob,
+*                VPackBitsDecodeJob
+*   Description: These functions encode the test data into the job's
+*                encoded data buffer, or decode the encoded data into the
+*                job's decoded data buffer, with the in memory routines.
+*   Parameters : job - Pointer to the test data and buffers
+*   Effects    : job->encLen (set to 0 for failure) or job->dec is written
+*   Returned   : Number of bytes written
+***************************************************************************/
+static size_t RleEncodeJob(job_t *job)
+{
+    if (RleEncodeBuffer(NULL, job->data, job->len, job->enc, job->encSize,
+        &job->encLen))
+    {
+        job->encLen = 0;
+    }
+
+    return job->encLen;
+}
+
+static size_t RleDecodeJob(job_t *job)
+{
+    size_t decLen;
+
+    if (RleDecodeBuffer(NULL, job->enc, job->encLen, job->dec, job->len,
+        &decLen))
+    {
+        return 0;
+    }
+
+    return decLen;
+}
+
+static size_t VPackBitsEncodeJob(job_t *job)
+{
+    if (VPackBitsEncodeBuffer(NULL, job->data, job->len, job->enc,
+        job->encSize, &job->encLen))
+    {
+        job->encLen = 0;
+    }
+
+    return job->encLen;
+}
+
+static size_t VPackBitsDecodeJob(job_t *job)
+{
+    size_t decLen;
+
+    if (VPackBitsDecodeBuffer(NULL, job->enc, job->encLen, job->dec,
+        job->len, &decLen))
+    {
+        return 0;
+    }
+
+    return decLen;
+}
@@ -0,0 +1,666 @@
+/***************************************************************************
+*                  PackBits Encoding and Decoding Library
+*
+*   File    : packbits.c
+*   Purpose : Compress and decompress data with standard PackBits, as used
+*             by TIFF (compression 32773), Apple MacPaint and PICT, PSD,
+*             and ILBM.  Each block of data begins with a header byte that
+*             is decoded as follows.
+*
+*             Byte (n)   | Meaning
+*             -----------+-------------------------------------
+*             0 - 127    | Copy the next n + 1 bytes
+*             -127 - -1  | Make -n + 1 copies of the next byte
+*             -128       | No operation (skipped, never written)
+*
+*             TIFF requires each row of an image to be packed separately,
+*             so the encoder can be given a row length, and no block will
+*             cross the end of a row.
+*
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rlecodec.h"
+#include "rlescan.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define MIN_RUN         2               /* shortest run that can be coded */
+#define MAX_RUN         128             /* longest run */
+#define MAX_COPY        128             /* maximum characters to copy */
+#define NO_OP           128             /* header that is skipped */
+
+/* data the encoder holds, and how far ahead it looks to choose a block,
+ * so blocks are chosen the same way however the data is delivered */
+#define WINDOW_SIZE     65536
+#define LOOKAHEAD       (MAX_COPY + 2)
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static size_t EncodeWindow(const unsigned char *data, size_t len,
+    size_t limit, size_t rowBytes, size_t *rowLeft, out_stream_t *out);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : PackBitsEncodeFile
+*   Description: This routine reads an input file and writes out a PackBits
+*                encoded version of it.
+*   Parameters : inFile - Pointer to the file to encode
+*                outFile - Pointer to the file to write encoded output to
+*                rowBytes - Length of each row to pack separately, or 0 to
+*                           pack the data as a whole
+*   Effects    : File is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int PackBitsEncodeFile(FILE *inFile, FILE *outFile, size_t rowBytes)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    /* validate input and output files */
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return PackBitsEncode(&source, &sink, rowBytes);
+}
+
+/***************************************************************************
+*   Function   : PackBitsDecodeFile
+*   Description: This routine decodes a PackBits encoded file to an output
+*                file.
+*   Parameters : inFile - Pointer to the file to decode
+*                outFile - Pointer to the file to write decoded output to
+*   Effects    : Encoded file is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int PackBitsDecodeFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    /* validate input and output files */
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return PackBitsDecode(&source, &sink);
+}
+
+/***************************************************************************
+*   Function   : PackBitsEncode
+*   Description: This routine reads data from a source and writes a
+*                PackBits encoded version of it to a sink.
+*   Parameters : source - Pointer to the source of data to encode
+*                sink - Pointer to the sink receiving the encoded output
+*                rowBytes - Length of each row to pack separately, or 0 to
+*                           pack the data as a whole
+*   Effects    : Data is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int PackBitsEncode(rle_source_t *source, rle_sink_t *sink, size_t rowBytes)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
+
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
+
+    result = PackBitsEncodeStream(&in, &out, rowBytes);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : PackBitsEncodeStream
+*   Description: This routine encodes everything read from an input stream
+*                with PackBits, writing the results to an output stream.
+*                Input is gathered in a window, and blocks are only started
+*                where at least LOOKAHEAD bytes follow (or the data ends).
+*                The rest of the window is kept for next time.  The window
+*                is allocated from the heap to keep the stack small.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*                rowBytes - Length of each row to pack separately, or 0 to
+*                           pack the data as a whole
+*   Effects    : Data is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOMEM if the window can't be
+*                allocated).
+***************************************************************************/
+int PackBitsEncodeStream(in_stream_t *in, out_stream_t *out, size_t rowBytes)
+{
+    unsigned char *window;
+    size_t len, used, rowLeft;
+    int eof;
+    int result;
+
+    window = (unsigned char *)malloc(WINDOW_SIZE);
+
+    if (NULL == window)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    len = 0;
+    rowLeft = rowBytes;
+    result = 0;
+
+    while (!out->error)
+    {
+        size_t got;
+
+        if ((result = InRead(in, window + len, WINDOW_SIZE - len, &got)) < 0)
+        {
+            break;
+        }
+
+        len += got;
+        eof = (len < WINDOW_SIZE);
+        used = EncodeWindow(window, len, eof ? len : (len - LOOKAHEAD),
+            rowBytes, &rowLeft, out);
+
+        if (eof)
+        {
+            break;
+        }
+
+        memmove(window, window + used, len - used);
+        len -= used;
+    }
+
+    free(window);
+
+    if (OutFinish(out) || (result < 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : PackBitsDecode
+*   Description: This routine reads PackBits encoded data from a source and
+*                writes the decoded data to a sink.
+*   Parameters : source - Pointer to the source of encoded data
+*                sink - Pointer to the sink receiving the decoded output
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int PackBitsDecode(rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
+
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
+
+    result = PackBitsDecodeStream(&in, &out);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : PackBitsDecodeStream
+*   Description: This routine decodes PackBits data read from an input
+*                stream, writing the results to an output stream.  Row
+*                boundaries don't need to be known, because no block
+*                crosses one.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (EILSEQ if the data ends part way
+*                through a block).
+***************************************************************************/
+int PackBitsDecodeStream(in_stream_t *in, out_stream_t *out)
+{
+    int result;
+
+    result = 0;
+
+    while (!out->error)
+    {
+        int header;
+
+        if ((result = InEnsure(in, MIN_RUN)) < 0)
+        {
+            break;
+        }
+
+        if (in->next == in->end)
+        {
+            break;                      /* end of data */
+        }
+
+        header = (signed char)*in->next;    /* force sign extension */
+
+        if (header >= 0)
+        {
+            size_t left;
+
+            left = header + 1;
+            in->next++;
+
+            while (left > 0)
+            {
+                size_t k;
+
+                if ((in->next == in->end) && ((result = InFill(in)) <= 0))
+                {
+                    if (0 == result)
+                    {
+                        errno = EILSEQ; /* copy block is too short */
+                        result = -1;
+                    }
+
+                    break;
+                }
+
+                k = in->end - in->next;
+                k = (k < left) ? k : left;
+                OutWrite(out, in->next, k);
+                in->next += k;
+                left -= k;
+            }
+
+            if (result < 0)
+            {
+                break;
+            }
+        }
+        else if (-NO_OP == header)
+        {
+            in->next++;
+        }
+        else
+        {
+            if ((size_t)(in->end - in->next) < MIN_RUN)
+            {
+                errno = EILSEQ;         /* run block is too short */
+                result = -1;
+                break;
+            }
+
+            OutFill(out, in->next[1], 1 - header);
+            in->next += MIN_RUN;
+        }
+    }
+
+    if (OutFinish(out) || (result < 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : PackBitsEncodeBuffer
+*   Description: This routine encodes data held in memory, such as an image
+*                strip, writing the results to memory.  The whole strip is
+*                already in view, so it is encoded where it lies instead of
+*                being copied through a window, and the results are written
+*                straight into out.
+*   Parameters : in - Pointer to the data
+*                inLen - Length of the data
+*                rowBytes - Length of each row to pack separately, or 0 to
+*                           pack the data as a whole
+*                out - Pointer to memory receiving the results
+*                outSize - Size of out (see PackBitsMaxEncodedSize)
+*                outLen - Set to the number of bytes written to out
+*   Effects    : Data is encoded into out
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if out is too small).
+***************************************************************************/
+int PackBitsEncodeBuffer(const unsigned char *in, size_t inLen,
+    size_t rowBytes, unsigned char *out, size_t outSize, size_t *outLen)
+{
+    rle_buffer_t outBuffer;
+    rle_sink_t sink;
+    out_stream_t outStream;
+    size_t rowLeft;
+    int result;
+
+    if (((NULL == in) && (inLen > 0)) || (NULL == out) || (NULL == outLen))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    outBuffer.data = out;
+    outBuffer.size = outSize;
+    outBuffer.pos = 0;
+    RleBufferSink(&sink, &outBuffer);
+    InitOutStream(&outStream, &sink, NULL, 0);
+
+    rowLeft = rowBytes;
+    EncodeWindow(in, inLen, inLen, rowBytes, &rowLeft, &outStream);
+    result = OutFinish(&outStream) ? -1 : 0;
+    *outLen = outBuffer.pos;
+    return result;
+}
+
+/***************************************************************************
+*   Function   : PackBitsDecodeBuffer
+*   Description: This routine decodes PackBits data held in memory, writing
+*                the results to memory.  Memory sources and sinks lend
+*                their memory, so neither the data nor the results are
+*                copied.
+*   Parameters : in - Pointer to the encoded data
+*                inLen - Length of the encoded data
+*                out - Pointer to memory receiving the results
+*                outSize - Size of out
+*                outLen - Set to the number of bytes written to out
+*   Effects    : Data is decoded into out
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if out is too small).
+***************************************************************************/
+int PackBitsDecodeBuffer(const unsigned char *in, size_t inLen,
+    unsigned char *out, size_t outSize, size_t *outLen)
+{
+    rle_buffer_t inBuffer;
+    rle_buffer_t outBuffer;
+    rle_source_t source;
+    rle_sink_t sink;
+    in_stream_t inStream;
+    out_stream_t outStream;
+    int result;
+
+    if (((NULL == in) && (inLen > 0)) || (NULL == out) || (NULL == outLen))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    inBuffer.data = (unsigned char *)in;
+    inBuffer.size = inLen;
+    inBuffer.pos = 0;
+    outBuffer.data = out;
+    outBuffer.size = outSize;
+    outBuffer.pos = 0;
+    RleBufferSource(&source, &inBuffer);
+    RleBufferSink(&sink, &outBuffer);
+    InitInStream(&inStream, &source, NULL, 0);
+    InitOutStream(&outStream, &sink, NULL, 0);
+    result = PackBitsDecodeStream(&inStream, &outStream);
+    *outLen = outBuffer.pos;
+    return result;
+}
+
+/***************************************************************************
+*   Function   : PackBitsMaxEncodedSize
+*   Description: This routine returns the largest possible size of data
+*                encoded by PackBitsEncode.  The worst case is all
+*                literals, which costs one header for every MAX_COPY bytes
+*                of each row.
+*   Parameters : len - Number of bytes being encoded
+*                rowBytes - Row length given to the encoder (0 for none)
+*   Effects    : None
+*   Returned   : Worst case encoded size
+***************************************************************************/
+size_t PackBitsMaxEncodedSize(size_t len, size_t rowBytes)
+{
+    size_t rows, rest;
+
+    if ((0 == rowBytes) || (rowBytes >= len))
+    {
+        return len + (len + MAX_COPY - 1) / MAX_COPY;
+    }
+
+    rows = len / rowBytes;
+    rest = len % rowBytes;
+    return len + (rows * ((rowBytes + MAX_COPY - 1) / MAX_COPY)) +
+        ((rest + MAX_COPY - 1) / MAX_COPY);
+}
+
+/***************************************************************************
+*   Function   : PackBitsInPlaceMargin
+*   Description: This routine returns the number of bytes that a buffer
+*                used by PackBitsDecodeInPlace must have beyond the decoded
+*                length.  It is the most data encoded by PackBitsEncode can
+*                grow, one byte for every MAX_COPY decoded bytes of a row.
+*   Parameters : decodedLen - Length of the decoded data
+*                rowBytes - Row length given to the encoder (0 for none)
+*   Effects    : None
+*   Returned   : Margin that always allows an in place decode
+***************************************************************************/
+size_t PackBitsInPlaceMargin(size_t decodedLen, size_t rowBytes)
+{
+    return PackBitsMaxEncodedSize(decodedLen, rowBytes) - decodedLen;
+}
+
+/***************************************************************************
+*   Function   : PackBitsDecodeInPlace
+*   Description: This routine decodes PackBits data stored at the end of a
+*                buffer, writing the results to the start of the same
+*                buffer, so an image strip can be expanded where it was
+*                read.  Copy blocks are moved down, and a run is only
+*                filled after checking that it ends before the next unread
+*                byte of input.
+*   Parameters : buf - Buffer holding the encoded data in its last
+*                      encodedLen bytes
+*                bufSize - Size of buf.  The decoded length plus
+*                          PackBitsInPlaceMargin is always large enough
+*                          for data written by PackBitsEncode.
+*                encodedLen - Length of the encoded data
+*                outLen - Set to the number of bytes decoded
+*   Effects    : Encoded data is decoded to the start of buf
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if the decoded data would
+*                overwrite unread input, EILSEQ if the data ends part way
+*                through a block).  Failure leaves the contents of buf
+*                undefined.
+***************************************************************************/
+int PackBitsDecodeInPlace(unsigned char *buf, size_t bufSize,
+    size_t encodedLen, size_t *outLen)
+{
+    size_t r;                           /* next encoded byte to read */
+    size_t w;                           /* next decoded byte to write */
+
+    if ((NULL == buf) || (NULL == outLen) || (encodedLen > bufSize))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    r = bufSize - encodedLen;
+    w = 0;
+
+    /* every header is read before its block is written, so copies always
+     * move data down and w never passes r.  runs are checked. */
+    while (r < bufSize)
+    {
+        int header;
+        size_t len;
+
+        header = (signed char)buf[r++];
+
+        if (-NO_OP == header)
+        {
+            continue;
+        }
+
+        if (header < 0)
+        {
+            len = 1 - header;
+
+            if ((r == bufSize) || (len > (r + 1 - w)))
+            {
+                *outLen = w;
+                errno = (r == bufSize) ? EILSEQ : ENOSPC;
+                return -1;
+            }
+
+            memset(buf + w, buf[r], len);
+            w += len;
+            r++;
+        }
+        else
+        {
+            len = header + 1;
+
+            if (len > (bufSize - r))
+            {
+                *outLen = w;
+                errno = EILSEQ;
+                return -1;
+            }
+
+            memmove(buf + w, buf + r, len);
+            w += len;
+            r += len;
+        }
+    }
+
+    *outLen = w;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : EncodeWindow
+*   Description: This routine encodes the start of a window of data a block
+*                at a time.  Runs of MIN_RUN + 1 or more are always written
+*                as run blocks, found with the vector scans.  A run of two
+*                is written as a run block only where it isn't between
+*                literals, since inside a copy block it costs the same two
+*                bytes and doesn't split the block.  Blocks end at the end
+*                of each row.
+*   Parameters : data - Pointer to the window
+*                len - Number of bytes in the window
+*                limit - Blocks are only started before limit
+*                rowBytes - Length of each row, or 0 if there are no rows
+*                rowLeft - Bytes left in the current row, updated
+*                out - Pointer to the output stream
+*   Effects    : Encoded data is written to out
+*   Returned   : Number of bytes of the window encoded (at least limit)
+***************************************************************************/
+static size_t EncodeWindow(const unsigned char *data, size_t len,
+    size_t limit, size_t rowBytes, size_t *rowLeft, out_stream_t *out)
+{
+    size_t pos;
+
+    pos = 0;
+
+    while (pos < limit)
+    {
+        size_t span, run, copy;
+
+        /* bytes this block may cover */
+        span = len - pos;
+
+        if ((0 != rowBytes) && (*rowLeft < span))
+        {
+            span = *rowLeft;
+        }
+
+        run = (span < MAX_RUN) ? span : MAX_RUN;
+        run = 1 + ScanRun(data + pos + 1, run - 1, data[pos]);
+
+        /* the literals that would start here, up to the next triple */
+        copy = (span < LOOKAHEAD) ? span : LOOKAHEAD;
+        copy = FindTriple(data + pos, copy);
+        copy = (copy < MAX_COPY) ? copy : MAX_COPY;
+
+        if ((run > MIN_RUN) || ((MIN_RUN == run) && (copy <= MIN_RUN)))
+        {
+            OUT_PUTC(out, 1 - (int)run);
+            OUT_PUTC(out, data[pos]);
+        }
+        else
+        {
+            run = (0 == copy) ? span : copy;
+            run = (run < MAX_COPY) ? run : MAX_COPY;
+            OUT_PUTC(out, run - 1);
+            OutWrite(out, data + pos, run);
+        }
+
+        pos += run;
+
+        if (0 != rowBytes)
+        {
+            *rowLeft -= run;
+
+            if (0 == *rowLeft)
+            {
+                *rowLeft = rowBytes;
+            }
+        }
+    }
+
+    return pos;
+}
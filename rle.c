@@ -7,13 +7,17 @@
 *             length if the last two symbols are matching.  This method
 *             avoids the need to include run lengths for runs of only 1
 *             symbol.  It also avoids the need for escape characters.
+*
+*             The encoder and decoder process whole chunks of data from an
+*             rle_source_t and keep their state between chunks, so data
+*             may be delivered in any size pieces.
 *   Author  : Michael Dipperstein
 *   Date    : April 30, 2004
 *
 ****************************************************************************
 *
 * RLE: An ANSI C Run Length Encoding/Decoding Routines
-* Copyright (C) 2004, 2007, 2015 by
+* Copyright (C) 2004, 2007, 2015, 2026 by
 *       Michael Dipperstein (mdipperstein@gmail.com)
 *
 * This file is part of the RLE library.
@@ -38,11 +42,36 @@
 ***************************************************************************/
 #include <stdio.h>
 #include <limits.h>
+#include <string.h>
 #include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rlecodec.h"
+#include "rlescan.h"
 
 /***************************************************************************
-*                                CONSTANTS
+*                            TYPE DEFINITIONS
 ***************************************************************************/
+typedef struct
+{
+    int prevChar;                       /* symbol that may start a run */
+    int inRun;                          /* non-zero while counting a run */
+    unsigned int count;                 /* number of symbols after pair */
+} rle_encoder_t;
+
+typedef struct
+{
+    int prevChar;                       /* symbol that may start a run */
+    int needCount;                      /* next byte is a run count */
+} rle_decoder_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static void EncodeChunk(rle_encoder_t *enc, const unsigned char *data,
+    size_t len, out_stream_t *out);
+static void DecodeChunk(rle_decoder_t *dec, const unsigned char *data,
+    size_t len, out_stream_t *out);
 
 /***************************************************************************
 *                                FUNCTIONS
@@ -61,9 +90,8 @@
 ***************************************************************************/
 int RleEncodeFile(FILE *inFile, FILE *outFile)
 {
-    int currChar;                       /* current characters */
-    int prevChar;                       /* previous characters */
-    unsigned char count;                /* number of characters in a run */
+    rle_source_t source;
+    rle_sink_t sink;
 
     /* validate input and output files */
     if ((NULL == inFile) || (NULL == outFile))
@@ -72,62 +100,9 @@ int RleEncodeFile(FILE *inFile, FILE *outFile)
         return -1;
     }
 
-    /* encode inFile */
-    prevChar = EOF;     /* force next char to be different */
-    count = 0;
-
-    /* read input until there's nothing left */
-    while ((currChar = fgetc(inFile)) != EOF)
-    {
-        fputc(currChar, outFile);
-
-        /* check for run */
-        if (currChar == prevChar)
-        {
-            /* we have a run.  count run length */
-            count = 0;
-
-            while ((currChar = fgetc(inFile)) != EOF)
-            {
-                if (currChar == prevChar)
-                {
-                    count++;
-
-                    if (count == UCHAR_MAX)
-                    {
-                        /* count is as long as it can get */
-                        fputc(count, outFile);
-
-                        /* force next char to be different */
-                        prevChar = EOF;
-                        break;
-                    }
-                }
-                else
-                {
-                    /* run ended */
-                    fputc(count, outFile);
-                    fputc(currChar, outFile);
-                    prevChar = currChar;
-                    break;
-                }
-            }
-        }
-        else
-        {
-            /* no run */
-            prevChar = currChar;
-        }
-
-        if (currChar == EOF)
-        {
-            /* run ended because of EOF */
-            fputc(count, outFile);
-            break;
-        }
-    }
-
-    return 0;
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return RleEncode(&source, &sink);
 }
 
 /***************************************************************************
@@ -143,9 +118,8 @@ int RleEncodeFile(FILE *inFile, FILE *outFile)
 ***************************************************************************/
 int RleDecodeFile(FILE *inFile, FILE *outFile)
 {
-    int currChar;                       /* current characters */
-    int prevChar;                       /* previous characters */
-    unsigned char count;                /* number of characters in a run */
+    rle_source_t source;
+    rle_sink_t sink;
 
     /* validate input and output files */
     if ((NULL == inFile) || (NULL == outFile))
@@ -154,33 +128,407 @@ int RleDecodeFile(FILE *inFile, FILE *outFile)
         return -1;
     }
 
-    /* decode inFile */
-    prevChar = EOF;     /* force next char to be different */
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return RleDecode(&source, &sink);
+}
+
+/***************************************************************************
+*   Function   : RleEncode
+*   Description: This routine reads data from a source and writes a run
+*                length encoded version of it to a sink.
+*   Parameters : source - Pointer to the source of data to encode
+*                sink - Pointer to the sink receiving the encoded output
+*   Effects    : Data is encoded using RLE
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleEncode(rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
 
-    /* read input until there's nothing left */
-    while ((currChar = fgetc(inFile)) != EOF)
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
     {
-        fputc(currChar, outFile);
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
 
-        /* check for run */
-        if (currChar == prevChar)
+    result = RleEncodeStream(&in, &out);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : RleEncodeStream
+*   Description: This routine encodes everything read from an input stream
+*                using RLE, writing the results to an output stream.
+*                It does the work for every RleEncode variant, which only
+*                differ in where the stream buffers come from.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*   Effects    : Data is encoded using RLE
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleEncodeStream(in_stream_t *in, out_stream_t *out)
+{
+    rle_encoder_t enc;
+    int result;
+
+    result = 0;
+
+    enc.prevChar = EOF;     /* force next char to be different */
+    enc.inRun = 0;
+    enc.count = 0;
+
+    /* encode chunks until there's nothing left */
+    while (!out->error && ((result = InFill(in)) > 0))
+    {
+        EncodeChunk(&enc, in->next, in->end - in->next, out);
+        in->next = in->end;
+    }
+
+    if (enc.inRun)
+    {
+        /* run ended because of EOF */
+        OUT_PUTC(out, enc.count);
+    }
+
+    if (OutFinish(out) || (result < 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : RleDecode
+*   Description: This routine reads run length encoded data from a source
+*                and writes the decoded data to a sink.
+*   Parameters : source - Pointer to the source of encoded data
+*                sink - Pointer to the sink receiving the decoded output
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleDecode(rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
+
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
+
+    result = RleDecodeStream(&in, &out);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : RleDecodeStream
+*   Description: This routine decodes RLE data read from an input stream,
+*                writing the results to an output stream.
+*                It does the work for every RleDecode variant, which only
+*                differ in where the stream buffers come from.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleDecodeStream(in_stream_t *in, out_stream_t *out)
+{
+    rle_decoder_t dec;
+    int result;
+
+    result = 0;
+
+    dec.prevChar = EOF;     /* force next char to be different */
+    dec.needCount = 0;
+
+    /* decode chunks until there's nothing left */
+    while (!out->error && ((result = InFill(in)) > 0))
+    {
+        DecodeChunk(&dec, in->next, in->end - in->next, out);
+        in->next = in->end;
+    }
+
+    if (OutFinish(out) || (result < 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : RleMaxEncodedSize
+*   Description: This routine returns the largest possible size of data
+*                encoded by RleEncode.  The worst case is back to back
+*                pairs of matching symbols ("aabbcc..."), where every 2
+*                bytes of input become 3.
+*   Parameters : len - Number of bytes being encoded
+*   Effects    : None
+*   Returned   : Worst case encoded size
+***************************************************************************/
+size_t RleMaxEncodedSize(size_t len)
+{
+    return len + (len + 1) / 2;
+}
+
+/***************************************************************************
+*   Function   : RleInPlaceMargin
+*   Description: This routine returns the number of bytes that a buffer
+*                used by RleDecodeInPlace must have beyond the decoded
+*                length.  A decoder working front to back only overwrites
+*                unread input if the encoded data left to read is larger
+*                than the decoded data it becomes, so the margin is the
+*                most any encoded data can grow.  For traditional RLE that
+*                is half of the decoded length, but data with runs rarely
+*                needs all of it.
+*   Parameters : decodedLen - Length of the decoded data
+*   Effects    : None
+*   Returned   : Margin that always allows an in place decode
+***************************************************************************/
+size_t RleInPlaceMargin(size_t decodedLen)
+{
+    return RleMaxEncodedSize(decodedLen) - decodedLen;
+}
+
+/***************************************************************************
+*   Function   : RleDecodeInPlace
+*   Description: This routine decodes RLE data stored at the end of a
+*                buffer, writing the results to the start of the same
+*                buffer.  Literals are moved down a span at a time and
+*                runs are filled, and a run is only filled after checking
+*                that it ends before the next unread byte of input.
+*   Parameters : buf - Buffer holding the encoded data in its last
+*                      encodedLen bytes
+*                bufSize - Size of buf.  The decoded length plus
+*                          RleInPlaceMargin is always large enough.
+*                encodedLen - Length of the encoded data
+*                outLen - Set to the number of bytes decoded
+*   Effects    : Encoded data is decoded to the start of buf
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if the decoded data would
+*                overwrite unread input).  Failure leaves the contents of
+*                buf undefined.
+***************************************************************************/
+int RleDecodeInPlace(unsigned char *buf, size_t bufSize, size_t encodedLen,
+    size_t *outLen)
+{
+    size_t r;                           /* next encoded byte to read */
+    size_t w;                           /* next decoded byte to write */
+    int prevChar;
+
+    if ((NULL == buf) || (NULL == outLen) || (encodedLen > bufSize))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    r = bufSize - encodedLen;
+    w = 0;
+    prevChar = EOF;     /* force next char to be different */
+
+    /* w never passes r, because every byte read writes at most one byte
+     * except for run counts, which are checked */
+    while (r < bufSize)
+    {
+        if (buf[r] == prevChar)
         {
-            /* we have a run.  write it out. */
-            count = fgetc(inFile);
-            while (count > 0)
+            size_t count;
+
+            /* the second symbol of a pair followed by its count */
+            buf[w++] = buf[r++];
+            count = (r < bufSize) ? buf[r++] : 0;
+
+            if (count > (r - w))
             {
-                fputc(currChar, outFile);
-                count--;
+                *outLen = w;
+                errno = ENOSPC;
+                return -1;
             }
 
+            memset(buf + w, prevChar, count);
+            w += count;
             prevChar = EOF;     /* force next char to be different */
         }
         else
         {
-            /* no run */
-            prevChar = currChar;
+            size_t len;
+
+            /* literals up to and including the first symbol of a pair */
+            len = FindPair(buf + r, bufSize - r);
+            len += (len < (bufSize - r)) ? 1 : 0;
+            memmove(buf + w, buf + r, len);
+            w += len;
+            r += len;
+            prevChar = buf[w - 1];
         }
     }
 
+    *outLen = w;
     return 0;
 }
+
+/***************************************************************************
+*   Function   : EncodeChunk
+*   Description: This routine encodes a chunk of data.  Every symbol is
+*                written out as is.  When a symbol matches the one before
+*                it, the number of additional copies that follow the pair
+*                (up to UCHAR_MAX) is written after it.  A run may continue
+*                into the next chunk.
+*   Parameters : enc - Pointer to the encoder state
+*                data - Pointer to the chunk of data
+*                len - Number of bytes in the chunk
+*                out - Pointer to the stream receiving encoded data
+*   Effects    : Encoded data is written to out and enc is updated
+*   Returned   : None
+***************************************************************************/
+static void EncodeChunk(rle_encoder_t *enc, const unsigned char *data,
+    size_t len, out_stream_t *out)
+{
+    const unsigned char *end;
+
+    end = data + len;
+
+    while (data < end)
+    {
+        if (enc->inRun)
+        {
+            size_t limit;
+            size_t k;
+
+            /* we have a run.  count run length */
+            limit = UCHAR_MAX - enc->count;
+
+            if (limit > (size_t)(end - data))
+            {
+                limit = end - data;
+            }
+
+            k = ScanRun(data, limit, (unsigned char)enc->prevChar);
+            enc->count += k;
+            data += k;
+
+            if ((UCHAR_MAX == enc->count) || (data < end))
+            {
+                /* run is as long as it can get or a new symbol ended it */
+                OUT_PUTC(out, enc->count);
+                enc->inRun = 0;
+                enc->prevChar = EOF;    /* force next char to be different */
+            }
+        }
+        else if (*data == enc->prevChar)
+        {
+            /* the pair straddles chunks */
+            OUT_PUTC(out, *data);
+            data++;
+            enc->inRun = 1;
+            enc->count = 0;
+        }
+        else
+        {
+            size_t pair;
+
+            /* no run.  copy symbols through the next pair */
+            pair = FindPair(data, end - data);
+
+            if (pair < (size_t)(end - data))
+            {
+                OutWrite(out, data, pair + 2);
+                enc->prevChar = data[pair];
+                enc->inRun = 1;
+                enc->count = 0;
+                data += pair + 2;
+            }
+            else
+            {
+                OutWrite(out, data, end - data);
+                enc->prevChar = end[-1];
+                data = end;
+            }
+        }
+    }
+}
+
+/***************************************************************************
+*   Function   : DecodeChunk
+*   Description: This routine decodes a chunk of RLE data.  Symbols are
+*                copied until a pair of matching symbols is found, then the
+*                count that follows the pair is expanded.  A pair may be
+*                split from its count by the end of a chunk.
+*   Parameters : dec - Pointer to the decoder state
+*                data - Pointer to the chunk of encoded data
+*                len - Number of bytes in the chunk
+*                out - Pointer to the stream receiving decoded data
+*   Effects    : Decoded data is written to out and dec is updated
+*   Returned   : None
+***************************************************************************/
+static void DecodeChunk(rle_decoder_t *dec, const unsigned char *data,
+    size_t len, out_stream_t *out)
+{
+    const unsigned char *end;
+
+    end = data + len;
+
+    while (data < end)
+    {
+        if (dec->needCount)
+        {
+            /* we have a run.  write it out. */
+            OutFill(out, (unsigned char)dec->prevChar, *data);
+            data++;
+            dec->needCount = 0;
+            dec->prevChar = EOF;    /* force next char to be different */
+        }
+        else if (*data == dec->prevChar)
+        {
+            /* the pair straddles chunks */
+            OUT_PUTC(out, *data);
+            data++;
+            dec->needCount = 1;
+        }
+        else
+        {
+            size_t pair;
+
+            /* no run.  copy symbols through the next pair */
+            pair = FindPair(data, end - data);
+
+            if (pair < (size_t)(end - data))
+            {
+                OutWrite(out, data, pair + 2);
+                dec->prevChar = data[pair];
+                dec->needCount = 1;
+                data += pair + 2;
+            }
+            else
+            {
+                OutWrite(out, data, end - data);
+                dec->prevChar = end[-1];
+                data = end;
+            }
+        }
+    }
+}
@@ -33,16 +33,370 @@
 #ifndef _RLE_H_
 #define _RLE_H_
 
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+
+/* flags for RleBlockEncode */
+#define RLE_BLOCK_PACKBITS  0x01        /* use the packbits variant */
+#define RLE_BLOCK_ENTROPY   0x02        /* entropy code blocks that shrink */
+
+/* operations for RleBitmapOp */
+#define RLE_OP_AND          0           /* a & b */
+#define RLE_OP_OR           1           /* a | b */
+#define RLE_OP_XOR          2           /* a ^ b */
+#define RLE_OP_ANDNOT       3           /* a & ~b */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/***************************************************************************
+* Data sources and sinks.  Every codec reads its input from an rle_source_t
+* and writes its output to an rle_sink_t.  The callbacks move whole chunks
+* of data and return 0 for success or -1 (with errno set) for failure.
+*
+* source read   - copy up to size bytes into buf and set *got to the number
+*                 copied.  *got is 0 at the end of the data.
+* source borrow - optional (may be NULL).  Set *buf to the next chunk of
+*                 data and *got to its size (0 at the end of the data).  The
+*                 chunk must remain valid until the next call.  When present
+*                 it is used instead of read, so no data is copied.
+* sink write    - write size bytes from buf.
+* sink borrow   - optional (may be NULL).  Set *buf to space that output may
+*                 be written to directly and *size to its size (0 if there
+*                 is no space left).
+* sink commit   - required with borrow.  used bytes of the most recently
+*                 borrowed space now hold output.
+***************************************************************************/
+typedef struct
+{
+    void *handle;                       /* passed to the callbacks */
+    int (*read)(void *handle, unsigned char *buf, size_t size, size_t *got);
+    int (*borrow)(void *handle, const unsigned char **buf, size_t *got);
+} rle_source_t;
+
+typedef struct
+{
+    void *handle;                       /* passed to the callbacks */
+    int (*write)(void *handle, const unsigned char *buf, size_t size);
+    int (*borrow)(void *handle, unsigned char **buf, size_t *size);
+    int (*commit)(void *handle, size_t used);
+} rle_sink_t;
+
+/* reusable codec context built in caller supplied memory */
+typedef struct rle_context_t rle_context_t;
+
+/* memory used by the buffer source and sink */
+typedef struct
+{
+    unsigned char *data;                /* start of the memory */
+    size_t size;                        /* size of the memory */
+    size_t pos;                         /* bytes consumed or produced */
+} rle_buffer_t;
+
+/* one message of a batch */
+typedef struct
+{
+    const unsigned char *data;          /* message data */
+    size_t length;                      /* length of message */
+} rle_message_t;
+
+/* lazy decompressing reader with read/seek/tell */
+typedef struct rle_reader_t rle_reader_t;
+
+/* index of packbits variant blocks used for parallel decoding */
+typedef struct rle_index_t rle_index_t;
+
+/* random access reader that may be shared by threads */
+typedef struct rle_shared_t rle_shared_t;
+
+/* file I/O that keeps several blocks in flight */
+typedef struct rle_async_t rle_async_t;
+
+/* run length compressed array held in memory */
+typedef struct rle_array_t rle_array_t;
+
+/* part of an array range that is a single run or literal block */
+typedef struct
+{
+    unsigned long offset;               /* index of the first element */
+    size_t length;                      /* number of elements */
+    const unsigned char *data;          /* literal elements, NULL for a run */
+    unsigned char symbol;               /* value of a run's elements */
+} rle_segment_t;
+
+/* walks a range of an array (fields are private) */
+typedef struct
+{
+    const rle_array_t *array;           /* array being walked */
+    size_t token;                       /* token holding pos */
+    unsigned long tokenStart;           /* index of token's first element */
+    unsigned long literal;              /* pool offset of token's literals */
+    unsigned long pos;                  /* next element to return */
+    unsigned long end;                  /* end of the range */
+} rle_array_iter_t;
+
+/* called with the decoded offset of each match, non-zero stops a search */
+typedef int (*rle_match_t)(unsigned long offset, void *userData);
+
+/* called with each run or literal block, non-zero stops a walk */
+typedef int (*rle_visit_t)(const rle_segment_t *segment, void *userData);
+
+/* summary of decoded data found without decoding it */
+typedef struct
+{
+    unsigned long length;               /* number of decoded bytes */
+    unsigned long sum;                  /* sum of the decoded bytes */
+    int min;                            /* smallest byte, -1 if no data */
+    int max;                            /* largest byte, -1 if no data */
+    unsigned long histogram[256];       /* occurrences of each byte value */
+} rle_stats_t;
+
+/* called with the bytes read and written so far, non-zero cancels */
+typedef int (*rle_progress_t)(unsigned long consumed,
+    unsigned long produced, void *userData);
+
+/* source and sink that report progress, see RleProgressTap */
+typedef struct
+{
+    rle_source_t source;                /* source to give the codec */
+    rle_sink_t sink;                    /* sink to give the codec */
+    rle_source_t *wrappedSource;        /* source being reported on */
+    rle_sink_t *wrappedSink;            /* sink being reported on */
+    rle_progress_t callback;            /* receives the byte counts */
+    void *userData;                     /* passed to callback */
+    unsigned long interval;             /* bytes between callbacks */
+    unsigned long consumed;             /* bytes read from the source */
+    unsigned long produced;             /* bytes written to the sink */
+    unsigned long next;                 /* total at the next callback */
+    int cancelled;                      /* callback asked to cancel */
+    const unsigned char *held;          /* rest of a lent chunk */
+    size_t heldLen;                     /* bytes left in the lent chunk */
+} rle_progress_tap_t;
+
 /***************************************************************************
 *                               PROTOTYPES
 ***************************************************************************/
 
+#if defined __cplusplus
+extern "C"
+{
+#endif
+
+/* sources and sinks for FILE streams and memory buffers */
+void RleFileSource(rle_source_t *source, FILE *file);
+void RleFileSink(rle_sink_t *sink, FILE *file);
+void RleBufferSource(rle_source_t *source, rle_buffer_t *buffer);
+void RleBufferSink(rle_sink_t *sink, rle_buffer_t *buffer);
+
+/* source and sink for files with several blocks in flight (io_uring) */
+rle_async_t *RleAsyncOpen(FILE *file, int writing, size_t bufSize,
+    unsigned int depth);
+void RleAsyncSource(rle_source_t *source, rle_async_t *async);
+void RleAsyncSink(rle_sink_t *sink, rle_async_t *async);
+const char *RleAsyncBackEnd(const rle_async_t *async);
+int RleAsyncClose(rle_async_t *async);
+
+/* report progress of (and cancel) a codec using source and sink */
+void RleProgressTap(rle_progress_tap_t *tap, rle_source_t *source,
+    rle_sink_t *sink, unsigned long interval, rle_progress_t callback,
+    void *userData);
+
+/* the source/sink and FILE codecs need about 1KB of stack.  they allocate
+ * a 64KB I/O buffer from the heap for each source or sink that can't lend
+ * memory, and fail with ENOMEM if they can't.  the Ctx and Buffer routines
+ * never allocate. */
+
 /* traditional RLE encodeing/decoding */
+int RleEncode(rle_source_t *source, rle_sink_t *sink);
+int RleDecode(rle_source_t *source, rle_sink_t *sink);
 int RleEncodeFile(FILE *inFile, FILE *outFile);
 int RleDecodeFile(FILE *inFile, FILE *outFile);
 
 /* variant of packbits RLE encodeing/decoding */
+int VPackBitsEncode(rle_source_t *source, rle_sink_t *sink);
+int VPackBitsDecode(rle_source_t *source, rle_sink_t *sink);
 int VPackBitsEncodeFile(FILE *inFile, FILE *outFile);
 int VPackBitsDecodeFile(FILE *inFile, FILE *outFile);
 
+/* codec contexts for repeated allocation free use by a single thread */
+size_t RleContextSize(size_t bufSize);
+rle_context_t *RleContextInit(void *arena, size_t arenaSize);
+void RleContextReset(rle_context_t *ctx);
+
+int RleEncodeCtx(rle_context_t *ctx, rle_source_t *source, rle_sink_t *sink);
+int RleDecodeCtx(rle_context_t *ctx, rle_source_t *source, rle_sink_t *sink);
+int VPackBitsEncodeCtx(rle_context_t *ctx, rle_source_t *source,
+    rle_sink_t *sink);
+int VPackBitsDecodeCtx(rle_context_t *ctx, rle_source_t *source,
+    rle_sink_t *sink);
+
+/* encode/decode messages held in memory (ctx may be NULL) */
+int RleEncodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen);
+int RleDecodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen);
+int VPackBitsEncodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen);
+int VPackBitsDecodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen);
+
+/* worst case encoded sizes and decoding inside of a single buffer */
+size_t RleMaxEncodedSize(size_t len);
+size_t VPackBitsMaxEncodedSize(size_t len);
+size_t RleInPlaceMargin(size_t decodedLen);
+size_t VPackBitsInPlaceMargin(size_t decodedLen);
+int RleDecodeInPlace(unsigned char *buf, size_t bufSize, size_t encodedLen,
+    size_t *outLen);
+int VPackBitsDecodeInPlace(unsigned char *buf, size_t bufSize,
+    size_t encodedLen, size_t *outLen);
+
+/* encode an array of messages into one arena (threads 0 or 1 = caller) */
+int RleEncodeBatch(const rle_message_t *messages, size_t count,
+    unsigned char *arena, size_t arenaSize, size_t *offsets, size_t *lengths,
+    unsigned int threads);
+int VPackBitsEncodeBatch(const rle_message_t *messages, size_t count,
+    unsigned char *arena, size_t arenaSize, size_t *offsets, size_t *lengths,
+    unsigned int threads);
+
+/* block container with an optional entropy coding stage */
+int RleBlockEncode(rle_source_t *source, rle_sink_t *sink, int flags);
+int RleBlockDecode(rle_source_t *source, rle_sink_t *sink);
+int RleBlockEncodeFile(FILE *inFile, FILE *outFile, int flags);
+int RleBlockDecodeFile(FILE *inFile, FILE *outFile);
+
+/* search encoded data for a pattern without decoding it */
+int RleSearch(rle_source_t *source, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData);
+int VPackBitsSearch(rle_source_t *source, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData);
+int RleSearchFile(FILE *inFile, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData);
+int VPackBitsSearchFile(FILE *inFile, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData);
+
+/* walk and aggregate encoded data as runs and literals */
+int RleVisit(rle_source_t *source, rle_visit_t visit, void *userData);
+int VPackBitsVisit(rle_source_t *source, rle_visit_t visit, void *userData);
+int RleVisitFile(FILE *inFile, rle_visit_t visit, void *userData);
+int VPackBitsVisitFile(FILE *inFile, rle_visit_t visit, void *userData);
+int RleStats(rle_source_t *source, rle_stats_t *stats);
+int VPackBitsStats(rle_source_t *source, rle_stats_t *stats);
+int RleStatsFile(FILE *inFile, rle_stats_t *stats);
+int VPackBitsStatsFile(FILE *inFile, rle_stats_t *stats);
+int RleCountValue(rle_source_t *source, unsigned char value,
+    unsigned long *count);
+int VPackBitsCountValue(rle_source_t *source, unsigned char value,
+    unsigned long *count);
+int RleCountValueFile(FILE *inFile, unsigned char value,
+    unsigned long *count);
+int VPackBitsCountValueFile(FILE *inFile, unsigned char value,
+    unsigned long *count);
+
+/* continue encoding at the end of an encoded file opened for update */
+int RleEncodeAppend(rle_source_t *source, FILE *outFile);
+int VPackBitsEncodeAppend(rle_source_t *source, FILE *outFile);
+int RleEncodeAppendFile(FILE *inFile, FILE *outFile);
+int VPackBitsEncodeAppendFile(FILE *inFile, FILE *outFile);
+
+/* read encoded files as if they were decoded (files must support fseek) */
+rle_reader_t *RleReaderOpen(FILE *inFile);
+rle_reader_t *VPackBitsReaderOpen(FILE *inFile);
+int RleReaderRead(rle_reader_t *reader, void *buf, size_t size, size_t *got);
+int RleReaderSeek(rle_reader_t *reader, long offset, int origin);
+unsigned long RleReaderTell(rle_reader_t *reader);
+void RleReaderClose(rle_reader_t *reader);
+
+/* in memory compressed arrays built from encoded data */
+rle_array_t *RleArrayCreate(rle_source_t *source);
+rle_array_t *VPackBitsArrayCreate(rle_source_t *source);
+rle_array_t *RleArrayCreateFile(FILE *inFile);
+rle_array_t *VPackBitsArrayCreateFile(FILE *inFile);
+void RleArrayFree(rle_array_t *array);
+unsigned long RleArrayLength(const rle_array_t *array);
+int RleArrayGet(const rle_array_t *array, unsigned long index);
+size_t RleArrayRead(const rle_array_t *array, unsigned long start,
+    unsigned char *buf, size_t len);
+void RleArrayIterInit(rle_array_iter_t *iter, const rle_array_t *array,
+    unsigned long start, unsigned long end);
+int RleArrayNext(rle_array_iter_t *iter, rle_segment_t *segment);
+
+/* combine encoded bitmaps without decoding them (op is an RLE_OP_ value) */
+int RleBitmapOp(rle_source_t *a, rle_source_t *b, rle_sink_t *sink, int op);
+int VPackBitsBitmapOp(rle_source_t *a, rle_source_t *b, rle_sink_t *sink,
+    int op);
+int RleBitmapOpFile(FILE *aFile, FILE *bFile, FILE *outFile, int op);
+int VPackBitsBitmapOpFile(FILE *aFile, FILE *bFile, FILE *outFile, int op);
+
+/* convert between the two encodings without decoding */
+int RleToVPackBits(rle_source_t *source, rle_sink_t *sink);
+int VPackBitsToRle(rle_source_t *source, rle_sink_t *sink);
+int RleToVPackBitsFile(FILE *inFile, FILE *outFile);
+int VPackBitsToRleFile(FILE *inFile, FILE *outFile);
+
+/* decode packbits variant data in memory with several threads */
+rle_index_t *VPackBitsIndexBuild(const unsigned char *in, size_t inLen);
+void VPackBitsIndexFree(rle_index_t *index);
+size_t VPackBitsIndexDecodedSize(const rle_index_t *index);
+int VPackBitsIndexSave(const rle_index_t *index, FILE *outFile);
+rle_index_t *VPackBitsIndexLoad(FILE *inFile);
+int VPackBitsDecodeParallel(const unsigned char *in, size_t inLen,
+    unsigned char *out, size_t outSize, size_t *outLen,
+    const rle_index_t *index, unsigned int threads);
+
+/* encode/decode runs of repeating patterns with periods of 1 to 8 bytes.
+ * encoding also allocates a 64KB window from the heap. */
+int RlePatternEncode(rle_source_t *source, rle_sink_t *sink);
+int RlePatternDecode(rle_source_t *source, rle_sink_t *sink);
+int RlePatternEncodeFile(FILE *inFile, FILE *outFile);
+int RlePatternDecodeFile(FILE *inFile, FILE *outFile);
+
+/* standard PackBits (TIFF, Apple) encoding/decoding.  rowBytes > 0 packs
+ * each row of that many bytes separately, as TIFF requires; 0 doesn't.
+ * PackBitsEncode also allocates a 64KB window from the heap, the Buffer
+ * and InPlace routines never allocate. */
+int PackBitsEncode(rle_source_t *source, rle_sink_t *sink, size_t rowBytes);
+int PackBitsDecode(rle_source_t *source, rle_sink_t *sink);
+int PackBitsEncodeFile(FILE *inFile, FILE *outFile, size_t rowBytes);
+int PackBitsDecodeFile(FILE *inFile, FILE *outFile);
+int PackBitsEncodeBuffer(const unsigned char *in, size_t inLen,
+    size_t rowBytes, unsigned char *out, size_t outSize, size_t *outLen);
+int PackBitsDecodeBuffer(const unsigned char *in, size_t inLen,
+    unsigned char *out, size_t outSize, size_t *outLen);
+size_t PackBitsMaxEncodedSize(size_t len, size_t rowBytes);
+
+/* decode a strip stored at the end of the buffer it is decoded into */
+size_t PackBitsInPlaceMargin(size_t decodedLen, size_t rowBytes);
+int PackBitsDecodeInPlace(unsigned char *buf, size_t bufSize,
+    size_t encodedLen, size_t *outLen);
+
+/* read ranges of encoded files from many threads at once */
+rle_shared_t *RleSharedOpen(FILE *inFile, size_t cacheBlocks);
+rle_shared_t *VPackBitsSharedOpen(FILE *inFile, size_t cacheBlocks);
+int RleSharedRead(rle_shared_t *shared, unsigned long offset, void *buf,
+    size_t size, size_t *got);
+unsigned long RleSharedSize(const rle_shared_t *shared);
+void RleSharedClose(rle_shared_t *shared);
+
+/* encode sparse files without reading their holes */
+int RleEncodeSparseFile(FILE *inFile, FILE *outFile);
+int VPackBitsEncodeSparseFile(FILE *inFile, FILE *outFile);
+
+/* decode to sparse files, skipping runs of at least minHole zeros */
+int RleDecodeSparseFile(FILE *inFile, FILE *outFile, size_t minHole);
+int VPackBitsDecodeSparseFile(FILE *inFile, FILE *outFile, size_t minHole);
+
+/* name of the scan kernels chosen for this CPU ("generic", "avx2", ...) */
+const char *RleKernelVariant(void);
+
+#if defined __cplusplus
+}
+#endif
+
 #endif  /* ndef _RLE_H_ */
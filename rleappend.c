@@ -0,0 +1,568 @@
+/***************************************************************************
+*                    Encoded File Appending Routines
+*
+*   File    : rleappend.c
+*   Purpose : Continue encoding at the end of a file written by either the
+*             traditional RLE or the packbits variant encoder.  The last
+*             token of the file is examined to recover the state the
+*             encoder was in when the file was finished, that token is
+*             removed, and its symbols are encoded again ahead of the new
+*             data.  The result is the same as encoding all of the data in
+*             one pass, and only the end of the file is reworked.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include "rle.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define TAIL_SIZE       4096            /* first RLE tail read */
+#define MIN_RUN         3               /* vpackbits minimum run length */
+#define MAX_RUN         130             /* vpackbits maximum run length */
+#define MAX_COPY        128             /* vpackbits maximum copy length */
+
+/* most symbols ever encoded again: an RLE run or two packbits blocks */
+#define MAX_REPLAY      (UCHAR_MAX + 2)
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef int (*encoder_t)(rle_source_t *source, rle_sink_t *sink);
+typedef int (*tail_finder_t)(FILE *file, long start, long end, long *cut,
+    unsigned char *replay, size_t *replayLen);
+
+/* source that reads the removed symbols followed by the new data */
+typedef struct
+{
+    rle_source_t *source;               /* new data */
+    unsigned char replay[MAX_REPLAY];   /* symbols of the removed token */
+    size_t replayLen;                   /* number of removed symbols */
+    size_t replayPos;                   /* removed symbols already read */
+} append_source_t;
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+#if defined(_WIN32)
+#define TRUNCATE_FILE(f, len)   _chsize(_fileno(f), (len))
+#else
+#define TRUNCATE_FILE(f, len)   ftruncate(fileno(f), (off_t)(len))
+#endif
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int Append(rle_source_t *source, FILE *outFile, encoder_t encoder,
+    tail_finder_t findTail);
+static int FindRleTail(FILE *file, long start, long end, long *cut,
+    unsigned char *replay, size_t *replayLen);
+static int FindVPackBitsTail(FILE *file, long start, long end, long *cut,
+    unsigned char *replay, size_t *replayLen);
+static int ReadAt(FILE *file, long offset, unsigned char *buf, size_t len);
+static int AppendRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got);
+static int AppendBorrow(void *handle, const unsigned char **buf,
+    size_t *got);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleEncodeAppend, VPackBitsEncodeAppend
+*   Description: These routines encode data from a source onto the end of
+*                a file encoded by the matching encoder, giving the same
+*                file that encoding all of the data at once would have.
+*                The encoded data runs from the current position of
+*                outFile to its end.
+*   Parameters : source - Pointer to the source of the new data
+*                outFile - Pointer to the encoded file, opened for reading
+*                          and writing (e.g. "r+b")
+*   Effects    : The new data is encoded onto outFile
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (EILSEQ if the file ends with a
+*                truncated packbits block).
+***************************************************************************/
+int RleEncodeAppend(rle_source_t *source, FILE *outFile)
+{
+    return Append(source, outFile, RleEncode, FindRleTail);
+}
+
+int VPackBitsEncodeAppend(rle_source_t *source, FILE *outFile)
+{
+    return Append(source, outFile, VPackBitsEncode, FindVPackBitsTail);
+}
+
+/***************************************************************************
+*   Function   : RleEncodeAppendFile, VPackBitsEncodeAppendFile
+*   Description: These routines are RleEncodeAppend and
+*                VPackBitsEncodeAppend with the new data read from a FILE.
+*   Parameters : inFile - Pointer to the opened file of new data
+*                outFile - Pointer to the encoded file, opened for reading
+*                          and writing
+*   Effects    : The contents of inFile are encoded onto outFile
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Both files remain open.
+***************************************************************************/
+int RleEncodeAppendFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return RleEncodeAppend(&source, outFile);
+}
+
+int VPackBitsEncodeAppendFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return VPackBitsEncodeAppend(&source, outFile);
+}
+
+/***************************************************************************
+*   Function   : Append
+*   Description: This routine finds where the encoded file stops being
+*                final, cuts it there, and encodes the removed symbols
+*                followed by the new data in its place.  The encoders start
+*                in a state that the removed symbols return them to, so the
+*                output matches a single pass.  The file is truncated at
+*                the end of the new output, since encoding the removed
+*                symbols again may take fewer bytes than before.
+*   Parameters : source - Pointer to the source of the new data
+*                outFile - Pointer to the encoded file
+*                encoder - Routine that encodes from a source to a sink
+*                findTail - Routine that finds the cut and removed symbols
+*   Effects    : The new data is encoded onto outFile
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int Append(rle_source_t *source, FILE *outFile, encoder_t encoder,
+    tail_finder_t findTail)
+{
+    append_source_t append;
+    rle_source_t appendSource;
+    rle_sink_t sink;
+    long start, end, cut;
+
+    if ((NULL == source) || (NULL == outFile))
+    {
+        errno = (NULL == outFile) ? ENOENT : EINVAL;
+        return -1;
+    }
+
+    if (((start = ftell(outFile)) < 0) || fseek(outFile, 0, SEEK_END) ||
+        ((end = ftell(outFile)) < 0))
+    {
+        return -1;
+    }
+
+    if (findTail(outFile, start, end, &cut, append.replay,
+        &append.replayLen))
+    {
+        return -1;
+    }
+
+    append.source = source;
+    append.replayPos = 0;
+    appendSource.handle = &append;
+    appendSource.read = AppendRead;
+    appendSource.borrow = (NULL != source->borrow) ? AppendBorrow : NULL;
+    RleFileSink(&sink, outFile);
+
+    if (fseek(outFile, cut, SEEK_SET) || encoder(&appendSource, &sink) ||
+        fflush(outFile) || ((end = ftell(outFile)) < 0))
+    {
+        return -1;
+    }
+
+    return TRUNCATE_FILE(outFile, end) ? -1 : 0;
+}
+
+/***************************************************************************
+*   Function   : FindRleTail
+*   Description: This routine finds the last token of RLE encoded data.
+*                RLE can't be parsed backwards in general, but a symbol
+*                that differs from the two before it can't be a count, and
+*                can't complete a pair, so parsing may start there as if
+*                it were the start of the data.  The tail is searched for
+*                such a symbol, growing the search until one is found or
+*                the start of the data is reached, then parsed forward.
+*                An encoder that ended in a literal is restored by encoding
+*                its last symbol again, one that ended in a run short of
+*                the maximum count by encoding the whole run again.
+*   Parameters : file - Pointer to the encoded file
+*                start - Offset of the encoded data
+*                end - Offset of the end of the file
+*                cut - Set to the offset where encoding resumes
+*                replay - Set to the symbols that must be encoded again
+*                replayLen - Set to the number of symbols in replay
+*   Effects    : The end of file is read
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int FindRleTail(FILE *file, long start, long end, long *cut,
+    unsigned char *replay, size_t *replayLen)
+{
+    unsigned char *buf;
+    size_t size;                        /* bytes of the tail in buf */
+    size_t sync;                        /* where parsing may start */
+    size_t i;
+    int prevChar;
+    int lastKind;                       /* 0 literal, 1 run, 2 bare pair */
+
+    *cut = end;
+    *replayLen = 0;
+
+    if (end <= start)
+    {
+        return 0;                       /* nothing to resume */
+    }
+
+    buf = NULL;
+    size = 0;
+    sync = 0;
+
+    do
+    {
+        unsigned char *grown;
+
+        size = (0 == size) ? TAIL_SIZE : 2 * size;
+
+        if (size > (unsigned long)(end - start))
+        {
+            size = end - start;
+        }
+
+        if (NULL == (grown = (unsigned char *)realloc(buf, size)))
+        {
+            free(buf);
+            return -1;
+        }
+
+        buf = grown;
+
+        if (ReadAt(file, end - (long)size, buf, size))
+        {
+            free(buf);
+            return -1;
+        }
+
+        for (sync = size - 1; sync >= 2; sync--)
+        {
+            if ((buf[sync - 2] != buf[sync - 1]) &&
+                (buf[sync - 1] != buf[sync]))
+            {
+                break;
+            }
+        }
+    } while ((sync < 2) && (size < (unsigned long)(end - start)));
+
+    if (sync < 2)
+    {
+        sync = 0;                       /* parse from the start of data */
+    }
+
+    /* parse forward, noting the kind of the last token */
+    prevChar = EOF;
+    lastKind = 0;
+    i = sync;
+
+    while (i < size)
+    {
+        if (buf[i] == prevChar)
+        {
+            lastKind = (i + 1 < size) ? 1 : 2;
+            i += (1 == lastKind) ? 2 : 1;
+            prevChar = EOF;
+        }
+        else
+        {
+            lastKind = 0;
+            prevChar = buf[i];
+            i++;
+        }
+    }
+
+    if (0 == lastKind)
+    {
+        *cut = end - 1;
+        replay[0] = buf[size - 1];
+        *replayLen = 1;
+    }
+    else if (2 == lastKind)
+    {
+        /* a pair with its count missing, encode it again */
+        *cut = end - 2;
+        replay[0] = replay[1] = buf[size - 1];
+        *replayLen = 2;
+    }
+    else if (buf[size - 1] < UCHAR_MAX)
+    {
+        /* the run could still grow */
+        *cut = end - 3;
+        *replayLen = buf[size - 1] + 2;
+        memset(replay, buf[size - 2], *replayLen);
+    }
+
+    free(buf);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : FindVPackBitsTail
+*   Description: This routine finds the last token of packbits variant
+*                data by hopping from block header to block header.  Only
+*                the headers are examined.  A run short of MAX_RUN, or the
+*                copy blocks written for the symbols the encoder was
+*                holding when the data ended, are removed.  The encoder
+*                writes every full copy block it can before the end, so
+*                it holds at most MAX_COPY + 1 symbols, written as either
+*                one copy block or a full block and a one symbol block.
+*   Parameters : file - Pointer to the encoded file
+*                start - Offset of the encoded data
+*                end - Offset of the end of the file
+*                cut - Set to the offset where encoding resumes
+*                replay - Set to the symbols that must be encoded again
+*                replayLen - Set to the number of symbols in replay
+*   Effects    : The encoded data is read
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int FindVPackBitsTail(FILE *file, long start, long end, long *cut,
+    unsigned char *replay, size_t *replayLen)
+{
+    unsigned char buf[MAX_COPY + MAX_REPLAY];
+    long lastOff, prevOff;              /* offsets of the last two blocks */
+    long offset;                        /* offset of buf[0] */
+    size_t skip;                        /* bytes of a block past buf */
+    size_t got;
+    int header;
+
+    *cut = end;
+    *replayLen = 0;
+    lastOff = -1;
+    prevOff = -1;
+    offset = start;
+    skip = 0;
+
+    if (fseek(file, start, SEEK_SET))
+    {
+        return -1;
+    }
+
+    while ((got = fread(buf, sizeof(unsigned char), sizeof(buf), file)) > 0)
+    {
+        size_t i;
+
+        for (i = skip; i < got; i += (header < 0) ? 2 : header + 2)
+        {
+            header = (signed char)buf[i];
+            prevOff = lastOff;
+            lastOff = offset + (long)i;
+        }
+
+        skip = i - got;
+        offset += (long)got;
+    }
+
+    if (ferror(file))
+    {
+        return -1;
+    }
+
+    if (skip > 0)
+    {
+        errno = EILSEQ;                 /* last block is too short */
+        return -1;
+    }
+
+    if (lastOff < 0)
+    {
+        return 0;                       /* no data */
+    }
+
+    if (ReadAt(file, lastOff, buf, end - lastOff))
+    {
+        return -1;
+    }
+
+    header = (signed char)buf[0];
+
+    if (header < 0)
+    {
+        if ((size_t)((MIN_RUN - 1) - header) < MAX_RUN)
+        {
+            /* the run could still grow */
+            *cut = lastOff;
+            *replayLen = (MIN_RUN - 1) - header;
+            memset(replay, buf[1], *replayLen);
+        }
+
+        return 0;
+    }
+
+    if ((0 == header) && (prevOff >= 0))
+    {
+        /* a one symbol block after a full block holds MAX_COPY + 1 */
+        if (ReadAt(file, prevOff, buf, end - prevOff))
+        {
+            return -1;
+        }
+
+        if ((MAX_COPY - 1) == buf[0])
+        {
+            *cut = prevOff;
+            memcpy(replay, buf + 1, MAX_COPY);
+            replay[MAX_COPY] = buf[MAX_COPY + 2];
+            *replayLen = MAX_COPY + 1;
+            return 0;
+        }
+
+        buf[1] = buf[end - prevOff - 1];   /* symbol of the last block */
+    }
+
+    *cut = lastOff;
+    *replayLen = header + 1;
+    memcpy(replay, buf + 1, *replayLen);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : ReadAt
+*   Description: This routine reads bytes from a given offset of a file.
+*   Parameters : file - Pointer to the file
+*                offset - Offset of the first byte
+*                buf - Buffer receiving the bytes
+*                len - Number of bytes to read
+*   Effects    : The file is read
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int ReadAt(FILE *file, long offset, unsigned char *buf, size_t len)
+{
+    if (fseek(file, offset, SEEK_SET))
+    {
+        return -1;
+    }
+
+    if (fread(buf, sizeof(unsigned char), len, file) != len)
+    {
+        if (!ferror(file))
+        {
+            errno = EIO;                /* file shrank while being read */
+        }
+
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AppendRead
+*   Description: Source read callback that reads the removed symbols, then
+*                the new data.
+*   Parameters : handle - Pointer to the append_source_t
+*                buf - Buffer receiving the data
+*                size - Size of buf
+*                got - Set to the number of bytes read
+*   Effects    : Data is read
+*   Returned   : 0 for success, -1 for failure.
+***************************************************************************/
+static int AppendRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got)
+{
+    append_source_t *append;
+
+    append = (append_source_t *)handle;
+
+    if (append->replayPos < append->replayLen)
+    {
+        *got = append->replayLen - append->replayPos;
+        *got = (*got < size) ? *got : size;
+        memcpy(buf, append->replay + append->replayPos, *got);
+        append->replayPos += *got;
+        return 0;
+    }
+
+    return append->source->read(append->source->handle, buf, size, got);
+}
+
+/***************************************************************************
+*   Function   : AppendBorrow
+*   Description: Source borrow callback that lends the removed symbols,
+*                then whatever the new data's source lends.
+*   Parameters : handle - Pointer to the append_source_t
+*                buf - Set to the lent data
+*                got - Set to the number of bytes lent
+*   Effects    : Data is lent
+*   Returned   : 0 for success, -1 for failure.
+***************************************************************************/
+static int AppendBorrow(void *handle, const unsigned char **buf,
+    size_t *got)
+{
+    append_source_t *append;
+
+    append = (append_source_t *)handle;
+
+    if (append->replayPos < append->replayLen)
+    {
+        *buf = append->replay + append->replayPos;
+        *got = append->replayLen - append->replayPos;
+        append->replayPos = append->replayLen;
+        return 0;
+    }
+
+    return append->source->borrow(append->source->handle, buf, got);
+}
@@ -0,0 +1,661 @@
+/***************************************************************************
+*                    Run Length Compressed Array Library
+*
+*   File    : rlearray.c
+*   Purpose : Hold data encoded by either the traditional RLE or the
+*             packbits variant encoder in memory as a read only array that
+*             can be queried without decoding it.  The encoded data is
+*             kept as a list of small run and literal tokens with the
+*             literal symbols in a separate pool.  A sampled prefix sum of
+*             token lengths locates the token holding any index with a
+*             binary search followed by a short scan.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rletoken.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define SAMPLE_RATE     32              /* tokens between index samples */
+#define MAX_TOKEN       65535           /* longest token length */
+#define MIN_GROWTH      64              /* smallest table allocation */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/* a run of one symbol or a block of literals in the literal pool */
+typedef struct
+{
+    unsigned short length;              /* number of elements */
+    unsigned char symbol;               /* value of a run's elements */
+    unsigned char run;                  /* non-zero for a run */
+} array_token_t;
+
+/* prefix sums at the start of every SAMPLE_RATE tokens */
+typedef struct
+{
+    unsigned long start;                /* index of first element of token */
+    unsigned long literal;              /* pool offset of the next literals */
+} array_sample_t;
+
+struct rle_array_t
+{
+    array_token_t *tokens;              /* tokens in index order */
+    size_t numTokens;                   /* number of tokens */
+    size_t maxTokens;                   /* tokens allocated */
+    array_sample_t *samples;            /* one per SAMPLE_RATE tokens */
+    size_t numSamples;                  /* number of samples */
+    unsigned char *literals;            /* pool of literal elements */
+    size_t numLiterals;                 /* elements in the pool */
+    size_t maxLiterals;                 /* pool space allocated */
+    unsigned long length;               /* number of elements */
+};
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static rle_array_t *CreateArray(rle_source_t *source, format_t format);
+static int AddRun(rle_array_t *array, unsigned char symbol, size_t length);
+static int AddLiterals(rle_array_t *array, const unsigned char *data,
+    size_t length);
+static int AddToken(rle_array_t *array, size_t length, unsigned char symbol,
+    int run);
+static int BuildSamples(rle_array_t *array);
+static void Locate(const rle_array_t *array, unsigned long index,
+    size_t *token, unsigned long *start, unsigned long *literal);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleArrayCreate, VPackBitsArrayCreate
+*   Description: These routines build an array holding the decoded data of
+*                encoded data read from a source.  Runs are never expanded.
+*                Neighboring runs of the same symbol, and neighboring
+*                literal blocks, are joined into single tokens.
+*   Parameters : source - Pointer to the source of encoded data
+*   Effects    : An array is allocated
+*   Returned   : Pointer to the array, or NULL for failure (errno will be
+*                set).
+***************************************************************************/
+rle_array_t *RleArrayCreate(rle_source_t *source)
+{
+    return CreateArray(source, format_rle);
+}
+
+rle_array_t *VPackBitsArrayCreate(rle_source_t *source)
+{
+    return CreateArray(source, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : RleArrayCreateFile, VPackBitsArrayCreateFile
+*   Description: These routines build an array from a file encoded by
+*                RleEncodeFile or VPackBitsEncodeFile.
+*   Parameters : inFile - Pointer to the opened encoded file
+*   Effects    : An array is allocated.  inFile is read to its end.
+*   Returned   : Pointer to the array, or NULL for failure (errno will be
+*                set).  inFile will be left open.
+***************************************************************************/
+rle_array_t *RleArrayCreateFile(FILE *inFile)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    RleFileSource(&source, inFile);
+    return CreateArray(&source, format_rle);
+}
+
+rle_array_t *VPackBitsArrayCreateFile(FILE *inFile)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    RleFileSource(&source, inFile);
+    return CreateArray(&source, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : RleArrayFree
+*   Description: This routine frees an array.
+*   Parameters : array - Pointer to the array (may be NULL)
+*   Effects    : The array is freed
+*   Returned   : None
+***************************************************************************/
+void RleArrayFree(rle_array_t *array)
+{
+    if (NULL != array)
+    {
+        free(array->tokens);
+        free(array->samples);
+        free(array->literals);
+        free(array);
+    }
+}
+
+/***************************************************************************
+*   Function   : RleArrayLength
+*   Description: This routine returns the number of elements in an array.
+*   Parameters : array - Pointer to the array
+*   Effects    : None
+*   Returned   : Number of elements
+***************************************************************************/
+unsigned long RleArrayLength(const rle_array_t *array)
+{
+    return (NULL == array) ? 0 : array->length;
+}
+
+/***************************************************************************
+*   Function   : RleArrayGet
+*   Description: This routine returns one element of an array.
+*   Parameters : array - Pointer to the array
+*                index - Index of the element
+*   Effects    : None
+*   Returned   : The element, or EOF if index is past the end of the array.
+***************************************************************************/
+int RleArrayGet(const rle_array_t *array, unsigned long index)
+{
+    const array_token_t *token;
+    size_t t;
+    unsigned long start, literal;
+
+    if ((NULL == array) || (index >= array->length))
+    {
+        return EOF;
+    }
+
+    Locate(array, index, &t, &start, &literal);
+    token = &array->tokens[t];
+
+    if (token->run)
+    {
+        return token->symbol;
+    }
+
+    return array->literals[literal + (index - start)];
+}
+
+/***************************************************************************
+*   Function   : RleArrayRead
+*   Description: This routine decodes a slice of an array into memory.
+*   Parameters : array - Pointer to the array
+*                start - Index of the first element of the slice
+*                buf - Buffer receiving the elements
+*                len - Number of elements wanted
+*   Effects    : Elements are written to buf
+*   Returned   : The number of elements written, which is less than len
+*                only if the slice runs past the end of the array.
+***************************************************************************/
+size_t RleArrayRead(const rle_array_t *array, unsigned long start,
+    unsigned char *buf, size_t len)
+{
+    rle_array_iter_t iter;
+    rle_segment_t segment;
+    size_t done;
+
+    done = 0;
+    RleArrayIterInit(&iter, array, start, start + len);
+
+    while (RleArrayNext(&iter, &segment))
+    {
+        if (NULL == segment.data)
+        {
+            memset(buf + done, segment.symbol, segment.length);
+        }
+        else
+        {
+            memcpy(buf + done, segment.data, segment.length);
+        }
+
+        done += segment.length;
+    }
+
+    return done;
+}
+
+/***************************************************************************
+*   Function   : RleArrayIterInit
+*   Description: This routine prepares an iterator for walking the runs and
+*                literal blocks of a range of an array.
+*   Parameters : iter - Pointer to the iterator being initialized
+*                array - Pointer to the array
+*                start - Index of the first element of the range
+*                end - Index one past the last element of the range.  It is
+*                      clipped to the end of the array.
+*   Effects    : iter is ready for use by RleArrayNext
+*   Returned   : None
+***************************************************************************/
+void RleArrayIterInit(rle_array_iter_t *iter, const rle_array_t *array,
+    unsigned long start, unsigned long end)
+{
+    iter->array = array;
+    iter->pos = start;
+    iter->end = 0;
+
+    if ((NULL == array) || (start >= array->length) || (end <= start))
+    {
+        return;                         /* empty range */
+    }
+
+    iter->end = (end < array->length) ? end : array->length;
+    Locate(array, start, &iter->token, &iter->tokenStart, &iter->literal);
+}
+
+/***************************************************************************
+*   Function   : RleArrayNext
+*   Description: This routine returns the next part of the iterator's
+*                range that is a single run or literal block.
+*   Parameters : iter - Pointer to an initialized iterator
+*                segment - Pointer to the segment receiving the results.
+*                          Literal data points into the array and remains
+*                          valid until the array is freed.
+*   Effects    : The iterator moves past the segment
+*   Returned   : 1 if a segment was returned, 0 at the end of the range.
+***************************************************************************/
+int RleArrayNext(rle_array_iter_t *iter, rle_segment_t *segment)
+{
+    const array_token_t *token;
+    unsigned long skip;
+    unsigned long left;
+
+    if (iter->pos >= iter->end)
+    {
+        return 0;
+    }
+
+    token = &iter->array->tokens[iter->token];
+    skip = iter->pos - iter->tokenStart;
+    left = token->length - skip;
+
+    segment->offset = iter->pos;
+    segment->length = (left < iter->end - iter->pos) ? left :
+        iter->end - iter->pos;
+    segment->symbol = token->symbol;
+    segment->data = token->run ? NULL :
+        iter->array->literals + iter->literal + skip;
+
+    iter->pos += segment->length;
+
+    if (iter->pos == iter->tokenStart + token->length)
+    {
+        /* step to the next token */
+        iter->tokenStart = iter->pos;
+        iter->literal += token->run ? 0 : token->length;
+        iter->token++;
+    }
+
+    return 1;
+}
+
+/***************************************************************************
+*   Function   : CreateArray
+*   Description: This routine reads the tokens of encoded data into a new
+*                array, then trims its tables and builds its index.
+*   Parameters : source - Pointer to the source of encoded data
+*                format - The encoding used to produce the data
+*   Effects    : An array is allocated
+*   Returned   : Pointer to the array, or NULL for failure.
+***************************************************************************/
+static rle_array_t *CreateArray(rle_source_t *source, format_t format)
+{
+    rle_array_t *array;
+    token_reader_t *reader;
+    token_t token;
+    int result;
+
+    if (NULL == source)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    array = (rle_array_t *)calloc(1, sizeof(rle_array_t));
+    reader = (token_reader_t *)malloc(sizeof(token_reader_t));
+
+    if ((NULL == array) || (NULL == reader))
+    {
+        free(array);
+        free(reader);
+        return NULL;
+    }
+
+    InitTokenReader(reader, source, format);
+
+    while ((result = NextToken(reader, &token)) > 0)
+    {
+        if (token_run == token.kind)
+        {
+            result = AddRun(array, token.symbol, token.length);
+        }
+        else
+        {
+            result = AddLiterals(array, token.data, token.length);
+        }
+
+        if (result)
+        {
+            break;
+        }
+    }
+
+    free(reader);
+
+    if ((result < 0) || BuildSamples(array))
+    {
+        RleArrayFree(array);
+        return NULL;
+    }
+
+    /* give back what the tables didn't need */
+    if (array->numTokens < array->maxTokens)
+    {
+        array_token_t *tokens;
+
+        tokens = (array_token_t *)realloc(array->tokens,
+            (array->numTokens + 1) * sizeof(array_token_t));
+        array->tokens = (NULL == tokens) ? array->tokens : tokens;
+    }
+
+    if (array->numLiterals < array->maxLiterals)
+    {
+        unsigned char *literals;
+
+        literals = (unsigned char *)realloc(array->literals,
+            array->numLiterals + 1);
+        array->literals = (NULL == literals) ? array->literals : literals;
+    }
+
+    return array;
+}
+
+/***************************************************************************
+*   Function   : AddRun
+*   Description: This routine adds a run to the end of an array, extending
+*                the last token if it is a run of the same symbol.
+*   Parameters : array - Pointer to the array
+*                symbol - The symbol of the run
+*                length - Length of the run
+*   Effects    : The run is added to the array
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AddRun(rle_array_t *array, unsigned char symbol, size_t length)
+{
+    array->length += length;
+
+    if (array->numTokens > 0)
+    {
+        array_token_t *last;
+
+        last = &array->tokens[array->numTokens - 1];
+
+        if (last->run && (last->symbol == symbol))
+        {
+            size_t k;
+
+            k = MAX_TOKEN - last->length;
+            k = (k < length) ? k : length;
+            last->length += (unsigned short)k;
+            length -= k;
+        }
+    }
+
+    while (length > 0)
+    {
+        size_t k;
+
+        k = (length < MAX_TOKEN) ? length : MAX_TOKEN;
+
+        if (AddToken(array, k, symbol, 1))
+        {
+            return -1;
+        }
+
+        length -= k;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AddLiterals
+*   Description: This routine adds literal elements to the end of an
+*                array, extending the last token if it is a literal block.
+*   Parameters : array - Pointer to the array
+*                data - The literal elements
+*                length - Number of literal elements
+*   Effects    : The literals are added to the array
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AddLiterals(rle_array_t *array, const unsigned char *data,
+    size_t length)
+{
+    size_t used;
+
+    if (array->numLiterals + length > array->maxLiterals)
+    {
+        unsigned char *literals;
+        size_t size;
+
+        size = 2 * array->maxLiterals + length + MIN_GROWTH;
+        literals = (unsigned char *)realloc(array->literals, size);
+
+        if (NULL == literals)
+        {
+            return -1;
+        }
+
+        array->literals = literals;
+        array->maxLiterals = size;
+    }
+
+    memcpy(array->literals + array->numLiterals, data, length);
+    array->numLiterals += length;
+    array->length += length;
+    used = 0;
+
+    if (array->numTokens > 0)
+    {
+        array_token_t *last;
+
+        last = &array->tokens[array->numTokens - 1];
+
+        if (!last->run)
+        {
+            used = MAX_TOKEN - last->length;
+            used = (used < length) ? used : length;
+            last->length += (unsigned short)used;
+        }
+    }
+
+    while (used < length)
+    {
+        size_t k;
+
+        k = ((length - used) < MAX_TOKEN) ? (length - used) : MAX_TOKEN;
+
+        if (AddToken(array, k, 0, 0))
+        {
+            return -1;
+        }
+
+        used += k;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AddToken
+*   Description: This routine appends a token to an array's token table.
+*   Parameters : array - Pointer to the array
+*                length - Length of the token
+*                symbol - The symbol of a run
+*                run - Non-zero for a run, zero for literals
+*   Effects    : A token is added to the array
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AddToken(rle_array_t *array, size_t length, unsigned char symbol,
+    int run)
+{
+    array_token_t *token;
+
+    if (array->numTokens == array->maxTokens)
+    {
+        size_t size;
+
+        size = 2 * array->maxTokens + MIN_GROWTH;
+        token = (array_token_t *)realloc(array->tokens,
+            size * sizeof(array_token_t));
+
+        if (NULL == token)
+        {
+            return -1;
+        }
+
+        array->tokens = token;
+        array->maxTokens = size;
+    }
+
+    token = &array->tokens[array->numTokens];
+    token->length = (unsigned short)length;
+    token->symbol = symbol;
+    token->run = (unsigned char)(run != 0);
+    array->numTokens++;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : BuildSamples
+*   Description: This routine builds the sampled prefix sums of an array's
+*                token lengths and literal pool offsets.
+*   Parameters : array - Pointer to the array with all of its tokens
+*   Effects    : The array's samples are allocated and filled in
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int BuildSamples(rle_array_t *array)
+{
+    unsigned long start, literal;
+    size_t t;
+
+    array->numSamples = (array->numTokens + SAMPLE_RATE - 1) / SAMPLE_RATE;
+    array->samples = (array_sample_t *)malloc((array->numSamples + 1) *
+        sizeof(array_sample_t));
+
+    if (NULL == array->samples)
+    {
+        return -1;
+    }
+
+    start = 0;
+    literal = 0;
+
+    for (t = 0; t < array->numTokens; t++)
+    {
+        if (0 == (t % SAMPLE_RATE))
+        {
+            array->samples[t / SAMPLE_RATE].start = start;
+            array->samples[t / SAMPLE_RATE].literal = literal;
+        }
+
+        start += array->tokens[t].length;
+        literal += array->tokens[t].run ? 0 : array->tokens[t].length;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : Locate
+*   Description: This routine finds the token holding an element.  A
+*                binary search of the samples finds the last sample at or
+*                before the element, then the sample's tokens are scanned.
+*   Parameters : array - Pointer to the array
+*                index - Index of the element (less than the length)
+*                token - Set to the index of the token
+*                start - Set to the index of the token's first element
+*                literal - Set to the pool offset of the token's literals
+*   Effects    : None
+*   Returned   : None
+***************************************************************************/
+static void Locate(const rle_array_t *array, unsigned long index,
+    size_t *token, unsigned long *start, unsigned long *literal)
+{
+    const array_token_t *t;
+    size_t low, high;
+
+    low = 0;
+    high = array->numSamples;
+
+    while ((high - low) > 1)
+    {
+        size_t mid;
+
+        mid = low + (high - low) / 2;
+
+        if (array->samples[mid].start <= index)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    *start = array->samples[low].start;
+    *literal = array->samples[low].literal;
+    t = &array->tokens[low * SAMPLE_RATE];
+
+    while (*start + t->length <= index)
+    {
+        *start += t->length;
+        *literal += t->run ? 0 : t->length;
+        t++;
+    }
+
+    *token = t - array->tokens;
+}
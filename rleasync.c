@@ -0,0 +1,1022 @@
+/***************************************************************************
+*                  Asynchronous File Source and Sink Library
+*
+*   File    : rleasync.c
+*   Purpose : Provide a source and a sink for files that keep several large
+*             reads or writes in flight, so a fast device isn't left idle
+*             while the codec works on the previous block.  On Linux the
+*             I/O is queued with io_uring, using buffers registered with
+*             the kernel where it allows.  Where io_uring isn't available
+*             (older kernels, or it has been disabled) blocks are read and
+*             written one at a time with pread and pwrite, and files that
+*             can't seek (pipes and terminals) are read and written through
+*             stdio.  Blocks are lent to the codec, so no data is copied.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L         /* for pread and pwrite */
+#endif
+
+#if defined(__linux__)
+#define _GNU_SOURCE                     /* for syscall */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#include <sys/types.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/version.h>
+
+/* plain read and write operations appeared in the 5.6 headers */
+#if defined(__GNUC__) && defined(__NR_io_uring_setup) && \
+    (LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0))
+#include <linux/io_uring.h>
+#define HAVE_IO_URING
+#endif
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define ASYNC_BUF_SIZE  (1024UL * 1024) /* default block size */
+#define ASYNC_DEPTH     4               /* default blocks in flight */
+#define ASYNC_ALIGN     4096            /* alignment of blocks in memory */
+#define MAX_BUF_SIZE    (1UL << 30)     /* largest block io_uring reports */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef enum
+{
+    back_end_stdio = 0,                 /* fread/fwrite, for pipes */
+    back_end_pread = 1,                 /* one pread/pwrite at a time */
+    back_end_uring = 2                  /* io_uring, depth at a time */
+} back_end_t;
+
+typedef struct
+{
+    unsigned char *data;                /* the block's memory */
+    unsigned long offset;               /* file offset of its I/O */
+    size_t len;                         /* bytes to read or write */
+    long result;                        /* bytes moved, or -errno */
+    int pending;                        /* I/O hasn't completed */
+} slot_t;
+
+#if defined(HAVE_IO_URING)
+typedef struct
+{
+    int fd;                             /* the ring, -1 if not set up */
+    unsigned *sqTail;                   /* submission queue */
+    unsigned *sqMask;
+    unsigned *sqArray;
+    struct io_uring_sqe *sqes;
+    unsigned *cqHead;                   /* completion queue */
+    unsigned *cqTail;
+    unsigned *cqMask;
+    struct io_uring_cqe *cqes;
+    void *sqRing;                       /* mapped memory */
+    size_t sqRingSize;
+    void *cqRing;
+    size_t cqRingSize;
+    size_t sqesSize;
+    int fixed;                          /* blocks are registered */
+} ring_t;
+#endif
+
+struct rle_async_t
+{
+    FILE *file;                         /* file being read or written */
+    int fd;                             /* its descriptor */
+    int writing;                        /* non-zero for a sink */
+    back_end_t backEnd;                 /* how I/O is done */
+    size_t bufSize;                     /* size of each block */
+    unsigned int depth;                 /* number of blocks */
+    slot_t *slots;                      /* the blocks */
+    void *memory;                       /* memory holding the blocks */
+    unsigned long next;                 /* offset of the next I/O queued */
+    unsigned long position;             /* offset just past the data lent
+                                           to or committed by the codec */
+    unsigned int current;               /* block lent to the codec next */
+    int lent;                           /* current block is lent */
+    const unsigned char *held;          /* source: rest of the lent block */
+    size_t heldLen;                     /* bytes left in the lent block */
+    int eof;                            /* source: end of file was read */
+    int error;                          /* errno of the first failure */
+#if defined(HAVE_IO_URING)
+    ring_t ring;
+#endif
+};
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+#if defined(_WIN32)
+#define FILE_NO(f)      _fileno(f)
+#else
+#define FILE_NO(f)      fileno(f)
+#endif
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int AsyncRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got);
+static int AsyncLend(void *handle, const unsigned char **buf, size_t *got);
+static int AsyncWrite(void *handle, const unsigned char *buf, size_t size);
+static int AsyncBorrow(void *handle, unsigned char **buf, size_t *size);
+static int AsyncCommit(void *handle, size_t used);
+static int Queue(rle_async_t *async, unsigned int index, size_t len);
+static int Wait(rle_async_t *async, slot_t *slot);
+static long SyncIo(rle_async_t *async, slot_t *slot, size_t done);
+static int Fail(rle_async_t *async, int error);
+
+#if defined(HAVE_IO_URING)
+static int RingInit(rle_async_t *async);
+static void RingFree(rle_async_t *async);
+static int RingQueue(rle_async_t *async, unsigned int index);
+static int RingReap(rle_async_t *async);
+#endif
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleAsyncOpen
+*   Description: This routine prepares asynchronous I/O on an opened file,
+*                starting at the file's current position.  A file opened
+*                for reading immediately starts reading its first depth
+*                blocks.  Use RleAsyncSource or RleAsyncSink to get a
+*                source or sink for the codecs.
+*   Parameters : file - Pointer to the opened file
+*                writing - Non-zero to write file, 0 to read it
+*                bufSize - Size of each block (0 for 1MB)
+*                depth - Number of blocks kept in flight (0 for 4)
+*   Effects    : Memory is allocated and reads may be started
+*   Returned   : Pointer to the new handle, or NULL for failure (errno will
+*                be set).
+***************************************************************************/
+rle_async_t *RleAsyncOpen(FILE *file, int writing, size_t bufSize,
+    unsigned int depth)
+{
+    rle_async_t *async;
+    unsigned char *first;
+    long start;
+    unsigned int i;
+
+    if (NULL == file)
+    {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    bufSize = (0 == bufSize) ? ASYNC_BUF_SIZE : bufSize;
+    bufSize = (bufSize > MAX_BUF_SIZE) ? MAX_BUF_SIZE : bufSize;
+    bufSize = (bufSize + ASYNC_ALIGN - 1) & ~((size_t)ASYNC_ALIGN - 1);
+    depth = (0 == depth) ? ASYNC_DEPTH : depth;
+
+    async = (rle_async_t *)calloc(1, sizeof(rle_async_t));
+
+    if (NULL == async)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    async->file = file;
+    async->fd = FILE_NO(file);
+    async->writing = writing;
+    async->backEnd = back_end_stdio;
+#if defined(HAVE_IO_URING)
+    async->ring.fd = -1;
+#endif
+
+    /* positioned I/O needs a file that can seek */
+    if (writing)
+    {
+        fflush(file);
+    }
+
+    start = ftell(file);
+
+#if !defined(_WIN32)
+    if ((start >= 0) && (lseek(async->fd, 0, SEEK_CUR) >= 0))
+    {
+        async->backEnd = back_end_pread;
+        async->next = (unsigned long)start;
+        async->position = (unsigned long)start;
+    }
+#endif
+
+    if (back_end_stdio == async->backEnd)
+    {
+        depth = 1;                      /* nothing is gained by more */
+    }
+
+    async->bufSize = bufSize;
+    async->depth = depth;
+    async->slots = (slot_t *)calloc(depth, sizeof(slot_t));
+    async->memory = malloc((depth * bufSize) + ASYNC_ALIGN);
+
+    if ((NULL == async->slots) || (NULL == async->memory))
+    {
+        free(async->slots);
+        free(async->memory);
+        free(async);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    first = (unsigned char *)async->memory;
+    first += (ASYNC_ALIGN - ((size_t)first % ASYNC_ALIGN)) %
+        ASYNC_ALIGN;
+
+    for (i = 0; i < depth; i++)
+    {
+        async->slots[i].data = first + (i * bufSize);
+    }
+
+#if defined(HAVE_IO_URING)
+    if ((back_end_pread == async->backEnd) && (0 == RingInit(async)))
+    {
+        async->backEnd = back_end_uring;
+    }
+#endif
+
+    /* start reading ahead */
+    for (i = 0; (i < depth) && !writing; i++)
+    {
+        if (Queue(async, i, bufSize))
+        {
+            RleAsyncClose(async);
+            return NULL;
+        }
+    }
+
+    return async;
+}
+
+/***************************************************************************
+*   Function   : RleAsyncSource, RleAsyncSink
+*   Description: These routines set up a source that reads, or a sink that
+*                writes, the file of an asynchronous I/O handle.  Both lend
+*                their blocks to the codec.
+*   Parameters : source/sink - Pointer to the source or sink being set up
+*                async - Handle from RleAsyncOpen (for reading or writing)
+*   Effects    : source or sink uses async
+*   Returned   : None
+***************************************************************************/
+void RleAsyncSource(rle_source_t *source, rle_async_t *async)
+{
+    source->handle = async;
+    source->read = AsyncRead;
+    source->borrow = AsyncLend;
+}
+
+void RleAsyncSink(rle_sink_t *sink, rle_async_t *async)
+{
+    sink->handle = async;
+    sink->write = AsyncWrite;
+    sink->borrow = AsyncBorrow;
+    sink->commit = AsyncCommit;
+}
+
+/***************************************************************************
+*   Function   : RleAsyncBackEnd
+*   Description: This routine returns the name of the way a handle does its
+*                I/O.
+*   Parameters : async - Handle from RleAsyncOpen
+*   Effects    : None
+*   Returned   : "io_uring", "pread", or "stdio"
+***************************************************************************/
+const char *RleAsyncBackEnd(const rle_async_t *async)
+{
+    switch (async->backEnd)
+    {
+        case back_end_uring:
+            return "io_uring";
+
+        case back_end_pread:
+            return "pread";
+
+        default:
+            return "stdio";
+    }
+}
+
+/***************************************************************************
+*   Function   : RleAsyncClose
+*   Description: This routine waits for I/O in flight to finish and frees
+*                a handle.  A file that can seek is left positioned just
+*                past the data the codec read or wrote.  Writes may fail
+*                after the codec has finished, so the result must be
+*                checked before written data is trusted.
+*   Parameters : async - Handle from RleAsyncOpen
+*   Effects    : Writes are completed and the handle is freed.  The file
+*                is left open.
+*   Returned   : 0 for success, -1 if any I/O failed (errno will be set).
+***************************************************************************/
+int RleAsyncClose(rle_async_t *async)
+{
+    unsigned int i;
+    int error;
+
+    if (NULL == async)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (i = 0; i < async->depth; i++)
+    {
+        /* read ahead errors past the data used don't matter */
+        if (Wait(async, &async->slots[i]) && !async->writing)
+        {
+            async->error = 0;
+        }
+    }
+
+#if defined(HAVE_IO_URING)
+    RingFree(async);
+#endif
+
+    if (back_end_stdio == async->backEnd)
+    {
+        if (async->writing && fflush(async->file) && !async->error)
+        {
+            async->error = (0 != errno) ? errno : EIO;
+        }
+    }
+    else
+    {
+        fseek(async->file, (long)async->position, SEEK_SET);
+    }
+
+    error = async->error;
+    free(async->slots);
+    free(async->memory);
+    free(async);
+
+    if (error)
+    {
+        errno = error;
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AsyncRead
+*   Description: Source read callback.  Data is copied out of the blocks
+*                that AsyncLend would have lent.
+*   Parameters : handle - Pointer to the rle_async_t
+*                buf - Buffer receiving the data
+*                size - Size of buf
+*                got - Set to the number of bytes copied
+*   Effects    : Blocks are consumed and read again
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AsyncRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got)
+{
+    rle_async_t *async;
+    size_t count;
+
+    async = (rle_async_t *)handle;
+    *got = 0;
+
+    while (*got < size)
+    {
+        if ((0 == async->heldLen) &&
+            (AsyncLend(handle, &async->held, &async->heldLen) ||
+            (0 == async->heldLen)))
+        {
+            return async->error ? -1 : 0;
+        }
+
+        count = size - *got;
+        count = (count < async->heldLen) ? count : async->heldLen;
+        memcpy(buf + *got, async->held, count);
+        async->held += count;
+        async->heldLen -= count;
+        *got += count;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AsyncLend
+*   Description: Source borrow callback.  The block lent last time is
+*                queued to read the block after the last one queued, then
+*                the next block in file order is waited for and lent.
+*   Parameters : handle - Pointer to the rle_async_t
+*                buf - Set to the block's data
+*                got - Set to the size of the block (0 at the end)
+*   Effects    : I/O is queued and waited for
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AsyncLend(void *handle, const unsigned char **buf, size_t *got)
+{
+    rle_async_t *async;
+    slot_t *slot;
+
+    async = (rle_async_t *)handle;
+    *got = 0;
+
+    if (async->error)
+    {
+        errno = async->error;
+        return -1;
+    }
+
+    if (async->lent)
+    {
+        async->lent = 0;
+
+        if (!async->eof && Queue(async, async->current, async->bufSize))
+        {
+            return -1;
+        }
+
+        async->current = (async->current + 1) % async->depth;
+    }
+
+    if (async->eof)
+    {
+        return 0;
+    }
+
+    slot = &async->slots[async->current];
+
+    if (Wait(async, slot))
+    {
+        return -1;
+    }
+
+    if ((size_t)slot->result < slot->len)
+    {
+        async->eof = 1;                 /* nothing after this is used */
+    }
+
+    if (slot->result > 0)
+    {
+        *buf = slot->data;
+        *got = (size_t)slot->result;
+        async->position = slot->offset + *got;
+        async->lent = 1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AsyncWrite
+*   Description: Sink write callback.  Data is copied into borrowed blocks
+*                which are committed as they fill.
+*   Parameters : handle - Pointer to the rle_async_t
+*                buf - Data to write
+*                size - Number of bytes to write
+*   Effects    : Writes are queued
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AsyncWrite(void *handle, const unsigned char *buf, size_t size)
+{
+    unsigned char *space;
+    size_t count;
+
+    while (size > 0)
+    {
+        if (AsyncBorrow(handle, &space, &count))
+        {
+            return -1;
+        }
+
+        count = (size < count) ? size : count;
+        memcpy(space, buf, count);
+
+        if (AsyncCommit(handle, count))
+        {
+            return -1;
+        }
+
+        buf += count;
+        size -= count;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AsyncBorrow
+*   Description: Sink borrow callback.  The next block is lent once its
+*                last write has finished.
+*   Parameters : handle - Pointer to the rle_async_t
+*                buf - Set to the block's data
+*                size - Set to the size of the block
+*   Effects    : I/O may be waited for
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AsyncBorrow(void *handle, unsigned char **buf, size_t *size)
+{
+    rle_async_t *async;
+    slot_t *slot;
+
+    async = (rle_async_t *)handle;
+
+    if (async->error)
+    {
+        errno = async->error;
+        return -1;
+    }
+
+    slot = &async->slots[async->current];
+
+    if (Wait(async, slot))
+    {
+        return -1;
+    }
+
+    *buf = slot->data;
+    *size = async->bufSize;
+    async->lent = 1;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : AsyncCommit
+*   Description: Sink commit callback.  A write of the used part of the
+*                lent block is queued.
+*   Parameters : handle - Pointer to the rle_async_t
+*                used - Number of bytes written to the lent block
+*   Effects    : A write is queued
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AsyncCommit(void *handle, size_t used)
+{
+    rle_async_t *async;
+
+    async = (rle_async_t *)handle;
+    async->lent = 0;
+
+    if (0 == used)
+    {
+        return 0;
+    }
+
+    if (Queue(async, async->current, used))
+    {
+        return -1;
+    }
+
+    async->position = async->next;
+    async->current = (async->current + 1) % async->depth;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : Queue
+*   Description: This routine starts a read or write of a block at the
+*                offset following the last one queued.  Without io_uring
+*                the I/O is done before returning.
+*   Parameters : async - Pointer to the handle
+*                index - Index of the block
+*                len - Number of bytes to read or write
+*   Effects    : I/O is started or done
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int Queue(rle_async_t *async, unsigned int index, size_t len)
+{
+    slot_t *slot;
+
+    slot = &async->slots[index];
+    slot->offset = async->next;
+    slot->len = len;
+    slot->result = 0;
+    async->next += len;
+
+#if defined(HAVE_IO_URING)
+    if (back_end_uring == async->backEnd)
+    {
+        return RingQueue(async, index);
+    }
+#endif
+
+    slot->result = SyncIo(async, slot, 0);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : Wait
+*   Description: This routine waits for a block's I/O to complete.  A
+*                short read or write is finished with synchronous I/O, so
+*                a read is only short at the end of the file.  If the
+*                kernel can't do an operation through io_uring the block
+*                is moved synchronously instead.
+*   Parameters : async - Pointer to the handle
+*                slot - Pointer to the block
+*   Effects    : Completions may be reaped and I/O may be done
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int Wait(rle_async_t *async, slot_t *slot)
+{
+#if defined(HAVE_IO_URING)
+    while (slot->pending)
+    {
+        if (RingReap(async))
+        {
+            return Fail(async, errno);
+        }
+    }
+
+    if ((-EINVAL == slot->result) || (-EOPNOTSUPP == slot->result))
+    {
+        slot->result = SyncIo(async, slot, 0);
+    }
+#endif
+
+    if ((slot->result >= 0) && ((size_t)slot->result < slot->len))
+    {
+        slot->result = SyncIo(async, slot, (size_t)slot->result);
+    }
+
+    if (slot->result < 0)
+    {
+        return Fail(async, (int)-slot->result);
+    }
+
+    if (async->writing && ((size_t)slot->result < slot->len))
+    {
+        return Fail(async, EIO);
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : SyncIo
+*   Description: This routine reads or writes the rest of a block with
+*                ordinary I/O, stopping early only at the end of a file.
+*   Parameters : async - Pointer to the handle
+*                slot - Pointer to the block
+*                done - Number of bytes already moved
+*   Effects    : I/O is done
+*   Returned   : Total bytes moved, or -errno for failure.
+***************************************************************************/
+static long SyncIo(rle_async_t *async, slot_t *slot, size_t done)
+{
+    while (done < slot->len)
+    {
+        unsigned char *data;
+        size_t len;
+        long moved;
+
+        data = slot->data + done;
+        len = slot->len - done;
+
+        if (back_end_stdio == async->backEnd)
+        {
+            moved = (long)(async->writing ?
+                fwrite(data, 1, len, async->file) :
+                fread(data, 1, len, async->file));
+
+            if ((0 == moved) && ferror(async->file))
+            {
+                return (0 != errno) ? -errno : -EIO;
+            }
+        }
+        else
+        {
+#if defined(_WIN32)
+            moved = -1;
+            errno = ENOSYS;
+#else
+            off_t offset;
+
+            offset = (off_t)(slot->offset + done);
+            moved = (long)(async->writing ?
+                pwrite(async->fd, data, len, offset) :
+                pread(async->fd, data, len, offset));
+#endif
+
+            if (moved < 0)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+
+                return -errno;
+            }
+        }
+
+        if (0 == moved)
+        {
+            break;                      /* end of file */
+        }
+
+        done += (size_t)moved;
+    }
+
+    return (long)done;
+}
+
+/***************************************************************************
+*   Function   : Fail
+*   Description: This routine records the first failure of a handle.
+*   Parameters : async - Pointer to the handle
+*                error - errno value of the failure
+*   Effects    : async->error and errno are set
+*   Returned   : -1
+***************************************************************************/
+static int Fail(rle_async_t *async, int error)
+{
+    if (0 == async->error)
+    {
+        async->error = error;
+    }
+
+    errno = async->error;
+    return -1;
+}
+
+#if defined(HAVE_IO_URING)
+/***************************************************************************
+*   Function   : RingInit
+*   Description: This routine sets up an io_uring with room for every
+*                block and maps its queues.  The blocks are registered
+*                with the kernel so it doesn't have to map them for every
+*                read or write.  If registration is refused (it counts
+*                against the locked memory limit) plain reads and writes
+*                are used.
+*   Parameters : async - Pointer to the handle
+*   Effects    : async->ring is set up
+*   Returned   : 0 for success, -1 if io_uring can't be used.
+***************************************************************************/
+static int RingInit(rle_async_t *async)
+{
+    struct io_uring_params params;
+    struct iovec *iov;
+    ring_t *ring;
+    unsigned char *sq, *cq;
+    unsigned int i;
+
+    ring = &async->ring;
+    memset(&params, 0, sizeof(params));
+    ring->fd = (int)syscall(__NR_io_uring_setup, async->depth, &params);
+
+    if (ring->fd < 0)
+    {
+        ring->fd = -1;
+        return -1;
+    }
+
+    ring->sqRingSize = params.sq_off.array +
+        (params.sq_entries * sizeof(unsigned));
+    ring->cqRingSize = params.cq_off.cqes +
+        (params.cq_entries * sizeof(struct io_uring_cqe));
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    /* newer kernels map both rings together */
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cqRingSize > ring->sqRingSize)
+        {
+            ring->sqRingSize = ring->cqRingSize;
+        }
+
+        ring->cqRingSize = 0;
+    }
+
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED, ring->fd, (off_t)IORING_OFF_SQ_RING);
+    ring->cqRing = ring->sqRing;
+    ring->sqes = MAP_FAILED;
+
+    if ((MAP_FAILED != ring->sqRing) && (ring->cqRingSize > 0))
+    {
+        ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED, ring->fd, (off_t)IORING_OFF_CQ_RING);
+    }
+
+    if ((MAP_FAILED != ring->sqRing) && (MAP_FAILED != ring->cqRing))
+    {
+        ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqesSize,
+            PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd,
+            (off_t)IORING_OFF_SQES);
+    }
+
+    if (MAP_FAILED == (void *)ring->sqes)
+    {
+        RingFree(async);
+        return -1;
+    }
+
+    sq = (unsigned char *)ring->sqRing;
+    cq = (unsigned char *)ring->cqRing;
+    ring->sqTail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned *)(sq + params.sq_off.array);
+    ring->cqHead = (unsigned *)(cq + params.cq_off.head);
+    ring->cqTail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+    iov = (struct iovec *)malloc(async->depth * sizeof(struct iovec));
+    ring->fixed = 0;
+
+    if (NULL != iov)
+    {
+        for (i = 0; i < async->depth; i++)
+        {
+            iov[i].iov_base = async->slots[i].data;
+            iov[i].iov_len = async->bufSize;
+        }
+
+        ring->fixed = (0 == syscall(__NR_io_uring_register, ring->fd,
+            IORING_REGISTER_BUFFERS, iov, async->depth));
+        free(iov);
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : RingFree
+*   Description: This routine unmaps and closes an io_uring.  Closing it
+*                also unregisters the blocks.
+*   Parameters : async - Pointer to the handle
+*   Effects    : async->ring is released
+*   Returned   : None
+***************************************************************************/
+static void RingFree(rle_async_t *async)
+{
+    ring_t *ring;
+
+    ring = &async->ring;
+
+    if (ring->fd < 0)
+    {
+        return;
+    }
+
+    if ((NULL != ring->sqes) && (MAP_FAILED != (void *)ring->sqes))
+    {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+
+    if ((MAP_FAILED != ring->cqRing) && (ring->cqRing != ring->sqRing))
+    {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+
+    if (MAP_FAILED != ring->sqRing)
+    {
+        munmap(ring->sqRing, ring->sqRingSize);
+    }
+
+    close(ring->fd);
+    ring->fd = -1;
+}
+
+/***************************************************************************
+*   Function   : RingQueue
+*   Description: This routine adds a block's read or write to the
+*                submission queue and submits it.  The queue has an entry
+*                for every block, so it is never full.
+*   Parameters : async - Pointer to the handle
+*                index - Index of the block
+*   Effects    : I/O is submitted
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int RingQueue(rle_async_t *async, unsigned int index)
+{
+    ring_t *ring;
+    slot_t *slot;
+    struct io_uring_sqe *sqe;
+    unsigned tail, entry;
+
+    ring = &async->ring;
+    slot = &async->slots[index];
+    tail = *ring->sqTail;
+    entry = tail & *ring->sqMask;
+    sqe = &ring->sqes[entry];
+
+    memset(sqe, 0, sizeof(*sqe));
+
+    if (ring->fixed)
+    {
+        sqe->opcode = async->writing ? IORING_OP_WRITE_FIXED :
+            IORING_OP_READ_FIXED;
+        sqe->buf_index = (__u16)index;
+    }
+    else
+    {
+        sqe->opcode = async->writing ? IORING_OP_WRITE : IORING_OP_READ;
+    }
+
+    sqe->fd = async->fd;
+    sqe->off = slot->offset;
+    sqe->addr = (unsigned long)slot->data;
+    sqe->len = (__u32)slot->len;
+    sqe->user_data = index;
+    ring->sqArray[entry] = entry;
+    slot->pending = 1;
+
+    /* the entry must be visible before the kernel sees the new tail */
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    while (syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0) < 0)
+    {
+        if (EINTR != errno)
+        {
+            slot->pending = 0;
+            return Fail(async, errno);
+        }
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : RingReap
+*   Description: This routine records the results of completed I/O,
+*                waiting for at least one completion if none are ready.
+*   Parameters : async - Pointer to the handle
+*   Effects    : Blocks are marked complete
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int RingReap(rle_async_t *async)
+{
+    ring_t *ring;
+    unsigned head, tail;
+
+    ring = &async->ring;
+    head = *ring->cqHead;
+    tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+    if (head == tail)
+    {
+        if ((syscall(__NR_io_uring_enter, ring->fd, 0, 1,
+            IORING_ENTER_GETEVENTS, NULL, 0) < 0) && (EINTR != errno))
+        {
+            return -1;
+        }
+
+        tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+    }
+
+    for (; head != tail; head++)
+    {
+        struct io_uring_cqe *cqe;
+        slot_t *slot;
+
+        cqe = &ring->cqes[head & *ring->cqMask];
+        slot = &async->slots[cqe->user_data];
+        slot->result = cqe->res;
+        slot->pending = 0;
+    }
+
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    return 0;
+}
+#endif  /* HAVE_IO_URING */
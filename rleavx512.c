@@ -0,0 +1,276 @@
+/***************************************************************************
+*                     AVX-512 Symbol Scanning Routines
+*
+*   File    : rleavx512.c
+*   Purpose : AVX-512 (F and BW) versions of the symbol scans in rlescan.c.
+*             This file is built with AVX-512 code generation enabled, and
+*             its kernels are only used if the CPU supports AVX-512BW.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stddef.h>
+#include "rlescan.h"
+
+#if defined(__GNUC__) && defined(__AVX512BW__)
+#include <immintrin.h>
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define VECTOR_SIZE 64                  /* symbols compared at once */
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+#define LOAD(p)     _mm512_loadu_si512((const void *)(p))
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static size_t ScanRunAvx512(const unsigned char *data, size_t len,
+    unsigned char c);
+static size_t FindPairAvx512(const unsigned char *data, size_t len);
+static size_t FindTripleAvx512(const unsigned char *data, size_t len);
+static size_t MatchShiftedAvx512(const unsigned char *data, size_t len,
+    size_t shift);
+static size_t FindPeriodicAvx512(const unsigned char *data, size_t len,
+    size_t *period);
+
+/***************************************************************************
+*                            GLOBAL VARIABLES
+***************************************************************************/
+const scan_kernels_t avx512Kernels =
+{
+    "avx512", ScanRunAvx512, FindPairAvx512, FindTripleAvx512,
+    MatchShiftedAvx512, FindPeriodicAvx512
+};
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : ScanRunAvx512
+*   Description: This routine counts the number of symbols at the start of
+*                a block that match a given symbol, comparing VECTOR_SIZE
+*                symbols at a time.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*                c - Symbol being matched
+*   Effects    : None
+*   Returned   : Number of leading symbols equal to c
+***************************************************************************/
+static size_t ScanRunAvx512(const unsigned char *data, size_t len,
+    unsigned char c)
+{
+    __m512i pattern;
+    size_t i;
+
+    pattern = _mm512_set1_epi8((char)c);
+
+    for (i = 0; (i + VECTOR_SIZE) <= len; i += VECTOR_SIZE)
+    {
+        __mmask64 differ;
+
+        differ = _mm512_cmpneq_epi8_mask(LOAD(data + i), pattern);
+
+        if (0 != differ)
+        {
+            return i + __builtin_ctzll(differ);
+        }
+    }
+
+    return i + ScanRunGeneric(data + i, len - i, c);
+}
+
+/***************************************************************************
+*   Function   : FindPairAvx512
+*   Description: This routine finds the first pair of adjacent matching
+*                symbols in a block, comparing each symbol of a vector with
+*                the symbol that follows it.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*   Effects    : None
+*   Returned   : Index of the first symbol of the pair, or len if the block
+*                doesn't contain a pair.
+***************************************************************************/
+static size_t FindPairAvx512(const unsigned char *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; (i + VECTOR_SIZE) < len; i += VECTOR_SIZE)
+    {
+        __mmask64 same;
+
+        same = _mm512_cmpeq_epi8_mask(LOAD(data + i), LOAD(data + i + 1));
+
+        if (0 != same)
+        {
+            return i + __builtin_ctzll(same);
+        }
+    }
+
+    return i + FindPairGeneric(data + i, len - i);
+}
+
+/***************************************************************************
+*   Function   : FindTripleAvx512
+*   Description: This routine finds the first three adjacent matching
+*                symbols in a block, comparing each symbol of a vector with
+*                the two symbols that follow it.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*   Effects    : None
+*   Returned   : Index of the first of the three symbols, or len if the
+*                block doesn't contain three matching symbols.
+***************************************************************************/
+static size_t FindTripleAvx512(const unsigned char *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; (i + VECTOR_SIZE + 1) < len; i += VECTOR_SIZE)
+    {
+        __m512i b;
+        __mmask64 same;
+
+        b = LOAD(data + i + 1);
+        same = _mm512_cmpeq_epi8_mask(LOAD(data + i), b) &
+            _mm512_cmpeq_epi8_mask(b, LOAD(data + i + 2));
+
+        if (0 != same)
+        {
+            return i + __builtin_ctzll(same);
+        }
+    }
+
+    return i + FindTripleGeneric(data + i, len - i);
+}
+
+/***************************************************************************
+*   Function   : MatchShiftedAvx512
+*   Description: This routine counts how many symbols at the start of a
+*                block match the symbols shift places later, comparing
+*                VECTOR_SIZE symbols at a time.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*                shift - Distance between the symbols compared
+*   Effects    : None
+*   Returned   : Number of leading symbols equal to the symbol shift later
+***************************************************************************/
+static size_t MatchShiftedAvx512(const unsigned char *data, size_t len,
+    size_t shift)
+{
+    size_t i;
+
+    for (i = 0; (i + VECTOR_SIZE + shift) <= len; i += VECTOR_SIZE)
+    {
+        __mmask64 differ;
+
+        differ = _mm512_cmpneq_epi8_mask(LOAD(data + i),
+            LOAD(data + i + shift));
+
+        if (0 != differ)
+        {
+            return i + __builtin_ctzll(differ);
+        }
+    }
+
+    return i + MatchShiftedGeneric(data + i, len - i, shift);
+}
+
+/***************************************************************************
+*   Function   : FindPeriodicAvx512
+*   Description: This routine finds the first place in a block where a
+*                short pattern starts repeating.  A vector is compared with
+*                the vectors starting 1 to SCAN_MAX_PERIOD symbols later,
+*                and each comparison mask is ANDed with itself shifted, so
+*                a bit is left wherever SCAN_PERIOD_MATCH symbols repeat.
+*                The last bits of a mask can't be completed, so vectors
+*                overlap by SCAN_PERIOD_MATCH - 1 symbols.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*                period - Set to the period found
+*   Effects    : None
+*   Returned   : Index of the start of the pattern, or len if the block
+*                doesn't contain a repeating pattern.
+***************************************************************************/
+static size_t FindPeriodicAvx512(const unsigned char *data, size_t len,
+    size_t *period)
+{
+    size_t i;
+
+    for (i = 0; (i + VECTOR_SIZE + SCAN_MAX_PERIOD) <= len;
+        i += VECTOR_SIZE - (SCAN_PERIOD_MATCH - 1))
+    {
+        __m512i a;
+        size_t q, best;
+
+        a = LOAD(data + i);
+        best = VECTOR_SIZE;
+
+        for (q = 1; q <= SCAN_MAX_PERIOD; q++)
+        {
+            __mmask64 same, all;
+            size_t k;
+
+            all = _mm512_cmpeq_epi8_mask(a, LOAD(data + i + q));
+            same = all;
+
+            for (k = 1; k < SCAN_PERIOD_MATCH; k++)
+            {
+                same &= all >> k;
+            }
+
+            same &= ~(__mmask64)0 >> (SCAN_PERIOD_MATCH - 1);
+
+            if ((0 != same) && ((size_t)__builtin_ctzll(same) < best))
+            {
+                best = __builtin_ctzll(same);
+                *period = q;
+            }
+        }
+
+        if (best < VECTOR_SIZE)
+        {
+            return i + best;
+        }
+    }
+
+    return i + FindPeriodicGeneric(data + i, len - i, period);
+}
+
+#else
+
+/* not built for this target, the kernels will never be chosen */
+const scan_kernels_t avx512Kernels =
+{
+    "avx512", NULL, NULL, NULL, NULL, NULL
+};
+
+#endif
@@ -0,0 +1,455 @@
+/***************************************************************************
+*                     Batched Message Encoding Library
+*
+*   File    : rlebatch.c
+*   Purpose : Encode an array of small messages with one call.  The encoded
+*             messages are packed into one contiguous arena supplied by the
+*             caller, and a table of offsets and lengths tells where each
+*             one ended up.  A batch may optionally be split across several
+*             threads.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rlecodec.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define MAX_THREADS     64              /* most threads used by one batch */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef int (*stream_codec_t)(in_stream_t *in, out_stream_t *out);
+typedef size_t (*bound_t)(size_t len);
+
+/* a run of consecutive messages encoded by one thread */
+typedef struct
+{
+    stream_codec_t codec;               /* codec used for the messages */
+    const rle_message_t *messages;      /* first message of the group */
+    size_t count;                       /* number of messages in group */
+    unsigned char *out;                 /* where group output starts */
+    size_t outSize;                     /* space available for output */
+    size_t *offsets;                    /* offsets relative to out */
+    size_t *lengths;                    /* encoded message lengths */
+    size_t used;                        /* bytes of output written */
+    int result;                         /* 0 for success, -1 for failure */
+    int error;                          /* errno value for a failure */
+} batch_group_t;
+
+#if defined(_WIN32)
+typedef HANDLE thread_t;
+#else
+typedef pthread_t thread_t;
+#endif
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int EncodeBatch(stream_codec_t codec, bound_t bound,
+    const rle_message_t *messages, size_t count, unsigned char *arena,
+    size_t arenaSize, size_t *offsets, size_t *lengths,
+    unsigned int threads);
+static int EncodeThreaded(stream_codec_t codec, bound_t bound,
+    const rle_message_t *messages, size_t count, unsigned char *arena,
+    size_t *offsets, size_t *lengths, unsigned int threads);
+static void EncodeGroup(batch_group_t *group);
+
+#if defined(_WIN32)
+static DWORD WINAPI GroupThread(LPVOID arg);
+#else
+static void *GroupThread(void *arg);
+#endif
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleEncodeBatch, VPackBitsEncodeBatch
+*   Description: These routines encode an array of messages into one
+*                arena.  The encoded messages are packed back to back in
+*                the order they appear in the array, so the total amount of
+*                the arena used is offsets[count - 1] + lengths[count - 1].
+*
+*                If threads is greater than 1, the messages are split into
+*                up to that many groups of consecutive messages with about
+*                the same number of bytes, and each group is encoded by its
+*                own thread.  Threads encode into separate parts of the
+*                arena that are then packed together, so this is only done
+*                if the arena can hold every message in its largest
+*                possible encoded form.  Otherwise the batch is encoded by
+*                the calling thread.  Either way the output is the same.
+*   Parameters : messages - Array of messages to encode
+*                count - Number of messages
+*                arena - Memory receiving the encoded messages
+*                arenaSize - Size of arena
+*                offsets - Array of count entries set to the offset of each
+*                          encoded message in arena
+*                lengths - Array of count entries set to the length of each
+*                          encoded message
+*                threads - Most threads to use (0 or 1 for the calling
+*                          thread only)
+*   Effects    : Messages are encoded into arena
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if arena is too small).  The
+*                contents of arena, offsets, and lengths are undefined after
+*                a failure.
+***************************************************************************/
+int RleEncodeBatch(const rle_message_t *messages, size_t count,
+    unsigned char *arena, size_t arenaSize, size_t *offsets, size_t *lengths,
+    unsigned int threads)
+{
+    return EncodeBatch(RleEncodeStream, RleMaxEncodedSize, messages, count,
+        arena, arenaSize, offsets, lengths, threads);
+}
+
+int VPackBitsEncodeBatch(const rle_message_t *messages, size_t count,
+    unsigned char *arena, size_t arenaSize, size_t *offsets, size_t *lengths,
+    unsigned int threads)
+{
+    return EncodeBatch(VPackBitsEncodeStream, VPackBitsMaxEncodedSize,
+        messages, count, arena, arenaSize, offsets, lengths, threads);
+}
+
+/***************************************************************************
+*   Function   : EncodeBatch
+*   Description: This routine checks the parameters of a batch, then
+*                encodes it with the calling thread or with several threads.
+*   Parameters : codec - The stream codec used to encode each message
+*                bound - Function returning the largest encoded size of a
+*                        message
+*                messages - Array of messages to encode
+*                count - Number of messages
+*                arena - Memory receiving the encoded messages
+*                arenaSize - Size of arena
+*                offsets - Set to the offset of each encoded message
+*                lengths - Set to the length of each encoded message
+*                threads - Most threads to use
+*   Effects    : Messages are encoded into arena
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int EncodeBatch(stream_codec_t codec, bound_t bound,
+    const rle_message_t *messages, size_t count, unsigned char *arena,
+    size_t arenaSize, size_t *offsets, size_t *lengths,
+    unsigned int threads)
+{
+    batch_group_t group;
+    size_t i, worst;
+
+    if ((NULL == offsets) || (NULL == lengths) ||
+        ((count > 0) && ((NULL == messages) || (NULL == arena))))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (threads > MAX_THREADS)
+    {
+        threads = MAX_THREADS;
+    }
+
+    if (threads > count)
+    {
+        threads = (unsigned int)count;
+    }
+
+    if (threads > 1)
+    {
+        /* threads need room for the worst case before packing */
+        worst = 0;
+
+        for (i = 0; (i < count) && (worst <= arenaSize); i++)
+        {
+            worst += bound(messages[i].length);
+        }
+
+        if (worst <= arenaSize)
+        {
+            return EncodeThreaded(codec, bound, messages, count, arena,
+                offsets, lengths, threads);
+        }
+    }
+
+    group.codec = codec;
+    group.messages = messages;
+    group.count = count;
+    group.out = arena;
+    group.outSize = arenaSize;
+    group.offsets = offsets;
+    group.lengths = lengths;
+    EncodeGroup(&group);
+
+    if (0 != group.result)
+    {
+        errno = group.error;
+    }
+
+    return group.result;
+}
+
+/***************************************************************************
+*   Function   : EncodeThreaded
+*   Description: This routine splits a batch into groups with about the
+*                same number of input bytes and encodes each group with its
+*                own thread.  The calling thread encodes the first group.
+*                Each group gets enough of the arena for its worst case, so
+*                once every group is done the groups are moved down to sit
+*                back to back.  If a thread can't be started, its group is
+*                encoded by the calling thread.
+*   Parameters : codec - The stream codec used to encode each message
+*                bound - Function returning the largest encoded size of a
+*                        message
+*                messages - Array of messages to encode
+*                count - Number of messages
+*                arena - Memory receiving the encoded messages.  It must
+*                        hold the worst case of every message.
+*                offsets - Set to the offset of each encoded message
+*                lengths - Set to the length of each encoded message
+*                threads - Number of groups (2 to count)
+*   Effects    : Messages are encoded into arena
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int EncodeThreaded(stream_codec_t codec, bound_t bound,
+    const rle_message_t *messages, size_t count, unsigned char *arena,
+    size_t *offsets, size_t *lengths, unsigned int threads)
+{
+    batch_group_t groups[MAX_THREADS];
+    thread_t handles[MAX_THREADS];
+    int started[MAX_THREADS];
+    size_t total, share, first, i, pos;
+    unsigned int g, numGroups;
+    int result;
+
+    total = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        total += messages[i].length;
+    }
+
+    share = (total / threads) + 1;
+
+    /* cut the batch into groups of consecutive messages */
+    numGroups = 0;
+    first = 0;
+    pos = 0;
+
+    while (first < count)
+    {
+        batch_group_t *group;
+        size_t bytes;
+
+        group = &groups[numGroups];
+        group->codec = codec;
+        group->messages = messages + first;
+        group->offsets = offsets + first;
+        group->lengths = lengths + first;
+        group->out = arena + pos;
+        group->outSize = 0;
+        group->count = 0;
+        bytes = 0;
+
+        /* the last group takes whatever is left */
+        while ((first < count) &&
+            ((bytes < share) || (numGroups + 1 == threads)))
+        {
+            bytes += messages[first].length;
+            group->outSize += bound(messages[first].length);
+            group->count++;
+            first++;
+        }
+
+        pos += group->outSize;
+        numGroups++;
+    }
+
+    for (g = 1; g < numGroups; g++)
+    {
+#if defined(_WIN32)
+        handles[g] = CreateThread(NULL, 0, GroupThread, &groups[g], 0, NULL);
+        started[g] = (NULL != handles[g]);
+#else
+        started[g] =
+            (0 == pthread_create(&handles[g], NULL, GroupThread, &groups[g]));
+#endif
+    }
+
+    EncodeGroup(&groups[0]);
+
+    for (g = 1; g < numGroups; g++)
+    {
+        if (started[g])
+        {
+#if defined(_WIN32)
+            WaitForSingleObject(handles[g], INFINITE);
+            CloseHandle(handles[g]);
+#else
+            pthread_join(handles[g], NULL);
+#endif
+        }
+        else
+        {
+            EncodeGroup(&groups[g]);
+        }
+    }
+
+    /* pack the groups together and make the offsets relative to arena */
+    result = 0;
+    pos = 0;
+
+    for (g = 0; g < numGroups; g++)
+    {
+        batch_group_t *group;
+
+        group = &groups[g];
+
+        if ((0 != group->result) && (0 == result))
+        {
+            result = -1;
+            errno = group->error;
+        }
+
+        if (0 != result)
+        {
+            continue;
+        }
+
+        if (group->out != arena + pos)
+        {
+            memmove(arena + pos, group->out, group->used);
+        }
+
+        for (i = 0; i < group->count; i++)
+        {
+            group->offsets[i] += pos;
+        }
+
+        pos += group->used;
+    }
+
+    return result;
+}
+
+/***************************************************************************
+*   Function   : EncodeGroup
+*   Description: This routine encodes a group of messages back to back.
+*                Memory sources and sinks lend their memory, so no scratch
+*                buffers are needed and nothing is allocated.
+*   Parameters : group - Pointer to the group to encode
+*   Effects    : Messages are encoded into group->out.  group->used,
+*                group->result, and group->error are set.
+*   Returned   : None
+***************************************************************************/
+static void EncodeGroup(batch_group_t *group)
+{
+    rle_buffer_t inBuffer;
+    rle_buffer_t outBuffer;
+    rle_source_t source;
+    rle_sink_t sink;
+    in_stream_t in;
+    out_stream_t out;
+    size_t i;
+
+    outBuffer.data = group->out;
+    outBuffer.size = group->outSize;
+    outBuffer.pos = 0;
+    RleBufferSource(&source, &inBuffer);
+    RleBufferSink(&sink, &outBuffer);
+    group->result = 0;
+    group->error = 0;
+
+    for (i = 0; i < group->count; i++)
+    {
+        if ((NULL == group->messages[i].data) &&
+            (0 != group->messages[i].length))
+        {
+            group->result = -1;
+            group->error = EINVAL;
+            break;
+        }
+
+        inBuffer.data = (unsigned char *)group->messages[i].data;
+        inBuffer.size = group->messages[i].length;
+        inBuffer.pos = 0;
+        group->offsets[i] = outBuffer.pos;
+
+        InitInStream(&in, &source, NULL, 0);
+        InitOutStream(&out, &sink, NULL, 0);
+
+        if (group->codec(&in, &out))
+        {
+            group->result = -1;
+            group->error = errno;
+            break;
+        }
+
+        group->lengths[i] = outBuffer.pos - group->offsets[i];
+    }
+
+    group->used = outBuffer.pos;
+}
+
+/***************************************************************************
+*   Function   : GroupThread
+*   Description: This routine is the entry point of a thread encoding one
+*                group of a batch.
+*   Parameters : arg - Pointer to the group to encode
+*   Effects    : The group is encoded
+*   Returned   : Nothing useful
+***************************************************************************/
+#if defined(_WIN32)
+static DWORD WINAPI GroupThread(LPVOID arg)
+{
+    EncodeGroup((batch_group_t *)arg);
+    return 0;
+}
+#else
+static void *GroupThread(void *arg)
+{
+    EncodeGroup((batch_group_t *)arg);
+    return NULL;
+}
+#endif
@@ -0,0 +1,389 @@
+/***************************************************************************
+*               Boolean Operations on Run Length Encoded Bitmaps
+*
+*   File    : rlebitmap.c
+*   Purpose : Combine two bitmaps encoded by the traditional RLE or the
+*             packbits variant encoder with AND, OR, XOR, or AND NOT
+*             without decoding either of them.  The inputs are walked as
+*             streams of runs and literal blocks, and the result is encoded
+*             a token at a time, so two overlapping runs cost the same no
+*             matter how long they are.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "rle.h"
+#include "rletoken.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define SPAN_SIZE   4096                /* most literals combined at once */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/* one input bitmap.  once its data ends it reads as an endless run of 0 */
+typedef struct
+{
+    token_reader_t reader;              /* tokens of the encoded bitmap */
+    token_t token;                      /* unused part of current token */
+    int done;                           /* no more encoded data */
+} operand_t;
+
+typedef struct
+{
+    operand_t a;
+    operand_t b;
+    token_writer_t writer;
+    unsigned char span[SPAN_SIZE];      /* combined literals */
+} bitmap_op_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int BitmapOp(rle_source_t *a, rle_source_t *b, rle_sink_t *sink,
+    int op, format_t format);
+static int Refill(operand_t *operand);
+static void Consume(operand_t *operand, size_t len);
+static unsigned char Combine(int op, unsigned char x, unsigned char y);
+static void CombineSpan(int op, const token_t *x, const token_t *y,
+    unsigned char *span, size_t len);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleBitmapOpFile
+*   Description: This routine combines two bitmaps encoded by
+*                RleEncodeFile, writing the encoded result to a file.
+*   Parameters : aFile - Pointer to the first encoded bitmap
+*                bFile - Pointer to the second encoded bitmap
+*                outFile - Pointer to the file receiving the encoded result
+*                op - RLE_OP_AND, RLE_OP_OR, RLE_OP_XOR, or RLE_OP_ANDNOT
+*   Effects    : The bitmaps are combined and the result is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  All files will be left open.
+***************************************************************************/
+int RleBitmapOpFile(FILE *aFile, FILE *bFile, FILE *outFile, int op)
+{
+    rle_source_t a, b;
+    rle_sink_t sink;
+
+    if ((NULL == aFile) || (NULL == bFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&a, aFile);
+    RleFileSource(&b, bFile);
+    RleFileSink(&sink, outFile);
+    return BitmapOp(&a, &b, &sink, op, format_rle);
+}
+
+/***************************************************************************
+*   Function   : VPackBitsBitmapOpFile
+*   Description: This routine combines two bitmaps encoded by
+*                VPackBitsEncodeFile, writing the encoded result to a file.
+*   Parameters : aFile - Pointer to the first encoded bitmap
+*                bFile - Pointer to the second encoded bitmap
+*                outFile - Pointer to the file receiving the encoded result
+*                op - RLE_OP_AND, RLE_OP_OR, RLE_OP_XOR, or RLE_OP_ANDNOT
+*   Effects    : The bitmaps are combined and the result is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  All files will be left open.
+***************************************************************************/
+int VPackBitsBitmapOpFile(FILE *aFile, FILE *bFile, FILE *outFile, int op)
+{
+    rle_source_t a, b;
+    rle_sink_t sink;
+
+    if ((NULL == aFile) || (NULL == bFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&a, aFile);
+    RleFileSource(&b, bFile);
+    RleFileSink(&sink, outFile);
+    return BitmapOp(&a, &b, &sink, op, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : RleBitmapOp, VPackBitsBitmapOp
+*   Description: These routines combine two encoded bitmaps a byte at a
+*                time, writing the result encoded the same way as the
+*                inputs.  Neither input is decoded, so a pair of runs costs
+*                the same no matter how long they are.  The shorter bitmap
+*                is treated as if it were padded with zero bytes.
+*   Parameters : a - Pointer to the source of the first encoded bitmap
+*                b - Pointer to the source of the second encoded bitmap
+*                sink - Pointer to the sink receiving the encoded result
+*                op - RLE_OP_AND, RLE_OP_OR, RLE_OP_XOR, or RLE_OP_ANDNOT
+*                     (a & ~b)
+*   Effects    : The bitmaps are combined and the result is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleBitmapOp(rle_source_t *a, rle_source_t *b, rle_sink_t *sink, int op)
+{
+    return BitmapOp(a, b, sink, op, format_rle);
+}
+
+int VPackBitsBitmapOp(rle_source_t *a, rle_source_t *b, rle_sink_t *sink,
+    int op)
+{
+    return BitmapOp(a, b, sink, op, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : BitmapOp
+*   Description: This routine walks the tokens of two encoded bitmaps side
+*                by side.  Where both have runs the result is a run as long
+*                as the shorter of them.  Anywhere else up to SPAN_SIZE
+*                bytes are combined into literals, which the writer turns
+*                back into runs where it can.
+*   Parameters : a - Pointer to the source of the first encoded bitmap
+*                b - Pointer to the source of the second encoded bitmap
+*                sink - Pointer to the sink receiving the encoded result
+*                op - Operation used to combine the bitmaps
+*                format - Encoding used by the inputs and the result
+*   Effects    : The bitmaps are combined and the result is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+static int BitmapOp(rle_source_t *a, rle_source_t *b, rle_sink_t *sink,
+    int op, format_t format)
+{
+    bitmap_op_t *state;
+    token_writer_t *writer;
+    int result;
+
+    if ((NULL == a) || (NULL == b) || (NULL == sink) ||
+        (op < RLE_OP_AND) || (op > RLE_OP_ANDNOT))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    state = (bitmap_op_t *)malloc(sizeof(bitmap_op_t));
+
+    if (NULL == state)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    InitTokenReader(&state->a.reader, a, format);
+    InitTokenReader(&state->b.reader, b, format);
+    state->a.token.length = 0;
+    state->a.done = 0;
+    state->b.token.length = 0;
+    state->b.done = 0;
+
+    writer = &state->writer;
+    InitTokenWriter(writer, sink, format);
+    result = 0;
+
+    while (!writer->out.error)
+    {
+        const token_t *x, *y;
+        size_t len;
+
+        if (Refill(&state->a) || Refill(&state->b))
+        {
+            result = -1;
+            break;
+        }
+
+        if (state->a.done && state->b.done)
+        {
+            break;
+        }
+
+        x = &state->a.token;
+        y = &state->b.token;
+        len = (x->length < y->length) ? x->length : y->length;
+
+        if ((token_run == x->kind) && (token_run == y->kind))
+        {
+            WriteRun(writer, Combine(op, x->symbol, y->symbol), len);
+        }
+        else
+        {
+            len = (len < SPAN_SIZE) ? len : SPAN_SIZE;
+            CombineSpan(op, x, y, state->span, len);
+            WriteLiterals(writer, state->span, len);
+        }
+
+        Consume(&state->a, len);
+        Consume(&state->b, len);
+    }
+
+    if (FinishTokenWriter(writer))
+    {
+        result = -1;
+    }
+
+    free(state);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : Refill
+*   Description: This routine reads the next token of an operand once the
+*                current one is used up.  At the end of the encoded data
+*                the token becomes an endless run of zeros.
+*   Parameters : operand - Pointer to the operand
+*   Effects    : Encoded data may be read
+*   Returned   : 0 for success, -1 for a read error.
+***************************************************************************/
+static int Refill(operand_t *operand)
+{
+    while ((0 == operand->token.length) && !operand->done)
+    {
+        int result;
+
+        result = NextToken(&operand->reader, &operand->token);
+
+        if (result < 0)
+        {
+            return -1;
+        }
+
+        if (0 == result)
+        {
+            operand->done = 1;
+            operand->token.kind = token_run;
+            operand->token.symbol = 0;
+            operand->token.length = (size_t)-1;
+            operand->token.data = NULL;
+        }
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : Consume
+*   Description: This routine marks part of an operand's current token as
+*                used.
+*   Parameters : operand - Pointer to the operand
+*                len - Number of symbols used
+*   Effects    : The operand's token is shortened
+*   Returned   : None
+***************************************************************************/
+static void Consume(operand_t *operand, size_t len)
+{
+    if (operand->done)
+    {
+        return;                 /* zeros never run out */
+    }
+
+    operand->token.length -= len;
+
+    if (token_literal == operand->token.kind)
+    {
+        operand->token.data += len;
+    }
+}
+
+/***************************************************************************
+*   Function   : Combine
+*   Description: This routine applies an operation to one byte from each
+*                bitmap.
+*   Parameters : op - The operation
+*                x - Byte from the first bitmap
+*                y - Byte from the second bitmap
+*   Effects    : None
+*   Returned   : The combined byte
+***************************************************************************/
+static unsigned char Combine(int op, unsigned char x, unsigned char y)
+{
+    switch (op)
+    {
+        case RLE_OP_AND:
+            return x & y;
+
+        case RLE_OP_OR:
+            return x | y;
+
+        case RLE_OP_XOR:
+            return x ^ y;
+
+        default:
+            return x & ~y;
+    }
+}
+
+/***************************************************************************
+*   Function   : CombineSpan
+*   Description: This routine applies an operation to the next len bytes
+*                of two tokens, at least one of which is a literal.
+*   Parameters : op - The operation
+*                x - Token from the first bitmap
+*                y - Token from the second bitmap
+*                span - Buffer receiving the combined bytes
+*                len - Number of bytes to combine
+*   Effects    : span holds the combined bytes
+*   Returned   : None
+***************************************************************************/
+static void CombineSpan(int op, const token_t *x, const token_t *y,
+    unsigned char *span, size_t len)
+{
+    size_t i;
+
+    if (token_run == x->kind)
+    {
+        for (i = 0; i < len; i++)
+        {
+            span[i] = Combine(op, x->symbol, y->data[i]);
+        }
+    }
+    else if (token_run == y->kind)
+    {
+        for (i = 0; i < len; i++)
+        {
+            span[i] = Combine(op, x->data[i], y->symbol);
+        }
+    }
+    else
+    {
+        for (i = 0; i < len; i++)
+        {
+            span[i] = Combine(op, x->data[i], y->data[i]);
+        }
+    }
+}
@@ -0,0 +1,840 @@
+/***************************************************************************
+*                  Block Container with Entropy Coding
+*
+*   File    : rleblock.c
+*   Purpose : Wrap the output of either run length encoder in a container
+*             of blocks.  Each block may be stored as is, or have a second
+*             stage applied: its tokens are split into a stream of control
+*             bytes (vpackbits headers or RLE run counts) and a stream of
+*             symbols, and each stream is Huffman coded on its own.  The
+*             method is recorded per block, so the decoder only pays for
+*             entropy decoding where it was used.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+* Container layout (all lengths are 4 byte little endian values)
+*
+*   "RLEB" version(1) format(1)
+*   blocks: method(1) rawLen(4) payloadLen(4) payload
+*   end:    0 0 0 (a stored block with no data)
+*
+* rawLen is the number of first stage (RLE or vpackbits) bytes in the
+* block.  A stored block's payload is those bytes.  An entropy coded
+* block's payload is the control stream followed by the symbol stream,
+* each written as mode(1) count(4) size(4) data, where mode 0 means the
+* data is the raw stream and mode 1 means it is Huffman coded.
+*
+* Blocks always end on a token boundary.  RLE tokens depend on the symbol
+* before them, so the split state is carried from block to block.
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rlecodec.h"
+#include "rletoken.h"
+#include "rlehuff.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define BLOCK_SIZE      (128UL * 1024)  /* most first stage bytes in block */
+#define BLOCK_SLACK     64              /* room for stream headers */
+#define HEADER_SIZE     6               /* container header size */
+#define BLOCK_HEADER    9               /* block header size */
+#define STREAM_HEADER   9               /* stream header size */
+#define VERSION         1               /* container version */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef enum
+{
+    method_stored = 0,                  /* first stage bytes as is */
+    method_huffman = 1                  /* split and Huffman coded */
+} method_t;
+
+typedef int (*stream_codec_t)(in_stream_t *in, out_stream_t *out);
+
+/* where the first stage token parse stands between blocks */
+typedef struct
+{
+    int prevChar;                       /* last RLE symbol or EOF */
+} split_state_t;
+
+/* memory used by the container encoder and decoder */
+typedef struct
+{
+    format_t format;                    /* first stage encoding */
+    int entropy;                        /* try Huffman coding blocks */
+    split_state_t state;                /* token parse state */
+    in_stream_t *in;                    /* container input (decoder) */
+    out_stream_t *out;                  /* container output (encoder) */
+    size_t blockLen;                    /* bytes in block */
+    int error;                          /* non-zero after bad data */
+    huff_table_t table;                 /* Huffman decode tables */
+    unsigned char block[BLOCK_SIZE];    /* first stage data */
+    unsigned char ctrl[BLOCK_SIZE];     /* control byte stream */
+    unsigned char syms[BLOCK_SIZE];     /* symbol stream */
+    unsigned char packed[BLOCK_SIZE + BLOCK_SLACK]; /* block payload */
+    unsigned char inBuf[IO_BUF_SIZE];   /* container input buffer */
+    unsigned char outBuf[IO_BUF_SIZE];  /* container output buffer */
+} block_work_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int StageBorrow(void *handle, unsigned char **buf, size_t *size);
+static int StageCommit(void *handle, size_t used);
+static int StageWrite(void *handle, const unsigned char *buf, size_t size);
+static void EmitBlock(block_work_t *work, int final);
+static size_t PackStream(const unsigned char *data, size_t len,
+    unsigned char *out);
+static int BlockBorrow(void *handle, const unsigned char **buf,
+    size_t *got);
+static int UnpackStream(block_work_t *work, const unsigned char **in,
+    const unsigned char *end, unsigned char *out, size_t *count);
+static size_t SplitTokens(format_t format, split_state_t *state,
+    const unsigned char *data, size_t len, unsigned char *ctrl,
+    size_t *ctrlLen, unsigned char *syms, size_t *symLen);
+static int MergeTokens(format_t format, split_state_t *state,
+    const unsigned char *ctrl, size_t ctrlLen, const unsigned char *syms,
+    size_t symLen, unsigned char *out, size_t outLen);
+static void PutLong(unsigned char *buf, unsigned long value);
+static unsigned long GetLong(const unsigned char *buf);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleBlockEncodeFile, RleBlockDecodeFile
+*   Description: These routines are the FILE stream versions of
+*                RleBlockEncode and RleBlockDecode.
+*   Parameters : inFile - Pointer to the file to read
+*                outFile - Pointer to the file to write
+*                flags - RLE_BLOCK_ flags (encode only)
+*   Effects    : inFile is encoded or decoded to outFile
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int RleBlockEncodeFile(FILE *inFile, FILE *outFile, int flags)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return RleBlockEncode(&source, &sink, flags);
+}
+
+int RleBlockDecodeFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return RleBlockDecode(&source, &sink);
+}
+
+/***************************************************************************
+*   Function   : RleBlockEncode
+*   Description: This routine run length encodes data and writes it as a
+*                block container.  The first stage encoder writes straight
+*                into the block buffer, and every full block is cut at its
+*                last token boundary and written out.  With
+*                RLE_BLOCK_ENTROPY, each block is Huffman coded if that
+*                makes it smaller, otherwise blocks are stored.
+*   Parameters : source - Pointer to the source of data to encode
+*                sink - Pointer to the sink receiving the container
+*                flags - RLE_BLOCK_PACKBITS to use the packbits variant,
+*                        RLE_BLOCK_ENTROPY to entropy code blocks
+*   Effects    : Data is encoded into a container
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleBlockEncode(rle_source_t *source, rle_sink_t *sink, int flags)
+{
+    block_work_t *work;
+    in_stream_t in;
+    out_stream_t out;
+    out_stream_t stageOut;
+    rle_sink_t stageSink;
+    stream_codec_t codec;
+    unsigned char header[HEADER_SIZE];
+    int result;
+
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    work = (block_work_t *)malloc(sizeof(block_work_t));
+
+    if (NULL == work)
+    {
+        return -1;
+    }
+
+    work->format = (flags & RLE_BLOCK_PACKBITS) ? format_vpackbits :
+        format_rle;
+    work->entropy = (0 != (flags & RLE_BLOCK_ENTROPY));
+    work->state.prevChar = EOF;
+    work->blockLen = 0;
+    work->out = &out;
+    codec = (format_vpackbits == work->format) ? VPackBitsEncodeStream :
+        RleEncodeStream;
+
+    InitInStream(&in, source, work->inBuf, IO_BUF_SIZE);
+    InitOutStream(&out, sink, work->outBuf, IO_BUF_SIZE);
+
+    memcpy(header, "RLEB", 4);
+    header[4] = VERSION;
+    header[5] = (unsigned char)work->format;
+    OutWrite(&out, header, HEADER_SIZE);
+
+    /* the first stage encoder writes into the block buffer */
+    stageSink.handle = work;
+    stageSink.write = StageWrite;
+    stageSink.borrow = StageBorrow;
+    stageSink.commit = StageCommit;
+    InitOutStream(&stageOut, &stageSink, NULL, 0);
+
+    result = codec(&in, &stageOut);
+
+    if (0 == result)
+    {
+        unsigned char end[BLOCK_HEADER];
+
+        EmitBlock(work, 1);
+        memset(end, 0, BLOCK_HEADER);
+        OutWrite(&out, end, BLOCK_HEADER);
+        result = OutFinish(&out);
+    }
+
+    free(work);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : StageBorrow, StageCommit, StageWrite
+*   Description: These routines are the sink callbacks used by the first
+*                stage encoder.  Borrowed space is the unused end of the
+*                block buffer, and a full block is written out before more
+*                space is lent.
+*   Parameters : handle - Pointer to the block_work_t
+*                buf - Set to the lent space (borrow) or data (write)
+*                size - Size of the lent space or of the data
+*                used - Bytes of lent space that now hold output
+*   Effects    : Blocks may be written to the container
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int StageBorrow(void *handle, unsigned char **buf, size_t *size)
+{
+    block_work_t *work;
+
+    work = (block_work_t *)handle;
+
+    if (BLOCK_SIZE == work->blockLen)
+    {
+        EmitBlock(work, 0);
+    }
+
+    *buf = work->block + work->blockLen;
+    *size = BLOCK_SIZE - work->blockLen;
+    return work->out->error ? -1 : 0;
+}
+
+static int StageCommit(void *handle, size_t used)
+{
+    ((block_work_t *)handle)->blockLen += used;
+    return 0;
+}
+
+static int StageWrite(void *handle, const unsigned char *buf, size_t size)
+{
+    while (size > 0)
+    {
+        unsigned char *space;
+        size_t n;
+
+        if (StageBorrow(handle, &space, &n))
+        {
+            return -1;
+        }
+
+        n = (n < size) ? n : size;
+        memcpy(space, buf, n);
+        StageCommit(handle, n);
+        buf += n;
+        size -= n;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : EmitBlock
+*   Description: This routine writes the block buffer, up to its last
+*                token boundary, to the container.  The block is entropy
+*                coded if that was requested and it saves space.  Bytes
+*                after the boundary are moved to the front of the buffer.
+*   Parameters : work - Pointer to the encoder's block_work_t
+*                final - Non-zero if there's no more first stage data
+*   Effects    : A block may be written and the buffer is updated
+*   Returned   : None
+***************************************************************************/
+static void EmitBlock(block_work_t *work, int final)
+{
+    unsigned char header[BLOCK_HEADER];
+    size_t cut, ctrlLen, symLen, payload;
+    method_t method;
+
+    cut = SplitTokens(work->format, &work->state, work->block,
+        work->blockLen, work->ctrl, &ctrlLen, work->syms, &symLen);
+
+    if (final && (cut < work->blockLen))
+    {
+        /* a partial token at the end can only be stored */
+        cut = work->blockLen;
+        ctrlLen = 0;
+        symLen = 0;
+    }
+
+    if (0 == cut)
+    {
+        return;
+    }
+
+    method = method_stored;
+    payload = cut;
+
+    if (work->entropy && (ctrlLen + symLen == cut))
+    {
+        size_t n;
+
+        n = PackStream(work->ctrl, ctrlLen, work->packed);
+        n += PackStream(work->syms, symLen, work->packed + n);
+
+        if (n < cut)
+        {
+            method = method_huffman;
+            payload = n;
+        }
+    }
+
+    header[0] = (unsigned char)method;
+    PutLong(header + 1, (unsigned long)cut);
+    PutLong(header + 5, (unsigned long)payload);
+    OutWrite(work->out, header, BLOCK_HEADER);
+    OutWrite(work->out, (method_huffman == method) ? work->packed :
+        work->block, payload);
+
+    work->blockLen -= cut;
+    memmove(work->block, work->block + cut, work->blockLen);
+}
+
+/***************************************************************************
+*   Function   : PackStream
+*   Description: This routine writes one stream of an entropy coded block,
+*                Huffman coding it if that saves space.
+*   Parameters : data - The stream
+*                len - Length of the stream
+*                out - Buffer receiving the stream header and data
+*   Effects    : The stream is written to out
+*   Returned   : Number of bytes written
+***************************************************************************/
+static size_t PackStream(const unsigned char *data, size_t len,
+    unsigned char *out)
+{
+    size_t size;
+
+    size = HuffEncode(data, len, out + STREAM_HEADER);
+    out[0] = (0 == size) ? method_stored : method_huffman;
+
+    if (0 == size)
+    {
+        memcpy(out + STREAM_HEADER, data, len);
+        size = len;
+    }
+
+    PutLong(out + 1, (unsigned long)len);
+    PutLong(out + 5, (unsigned long)size);
+    return STREAM_HEADER + size;
+}
+
+/***************************************************************************
+*   Function   : RleBlockDecode
+*   Description: This routine decodes a block container.  Each block is
+*                made available to the first stage decoder as a borrowed
+*                chunk, so stored blocks are decoded straight from the
+*                buffer they were read into.
+*   Parameters : source - Pointer to the source of the container
+*                sink - Pointer to the sink receiving the decoded data
+*   Effects    : The container is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (EILSEQ for a bad or truncated
+*                container).
+***************************************************************************/
+int RleBlockDecode(rle_source_t *source, rle_sink_t *sink)
+{
+    block_work_t *work;
+    in_stream_t in;
+    in_stream_t stageIn;
+    out_stream_t out;
+    rle_source_t stageSource;
+    unsigned char header[HEADER_SIZE];
+    size_t got;
+    int result;
+
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    work = (block_work_t *)malloc(sizeof(block_work_t));
+
+    if (NULL == work)
+    {
+        return -1;
+    }
+
+    InitInStream(&in, source, work->inBuf, IO_BUF_SIZE);
+    InitOutStream(&out, sink, work->outBuf, IO_BUF_SIZE);
+    work->in = &in;
+    work->state.prevChar = EOF;
+    work->error = 0;
+
+    if (InRead(&in, header, HEADER_SIZE, &got))
+    {
+        free(work);
+        return -1;
+    }
+
+    if ((HEADER_SIZE != got) || memcmp(header, "RLEB", 4) ||
+        (VERSION != header[4]) || (header[5] > format_vpackbits))
+    {
+        free(work);
+        errno = EILSEQ;
+        return -1;
+    }
+
+    work->format = (format_t)header[5];
+    stageSource.handle = work;
+    stageSource.read = NULL;
+    stageSource.borrow = BlockBorrow;
+    InitInStream(&stageIn, &stageSource, NULL, 0);
+
+    if (format_vpackbits == work->format)
+    {
+        result = VPackBitsDecodeStream(&stageIn, &out);
+    }
+    else
+    {
+        result = RleDecodeStream(&stageIn, &out);
+    }
+
+    if (work->error)
+    {
+        errno = EILSEQ;
+        result = -1;
+    }
+
+    free(work);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : BlockBorrow
+*   Description: This routine is the borrow callback of the source feeding
+*                the first stage decoder.  It reads the next block of the
+*                container and lends its first stage bytes.
+*   Parameters : handle - Pointer to the decoder's block_work_t
+*                buf - Set to the block's first stage bytes
+*                got - Set to the number of bytes (0 at the end block)
+*   Effects    : A block is read from the container
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int BlockBorrow(void *handle, const unsigned char **buf, size_t *got)
+{
+    block_work_t *work;
+    unsigned char header[BLOCK_HEADER];
+    size_t rawLen, payload, n;
+
+    work = (block_work_t *)handle;
+    *got = 0;
+
+    if (InRead(work->in, header, BLOCK_HEADER, &n))
+    {
+        return -1;
+    }
+
+    rawLen = GetLong(header + 1);
+    payload = GetLong(header + 5);
+
+    if (n != BLOCK_HEADER)
+    {
+        work->error = 1;        /* no end block */
+    }
+    else if (0 == rawLen)
+    {
+        return 0;
+    }
+    else if ((rawLen > BLOCK_SIZE) || (payload > sizeof(work->packed)) ||
+        ((method_stored == header[0]) && (payload != rawLen)) ||
+        (header[0] > method_huffman))
+    {
+        work->error = 1;
+    }
+    else if (InRead(work->in, work->packed, payload, &n))
+    {
+        return -1;
+    }
+    else if (n != payload)
+    {
+        work->error = 1;
+    }
+    else if (method_stored == header[0])
+    {
+        /* keep the RLE split state in step for later coded blocks */
+        if (format_rle == work->format)
+        {
+            SplitTokens(work->format, &work->state, work->packed, rawLen,
+                work->ctrl, &n, work->syms, &n);
+        }
+
+        *buf = work->packed;
+        *got = rawLen;
+        return 0;
+    }
+    else
+    {
+        const unsigned char *next;
+        size_t ctrlLen, symLen;
+
+        next = work->packed;
+
+        if (UnpackStream(work, &next, work->packed + payload, work->ctrl,
+                &ctrlLen) ||
+            UnpackStream(work, &next, work->packed + payload, work->syms,
+                &symLen) ||
+            MergeTokens(work->format, &work->state, work->ctrl, ctrlLen,
+                work->syms, symLen, work->block, rawLen))
+        {
+            work->error = 1;
+        }
+        else
+        {
+            *buf = work->block;
+            *got = rawLen;
+            return 0;
+        }
+    }
+
+    errno = EILSEQ;
+    return -1;
+}
+
+/***************************************************************************
+*   Function   : UnpackStream
+*   Description: This routine reads one stream of an entropy coded block.
+*   Parameters : work - Pointer to the decoder's block_work_t
+*                in - Pointer to the stream header.  Set to the data that
+*                     follows the stream.
+*                end - End of the block payload
+*                out - Buffer receiving the stream (BLOCK_SIZE bytes)
+*                count - Set to the length of the stream
+*   Effects    : The stream is decoded into out
+*   Returned   : 0 for success, -1 for bad data.
+***************************************************************************/
+static int UnpackStream(block_work_t *work, const unsigned char **in,
+    const unsigned char *end, unsigned char *out, size_t *count)
+{
+    const unsigned char *p;
+    size_t size;
+
+    p = *in;
+
+    if ((size_t)(end - p) < STREAM_HEADER)
+    {
+        return -1;
+    }
+
+    *count = GetLong(p + 1);
+    size = GetLong(p + 5);
+    p += STREAM_HEADER;
+
+    if ((*count > BLOCK_SIZE) || (size > (size_t)(end - p)))
+    {
+        return -1;
+    }
+
+    if (method_stored == p[-STREAM_HEADER])
+    {
+        if (size != *count)
+        {
+            return -1;
+        }
+
+        memcpy(out, p, size);
+    }
+    else if ((method_huffman != p[-STREAM_HEADER]) ||
+        HuffDecode(&work->table, p, size, out, *count))
+    {
+        return -1;
+    }
+
+    *in = p + size;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : SplitTokens
+*   Description: This routine splits first stage data into its control
+*                bytes and symbols, stopping at the last complete token.
+*                For vpackbits the control bytes are the block headers.
+*                For RLE they are the run counts, which follow every pair
+*                of matching symbols; a block never ends between a pair
+*                and its count.
+*   Parameters : format - The first stage encoding
+*                state - Parse state at the start of data.  Updated to the
+*                        state at the returned boundary.
+*                data - First stage data
+*                len - Length of data
+*                ctrl - Buffer receiving control bytes (len bytes)
+*                ctrlLen - Set to the number of control bytes
+*                syms - Buffer receiving symbols (len bytes)
+*                symLen - Set to the number of symbols
+*   Effects    : ctrl, syms, and state are updated
+*   Returned   : The offset of the last token boundary in data
+***************************************************************************/
+static size_t SplitTokens(format_t format, split_state_t *state,
+    const unsigned char *data, size_t len, unsigned char *ctrl,
+    size_t *ctrlLen, unsigned char *syms, size_t *symLen)
+{
+    size_t pos, c, s;
+
+    pos = 0;
+    c = 0;
+    s = 0;
+
+    if (format_vpackbits == format)
+    {
+        while (pos < len)
+        {
+            int header;
+            size_t n;
+
+            header = (signed char)data[pos];
+            n = (header < 0) ? 1 : (size_t)header + 1;
+
+            if (n >= (len - pos))
+            {
+                break;          /* incomplete block */
+            }
+
+            ctrl[c++] = data[pos];
+            memcpy(syms + s, data + pos + 1, n);
+            s += n;
+            pos += n + 1;
+        }
+    }
+    else
+    {
+        int prevChar;
+        size_t cut;
+
+        prevChar = state->prevChar;
+        cut = 0;
+        *ctrlLen = 0;
+        *symLen = 0;
+
+        while (pos < len)
+        {
+            syms[s++] = data[pos];
+
+            if (data[pos] == prevChar)
+            {
+                /* a pair needs its count */
+                if ((pos + 1) == len)
+                {
+                    break;
+                }
+
+                ctrl[c++] = data[pos + 1];
+                prevChar = EOF;
+                pos += 2;
+            }
+            else
+            {
+                prevChar = data[pos];
+                pos++;
+            }
+
+            cut = pos;
+            state->prevChar = prevChar;
+            *ctrlLen = c;
+            *symLen = s;
+        }
+
+        return cut;
+    }
+
+    *ctrlLen = c;
+    *symLen = s;
+    return pos;
+}
+
+/***************************************************************************
+*   Function   : MergeTokens
+*   Description: This routine rebuilds first stage data from its control
+*                bytes and symbols, undoing SplitTokens.
+*   Parameters : format - The first stage encoding
+*                state - Parse state at the start of the block, updated to
+*                        the state at its end
+*                ctrl - Control bytes
+*                ctrlLen - Number of control bytes
+*                syms - Symbols
+*                symLen - Number of symbols
+*                out - Buffer receiving the first stage data
+*                outLen - Expected length of the first stage data
+*   Effects    : The data is written to out
+*   Returned   : 0 for success, -1 if the streams don't fit together.
+***************************************************************************/
+static int MergeTokens(format_t format, split_state_t *state,
+    const unsigned char *ctrl, size_t ctrlLen, const unsigned char *syms,
+    size_t symLen, unsigned char *out, size_t outLen)
+{
+    size_t c, s, o;
+
+    if ((ctrlLen + symLen) != outLen)
+    {
+        return -1;
+    }
+
+    c = 0;
+    s = 0;
+    o = 0;
+
+    if (format_vpackbits == format)
+    {
+        while (c < ctrlLen)
+        {
+            int header;
+            size_t n;
+
+            header = (signed char)ctrl[c];
+            n = (header < 0) ? 1 : (size_t)header + 1;
+
+            if (n > (symLen - s))
+            {
+                return -1;
+            }
+
+            out[o++] = ctrl[c++];
+            memcpy(out + o, syms + s, n);
+            o += n;
+            s += n;
+        }
+    }
+    else
+    {
+        int prevChar;
+
+        prevChar = state->prevChar;
+
+        while (s < symLen)
+        {
+            out[o++] = syms[s];
+
+            if (syms[s] == prevChar)
+            {
+                if (c == ctrlLen)
+                {
+                    return -1;
+                }
+
+                out[o++] = ctrl[c++];
+                prevChar = EOF;
+            }
+            else
+            {
+                prevChar = syms[s];
+            }
+
+            s++;
+        }
+
+        state->prevChar = prevChar;
+    }
+
+    return ((c == ctrlLen) && (s == symLen)) ? 0 : -1;
+}
+
+/***************************************************************************
+*   Function   : PutLong, GetLong
+*   Description: These routines write and read 4 byte little endian values.
+*   Parameters : buf - Where the value is stored
+*                value - Value to write
+*   Effects    : PutLong writes 4 bytes to buf
+*   Returned   : GetLong returns the value read
+***************************************************************************/
+static void PutLong(unsigned char *buf, unsigned long value)
+{
+    buf[0] = (unsigned char)(value & 0xFF);
+    buf[1] = (unsigned char)((value >> 8) & 0xFF);
+    buf[2] = (unsigned char)((value >> 16) & 0xFF);
+    buf[3] = (unsigned char)((value >> 24) & 0xFF);
+}
+
+static unsigned long GetLong(const unsigned char *buf)
+{
+    return (unsigned long)buf[0] | ((unsigned long)buf[1] << 8) |
+        ((unsigned long)buf[2] << 16) | ((unsigned long)buf[3] << 24);
+}
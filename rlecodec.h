@@ -0,0 +1,64 @@
+/***************************************************************************
+*                    Header for Stream Level Codec Routines
+*
+*   File    : rlecodec.h
+*   Purpose : Provides the internal interface to the codecs working on
+*             buffered streams.  The public encode and decode routines set
+*             up the streams (with buffers from the stack or from a
+*             context) and call these routines.  This header is not part of
+*             the public library interface.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+#ifndef _RLECODEC_H_
+#define _RLECODEC_H_
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include "rleio.h"
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+
+/* traditional RLE encoding/decoding of streams */
+int RleEncodeStream(in_stream_t *in, out_stream_t *out);
+int RleDecodeStream(in_stream_t *in, out_stream_t *out);
+
+/* variant of packbits encoding/decoding of streams */
+int VPackBitsEncodeStream(in_stream_t *in, out_stream_t *out);
+int VPackBitsDecodeStream(in_stream_t *in, out_stream_t *out);
+
+/* periodic pattern encoding/decoding of streams */
+int RlePatternEncodeStream(in_stream_t *in, out_stream_t *out);
+int RlePatternDecodeStream(in_stream_t *in, out_stream_t *out);
+
+/* standard PackBits encoding/decoding of streams */
+int PackBitsEncodeStream(in_stream_t *in, out_stream_t *out, size_t rowBytes);
+int PackBitsDecodeStream(in_stream_t *in, out_stream_t *out);
+
+#endif  /* ndef _RLECODEC_H_ */
@@ -0,0 +1,353 @@
+/***************************************************************************
+*                     Reusable Codec Context Library
+*
+*   File    : rlectx.c
+*   Purpose : Provide codec contexts for encoding and decoding many small
+*             messages.  A context is built inside memory supplied by the
+*             caller and holds the scratch buffers used by the codecs, so
+*             once a context exists no call made with it allocates memory.
+*             A context belongs to the thread that initialized (or last
+*             reset) it and may only be used by that thread.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rlecodec.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define CTX_ALIGN       16              /* alignment of context in arena */
+#define CTX_MIN_BUF     64              /* smallest scratch buffer allowed */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+#if defined(_WIN32)
+typedef DWORD thread_id_t;
+#else
+typedef pthread_t thread_id_t;
+#endif
+
+typedef int (*stream_codec_t)(in_stream_t *in, out_stream_t *out);
+
+struct rle_context_t
+{
+    unsigned char *inBuf;               /* scratch for reading sources */
+    unsigned char *outBuf;              /* scratch for writing sinks */
+    size_t bufSize;                     /* size of each scratch buffer */
+    thread_id_t owner;                  /* thread allowed to use context */
+};
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+#if defined(_WIN32)
+#define CURRENT_THREAD()    GetCurrentThreadId()
+#define SAME_THREAD(a, b)   ((a) == (b))
+#else
+#define CURRENT_THREAD()    pthread_self()
+#define SAME_THREAD(a, b)   pthread_equal((a), (b))
+#endif
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int RunCodec(rle_context_t *ctx, stream_codec_t codec,
+    rle_source_t *source, rle_sink_t *sink);
+static int RunBuffer(rle_context_t *ctx, stream_codec_t codec,
+    const unsigned char *in, size_t inLen, unsigned char *out,
+    size_t outSize, size_t *outLen);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleContextSize
+*   Description: This routine returns the amount of memory that must be
+*                passed to RleContextInit to get scratch buffers of a given
+*                size.  Buffers that fit in the L1 cache (a few KB) are a
+*                good choice for small messages.
+*   Parameters : bufSize - Desired size of each scratch buffer
+*   Effects    : None
+*   Returned   : Size of arena required
+***************************************************************************/
+size_t RleContextSize(size_t bufSize)
+{
+    if (bufSize < CTX_MIN_BUF)
+    {
+        bufSize = CTX_MIN_BUF;
+    }
+
+    return sizeof(rle_context_t) + (2 * bufSize) + CTX_ALIGN;
+}
+
+/***************************************************************************
+*   Function   : RleContextInit
+*   Description: This routine builds a codec context inside of memory
+*                supplied by the caller.  The memory left after the context
+*                itself is split into its two scratch buffers.  The context
+*                belongs to the calling thread.
+*   Parameters : arena - Pointer to memory for the context.  It must stay
+*                        valid for as long as the context is used.
+*                arenaSize - Size of arena (see RleContextSize)
+*   Effects    : A context is written to arena
+*   Returned   : Pointer to the context, or NULL (with errno set to EINVAL)
+*                if arena is NULL or too small.
+***************************************************************************/
+rle_context_t *RleContextInit(void *arena, size_t arenaSize)
+{
+    rle_context_t *ctx;
+    size_t skip;
+
+    if (NULL == arena)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    skip = (CTX_ALIGN - ((size_t)arena % CTX_ALIGN)) % CTX_ALIGN;
+
+    if (arenaSize < (skip + sizeof(rle_context_t) + (2 * CTX_MIN_BUF)))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    ctx = (rle_context_t *)((unsigned char *)arena + skip);
+    ctx->bufSize = (arenaSize - skip - sizeof(rle_context_t)) / 2;
+    ctx->inBuf = (unsigned char *)(ctx + 1);
+    ctx->outBuf = ctx->inBuf + ctx->bufSize;
+    ctx->owner = CURRENT_THREAD();
+    return ctx;
+}
+
+/***************************************************************************
+*   Function   : RleContextReset
+*   Description: This routine returns a context to the state it was in
+*                after RleContextInit, and gives it to the calling thread.
+*                It is the only way to move a context between threads.
+*   Parameters : ctx - Pointer to the context
+*   Effects    : ctx belongs to the calling thread
+*   Returned   : None
+***************************************************************************/
+void RleContextReset(rle_context_t *ctx)
+{
+    if (NULL != ctx)
+    {
+        ctx->owner = CURRENT_THREAD();
+    }
+}
+
+/***************************************************************************
+*   Function   : RleEncodeCtx, RleDecodeCtx, VPackBitsEncodeCtx,
+*                VPackBitsDecodeCtx
+*   Description: These routines are the same as RleEncode, RleDecode,
+*                VPackBitsEncode, and VPackBitsDecode, except that any
+*                buffering is done in the context's scratch buffers.
+*   Parameters : ctx - Pointer to a context owned by the calling thread
+*                source - Pointer to the source of data
+*                sink - Pointer to the sink receiving the results
+*   Effects    : Data is encoded or decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (EPERM if ctx belongs to another
+*                thread).
+***************************************************************************/
+int RleEncodeCtx(rle_context_t *ctx, rle_source_t *source, rle_sink_t *sink)
+{
+    return RunCodec(ctx, RleEncodeStream, source, sink);
+}
+
+int RleDecodeCtx(rle_context_t *ctx, rle_source_t *source, rle_sink_t *sink)
+{
+    return RunCodec(ctx, RleDecodeStream, source, sink);
+}
+
+int VPackBitsEncodeCtx(rle_context_t *ctx, rle_source_t *source,
+    rle_sink_t *sink)
+{
+    return RunCodec(ctx, VPackBitsEncodeStream, source, sink);
+}
+
+int VPackBitsDecodeCtx(rle_context_t *ctx, rle_source_t *source,
+    rle_sink_t *sink)
+{
+    return RunCodec(ctx, VPackBitsDecodeStream, source, sink);
+}
+
+/***************************************************************************
+*   Function   : RleEncodeBuffer, RleDecodeBuffer, VPackBitsEncodeBuffer,
+*                VPackBitsDecodeBuffer
+*   Description: These routines encode or decode one message held in
+*                memory, writing the results to memory.  The codec works
+*                directly in the caller's memory, so neither the message
+*                nor the results are copied.
+*   Parameters : ctx - Pointer to a context owned by the calling thread, or
+*                      NULL
+*                in - Pointer to the message
+*                inLen - Length of the message
+*                out - Pointer to memory receiving the results
+*                outSize - Size of out
+*                outLen - Set to the number of bytes written to out
+*   Effects    : Data is encoded or decoded into out
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if out is too small).
+***************************************************************************/
+int RleEncodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen)
+{
+    return RunBuffer(ctx, RleEncodeStream, in, inLen, out, outSize, outLen);
+}
+
+int RleDecodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen)
+{
+    return RunBuffer(ctx, RleDecodeStream, in, inLen, out, outSize, outLen);
+}
+
+int VPackBitsEncodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen)
+{
+    return RunBuffer(ctx, VPackBitsEncodeStream, in, inLen, out, outSize,
+        outLen);
+}
+
+int VPackBitsDecodeBuffer(rle_context_t *ctx, const unsigned char *in,
+    size_t inLen, unsigned char *out, size_t outSize, size_t *outLen)
+{
+    return RunBuffer(ctx, VPackBitsDecodeStream, in, inLen, out, outSize,
+        outLen);
+}
+
+/***************************************************************************
+*   Function   : RunCodec
+*   Description: This routine checks that a context may be used by the
+*                calling thread, then runs a stream codec with streams
+*                buffered by the context.
+*   Parameters : ctx - Pointer to the context
+*                codec - The stream codec to run
+*                source - Pointer to the source of data
+*                sink - Pointer to the sink receiving the results
+*   Effects    : Data is encoded or decoded
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int RunCodec(rle_context_t *ctx, stream_codec_t codec,
+    rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+
+    if ((NULL == ctx) || (NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!SAME_THREAD(ctx->owner, CURRENT_THREAD()))
+    {
+        errno = EPERM;
+        return -1;
+    }
+
+    InitInStream(&in, source, ctx->inBuf, ctx->bufSize);
+    InitOutStream(&out, sink, ctx->outBuf, ctx->bufSize);
+    return codec(&in, &out);
+}
+
+/***************************************************************************
+*   Function   : RunBuffer
+*   Description: This routine runs a stream codec on a message in memory.
+*                Memory sources and sinks lend their memory, so the
+*                scratch buffers are never touched.  That also means a
+*                context isn't required.
+*   Parameters : ctx - Pointer to the context or NULL
+*                codec - The stream codec to run
+*                in - Pointer to the message
+*                inLen - Length of the message
+*                out - Pointer to memory receiving the results
+*                outSize - Size of out
+*                outLen - Set to the number of bytes written to out
+*   Effects    : Data is encoded or decoded into out
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int RunBuffer(rle_context_t *ctx, stream_codec_t codec,
+    const unsigned char *in, size_t inLen, unsigned char *out,
+    size_t outSize, size_t *outLen)
+{
+    rle_buffer_t inBuffer;
+    rle_buffer_t outBuffer;
+    rle_source_t source;
+    rle_sink_t sink;
+    in_stream_t inStream;
+    out_stream_t outStream;
+    int result;
+
+    if (((NULL == in) && (inLen > 0)) || (NULL == out) || (NULL == outLen))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    inBuffer.data = (unsigned char *)in;
+    inBuffer.size = inLen;
+    inBuffer.pos = 0;
+    outBuffer.data = out;
+    outBuffer.size = outSize;
+    outBuffer.pos = 0;
+    RleBufferSource(&source, &inBuffer);
+    RleBufferSink(&sink, &outBuffer);
+
+    if (NULL != ctx)
+    {
+        result = RunCodec(ctx, codec, &source, &sink);
+    }
+    else
+    {
+        InitInStream(&inStream, &source, NULL, 0);
+        InitOutStream(&outStream, &sink, NULL, 0);
+        result = codec(&inStream, &outStream);
+    }
+
+    *outLen = outBuffer.pos;
+    return result;
+}
@@ -0,0 +1,397 @@
+/***************************************************************************
+*                  Encoded Asset Embedding Tool
+*
+*   File    : rleembed.c
+*   Purpose : Build time tool that encodes a file with the run length
+*             encoding library and writes it out as a C header holding
+*             the encoded bytes in an array, along with the encoding used
+*             and the decoded size.  The header may be included by C or
+*             C++ code.  C++ code may expand it with the routines in
+*             rleembed.hpp, either at compile time or on first use.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include "optlist/optlist.h"
+#include "rle.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define BYTES_PER_LINE  12              /* array elements on each line */
+#define MAX_NAME        64              /* longest array name */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/* source that counts the bytes read from a file */
+typedef struct
+{
+    FILE *file;                         /* file being read */
+    unsigned long count;                /* bytes read so far */
+} count_source_t;
+
+/* sink that writes bytes as the elements of a C array */
+typedef struct
+{
+    FILE *file;                         /* header being written */
+    unsigned long count;                /* bytes written so far */
+} array_sink_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static void ShowUsage(const char *progName);
+static void MakeName(char *name, const char *source);
+static int WriteHeader(FILE *inFile, FILE *outFile, const char *name,
+    const char *fileName, int packbits);
+static int CountRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got);
+static int ArrayWrite(void *handle, const unsigned char *buf, size_t size);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : main
+*   Description: This is the main function for this program, it validates
+*                the command line input and, if valid, writes a header
+*                holding the encoded input file.
+*   Parameters : argc - number of parameters
+*                argv - parameter list
+*   Effects    : Writes a C header
+*   Returned   : 0 for success, errno for failure.
+***************************************************************************/
+int main(int argc, char *argv[])
+{
+    option_t *optList;
+    option_t *thisOpt;
+    const char *inName;
+    const char *outName;
+    char name[MAX_NAME + 1];
+    FILE *inFile;
+    FILE *outFile;
+    int packbits;
+    int result;
+
+    inName = NULL;
+    outName = NULL;
+    name[0] = '\0';
+    packbits = 0;
+
+    /* parse command line */
+    optList = GetOptList(argc, argv, "vn:i:o:h?");
+    thisOpt = optList;
+
+    while (thisOpt != NULL)
+    {
+        switch(thisOpt->option)
+        {
+            case 'v':       /* use packbits variant */
+                packbits = 1;
+                break;
+
+            case 'n':       /* array name */
+                MakeName(name, thisOpt->argument);
+                break;
+
+            case 'i':       /* input file name */
+                inName = thisOpt->argument;
+                break;
+
+            case 'o':       /* output file name */
+                outName = thisOpt->argument;
+                break;
+
+            case 'h':
+            case '?':
+                ShowUsage(argv[0]);
+                FreeOptList(optList);
+                return 0;
+        }
+
+        thisOpt = thisOpt->next;
+    }
+
+    if (NULL == inName)
+    {
+        fprintf(stderr, "An input file is required.\n");
+        ShowUsage(argv[0]);
+        FreeOptList(optList);
+        return EINVAL;
+    }
+
+    if ('\0' == name[0])
+    {
+        MakeName(name, FindFileName(inName));
+    }
+
+    if (NULL == (inFile = fopen(inName, "rb")))
+    {
+        perror("Opening Input File");
+        FreeOptList(optList);
+        return errno;
+    }
+
+    outFile = (NULL == outName) ? stdout : fopen(outName, "w");
+
+    if (NULL == outFile)
+    {
+        perror("Opening Output File");
+        fclose(inFile);
+        FreeOptList(optList);
+        return errno;
+    }
+
+    result = WriteHeader(inFile, outFile, name, FindFileName(inName),
+        packbits);
+
+    if (0 != result)
+    {
+        perror("Writing Header");
+    }
+
+    fclose(inFile);
+
+    if ((outFile != stdout) && fclose(outFile) && (0 == result))
+    {
+        result = errno;
+        perror("Closing Output File");
+    }
+
+    FreeOptList(optList);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : ShowUsage
+*   Description: This function sends instructions for using this program to
+*                stdout.
+*   Parameters : progName - the name of the executable version of this
+*                           program.
+*   Effects    : Usage instructions are sent to stdout.
+*   Returned   : None
+***************************************************************************/
+static void ShowUsage(const char *progName)
+{
+    printf("Usage: %s <options>\n\n", FindFileName(progName));
+    printf("options:\n");
+    printf("  -i <filename> : Name of file to embed.\n");
+    printf("  -o <filename> : Name of header to write (default: stdout).\n");
+    printf("  -n <name> : Name of array (default: from input file name).\n");
+    printf("  -v : Use variant of packbits algorithm.\n");
+    printf("  -h | ?  : Print out command line options.\n");
+}
+
+/***************************************************************************
+*   Function   : MakeName
+*   Description: This function turns a string into a C identifier by
+*                replacing anything that isn't a letter or digit with an
+*                underscore.  Names that would start with a digit are
+*                prefixed with "rle_".
+*   Parameters : name - buffer receiving the identifier (MAX_NAME + 1)
+*                source - string to make the identifier from
+*   Effects    : name is written
+*   Returned   : None
+***************************************************************************/
+static void MakeName(char *name, const char *source)
+{
+    size_t i;
+
+    i = 0;
+
+    if (isdigit((unsigned char)source[0]) || ('\0' == source[0]))
+    {
+        strcpy(name, "rle_");
+        i = 4;
+    }
+
+    for (; ('\0' != *source) && (i < MAX_NAME); source++, i++)
+    {
+        name[i] = isalnum((unsigned char)*source) ? *source : '_';
+    }
+
+    name[i] = '\0';
+}
+
+/***************************************************************************
+*   Function   : WriteHeader
+*   Description: This function encodes a file straight into the array
+*                initializer of a header, then writes macros giving the
+*                encoding and the sizes.  The array is declared constexpr
+*                when the header is compiled as C++11 or later, so its
+*                contents may be read by constant expressions.
+*   Parameters : inFile - the file to embed
+*                outFile - the header being written
+*                name - name of the array
+*                fileName - name of the embedded file, for comments
+*                packbits - non-zero to use the packbits variant
+*   Effects    : The header is written
+*   Returned   : 0 for success, errno for failure.
+***************************************************************************/
+static int WriteHeader(FILE *inFile, FILE *outFile, const char *name,
+    const char *fileName, int packbits)
+{
+    count_source_t counter;
+    array_sink_t array;
+    rle_source_t source;
+    rle_sink_t sink;
+    char upper[MAX_NAME + 1];
+    int result;
+    size_t i;
+
+    for (i = 0; '\0' != name[i]; i++)
+    {
+        upper[i] = (char)toupper((unsigned char)name[i]);
+    }
+
+    upper[i] = '\0';
+
+    fprintf(outFile, "/* %s encoded by rleembed.  do not edit. */\n",
+        fileName);
+    fprintf(outFile, "#ifndef %s_RLE_EMBED\n#define %s_RLE_EMBED\n\n",
+        upper, upper);
+    fprintf(outFile, "#ifndef RLE_EMBED_CONST\n");
+    fprintf(outFile, "#if defined __cplusplus && (__cplusplus >= 201103L)\n");
+    fprintf(outFile, "#define RLE_EMBED_CONST constexpr\n#else\n");
+    fprintf(outFile, "#define RLE_EMBED_CONST const\n#endif\n#endif\n\n");
+    fprintf(outFile, "static RLE_EMBED_CONST unsigned char %s[] =\n{", name);
+
+    counter.file = inFile;
+    counter.count = 0;
+    source.handle = &counter;
+    source.read = CountRead;
+    source.borrow = NULL;
+    array.file = outFile;
+    array.count = 0;
+    sink.handle = &array;
+    sink.write = ArrayWrite;
+    sink.borrow = NULL;
+    sink.commit = NULL;
+
+    if (packbits)
+    {
+        result = VPackBitsEncode(&source, &sink);
+    }
+    else
+    {
+        result = RleEncode(&source, &sink);
+    }
+
+    if (0 != result)
+    {
+        return errno;
+    }
+
+    if (0 == array.count)
+    {
+        /* C arrays can't be empty */
+        fprintf(outFile, "\n    0x00    /* padding, nothing is encoded */");
+    }
+
+    fprintf(outFile, "\n};\n\n");
+    fprintf(outFile,
+        "#define %s_FORMAT %d   /* 0 RLE, 1 packbits variant */\n", upper,
+        packbits);
+    fprintf(outFile, "#define %s_SIZE %luUL   /* decoded size */\n", upper,
+        counter.count);
+    fprintf(outFile, "#define %s_ENCODED_SIZE %luUL   /* encoded size */\n",
+        upper, array.count);
+    fprintf(outFile, "\n#endif  /* ndef %s_RLE_EMBED */\n", upper);
+
+    if (fflush(outFile) || ferror(outFile))
+    {
+        return (0 != errno) ? errno : EIO;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : CountRead
+*   Description: This function is the read callback of a source that
+*                counts the bytes it reads from a file.
+*   Parameters : handle - pointer to the count_source_t
+*                buf - buffer receiving the data
+*                size - size of buf
+*                got - set to the number of bytes read (0 at end of file)
+*   Effects    : Data is read from the file
+*   Returned   : 0 for success, -1 for failure.
+***************************************************************************/
+static int CountRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got)
+{
+    count_source_t *counter;
+
+    counter = (count_source_t *)handle;
+    *got = fread(buf, sizeof(unsigned char), size, counter->file);
+    counter->count += *got;
+    return ((0 == *got) && ferror(counter->file)) ? -1 : 0;
+}
+
+/***************************************************************************
+*   Function   : ArrayWrite
+*   Description: This function is the write callback of a sink that
+*                writes bytes as array elements, BYTES_PER_LINE to a line.
+*   Parameters : handle - pointer to the array_sink_t
+*                buf - data to write
+*                size - number of bytes to write
+*   Effects    : Array elements are written to the header
+*   Returned   : 0 for success, -1 for failure.
+***************************************************************************/
+static int ArrayWrite(void *handle, const unsigned char *buf, size_t size)
+{
+    array_sink_t *array;
+    size_t i;
+
+    array = (array_sink_t *)handle;
+
+    for (i = 0; i < size; i++)
+    {
+        if (0 == (array->count % BYTES_PER_LINE))
+        {
+            fputs((0 == array->count) ? "\n    " : ",\n    ", array->file);
+        }
+        else
+        {
+            fputs(", ", array->file);
+        }
+
+        fprintf(array->file, "0x%02x", buf[i]);
+        array->count++;
+    }
+
+    return ferror(array->file) ? -1 : 0;
+}
@@ -0,0 +1,230 @@
+/***************************************************************************
+*                 Header for Embedded Asset Decoding Routines
+*
+*   File    : rleembed.hpp
+*   Purpose : Provides C++ routines that expand the arrays written by
+*             rleembed.  Small assets may be expanded at compile time into
+*             constexpr arrays.  Large assets may be expanded into static
+*             storage the first time they are used.  Neither uses the
+*             heap, and neither needs the run length encoding library.
+*             Requires C++14.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+
+#ifndef _RLEEMBED_HPP_
+#define _RLEEMBED_HPP_
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <cstddef>
+#include <mutex>
+
+namespace rle
+{
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+
+/* values of the NAME_FORMAT macro written by rleembed */
+constexpr int format_rle = 0;           /* traditional RLE */
+constexpr int format_vpackbits = 1;     /* packbits variant */
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : Decode
+*   Description: This routine decodes encoded data in memory.  It may be
+*                used in constant expressions.  Output past size is
+*                dropped.
+*   Parameters : in - Pointer to the encoded data
+*                inLen - Number of bytes of encoded data
+*                format - format_rle or format_vpackbits
+*                out - Pointer to memory receiving the decoded data
+*                size - Size of out
+*   Effects    : Decoded data is written to out
+*   Returned   : The number of bytes written to out
+***************************************************************************/
+constexpr std::size_t Decode(const unsigned char *in, std::size_t inLen,
+    int format, unsigned char *out, std::size_t size)
+{
+    std::size_t i = 0;
+    std::size_t o = 0;
+
+    if (format_vpackbits == format)
+    {
+        while ((i < inLen) && (o < size))
+        {
+            int header = (in[i] < 128) ? in[i] : in[i] - 256;
+            i++;
+
+            if (header >= 0)
+            {
+                /* copy header + 1 symbols */
+                for (int n = header + 1; (n > 0) && (i < inLen) &&
+                    (o < size); n--)
+                {
+                    out[o++] = in[i++];
+                }
+            }
+            else if (i < inLen)
+            {
+                /* run of 2 - header symbols */
+                for (int n = 2 - header; (n > 0) && (o < size); n--)
+                {
+                    out[o++] = in[i];
+                }
+
+                i++;
+            }
+        }
+
+        return o;
+    }
+
+    int prevChar = -1;                  /* nothing to pair with */
+
+    while ((i < inLen) && (o < size))
+    {
+        unsigned char c = in[i++];
+        out[o++] = c;
+
+        if (c == prevChar)
+        {
+            /* a pair is followed by a count of more copies */
+            if (i < inLen)
+            {
+                for (int n = in[i++]; (n > 0) && (o < size); n--)
+                {
+                    out[o++] = c;
+                }
+            }
+
+            prevChar = -1;
+        }
+        else
+        {
+            prevChar = c;
+        }
+    }
+
+    return o;
+}
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/* an asset expanded into a constexpr array */
+template <std::size_t N>
+struct asset_t
+{
+    unsigned char data[(N > 0) ? N : 1];
+
+    constexpr unsigned char operator[](std::size_t i) const
+    {
+        return data[i];
+    }
+
+    constexpr std::size_t size() const
+    {
+        return N;
+    }
+};
+
+/***************************************************************************
+*   Function   : Expand
+*   Description: This routine expands an asset into an asset_t.  Used to
+*                initialize a constexpr variable, the expansion is done by
+*                the compiler, e.g.
+*                constexpr auto table =
+*                    rle::Expand<TABLE_SIZE>(table_rle, sizeof(table_rle),
+*                    TABLE_FORMAT);
+*                Compilers limit the work done in a constant expression,
+*                so this is meant for small assets.
+*   Parameters : in - Pointer to the encoded data
+*                inLen - Number of bytes of encoded data
+*                format - format_rle or format_vpackbits
+*   Effects    : None
+*   Returned   : The expanded asset
+***************************************************************************/
+template <std::size_t N>
+constexpr asset_t<N> Expand(const unsigned char *in, std::size_t inLen,
+    int format)
+{
+    asset_t<N> asset{};
+
+    Decode(in, inLen, format, asset.data, N);
+    return asset;
+}
+
+/***************************************************************************
+* lazy_asset_t holds storage for an expanded asset and expands it the first
+* time data() is called.  Its constructor is constexpr, so a lazy_asset_t
+* with static storage duration takes up no space in the executable and
+* does nothing at startup.  Expansion is thread safe.
+***************************************************************************/
+template <std::size_t N>
+class lazy_asset_t
+{
+    public:
+        constexpr lazy_asset_t(const unsigned char *in, std::size_t inLen,
+            int format) :
+            in_(in), inLen_(inLen), format_(format), once_(), data_()
+        {
+        }
+
+        /* expanded data, expanded by the first call */
+        const unsigned char *data()
+        {
+            std::call_once(once_, [this]()
+                {
+                    Decode(in_, inLen_, format_, data_, N);
+                });
+
+            return data_;
+        }
+
+        constexpr std::size_t size() const
+        {
+            return N;
+        }
+
+    private:
+        const unsigned char *in_;       /* encoded data */
+        std::size_t inLen_;             /* size of encoded data */
+        int format_;                    /* format of encoded data */
+        std::once_flag once_;           /* set once data_ is expanded */
+        unsigned char data_[(N > 0) ? N : 1];   /* expanded data */
+};
+
+}   /* namespace rle */
+
+#endif  /* ndef _RLEEMBED_HPP_ */
@@ -0,0 +1,480 @@
+/***************************************************************************
+*                    Huffman Entropy Coding Library
+*
+*   File    : rlehuff.c
+*   Purpose : Huffman code a buffer of bytes and decode it again.  Codes
+*             are canonical and limited to HUFF_MAX_BITS bits, so a coded
+*             buffer only needs its code lengths (as 4 bit values) in front
+*             of the bits.  Decoding uses a table indexed by the next
+*             HUFF_MAX_BITS bits, and most lookups produce two symbols.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <string.h>
+#include "rlehuff.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define NUM_SYMBOLS     256             /* symbols in the alphabet */
+#define MAX_NODES       (2 * NUM_SYMBOLS - 1)
+#define INDEX_MASK      (HUFF_TABLE_SIZE - 1)
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static void BuildLengths(const unsigned long *freq, unsigned char *lengths);
+static int TreeLengths(const unsigned long *freq, unsigned char *lengths);
+static void AssignCodes(const unsigned char *lengths, unsigned int *codes);
+static int BuildTable(huff_table_t *table, const unsigned char *lengths);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : HuffEncode
+*   Description: This routine Huffman codes a buffer.  The output is
+*                HUFF_HEADER bytes of code lengths (two per byte, low
+*                nibble first) followed by the codes packed most
+*                significant bit first.  Coding stops as soon as the output
+*                would be as large as the input.
+*   Parameters : data - Bytes to code
+*                len - Number of bytes to code
+*                out - Buffer receiving the coded data.  It must hold at
+*                      least len bytes.
+*   Effects    : Coded data is written to out
+*   Returned   : Size of the coded data, or 0 if it isn't smaller than len.
+***************************************************************************/
+size_t HuffEncode(const unsigned char *data, size_t len, unsigned char *out)
+{
+    unsigned long freq[NUM_SYMBOLS];
+    unsigned char lengths[NUM_SYMBOLS];
+    unsigned int codes[NUM_SYMBOLS];
+    unsigned long acc;
+    unsigned int bits;
+    size_t i, pos;
+
+    if (len <= HUFF_HEADER)
+    {
+        return 0;
+    }
+
+    memset(freq, 0, sizeof(freq));
+
+    for (i = 0; i < len; i++)
+    {
+        freq[data[i]]++;
+    }
+
+    BuildLengths(freq, lengths);
+    AssignCodes(lengths, codes);
+
+    for (i = 0; i < HUFF_HEADER; i++)
+    {
+        out[i] = (unsigned char)(lengths[2 * i] | (lengths[2 * i + 1] << 4));
+    }
+
+    pos = HUFF_HEADER;
+    acc = 0;
+    bits = 0;
+
+    for (i = 0; i < len; i++)
+    {
+        acc = (acc << lengths[data[i]]) | codes[data[i]];
+        bits += lengths[data[i]];
+
+        while (bits >= 8)
+        {
+            if (pos == len)
+            {
+                return 0;
+            }
+
+            bits -= 8;
+            out[pos++] = (unsigned char)(acc >> bits);
+        }
+    }
+
+    if (bits > 0)
+    {
+        if (pos == len)
+        {
+            return 0;
+        }
+
+        out[pos++] = (unsigned char)(acc << (8 - bits));
+    }
+
+    return pos;
+}
+
+/***************************************************************************
+*   Function   : HuffDecode
+*   Description: This routine decodes data coded by HuffEncode.  The bits
+*                are read through an accumulator that always holds at least
+*                25 bits, so one table lookup and one refill handle up to
+*                two symbols.  The single symbol table finishes the last
+*                symbol.
+*   Parameters : table - Scratch space for the decode tables
+*                in - Coded data
+*                inLen - Size of the coded data
+*                out - Buffer receiving the decoded symbols
+*                count - Number of symbols to decode
+*   Effects    : Decoded symbols are written to out
+*   Returned   : 0 for success, -1 if the coded data is bad.
+***************************************************************************/
+int HuffDecode(huff_table_t *table, const unsigned char *in, size_t inLen,
+    unsigned char *out, size_t count)
+{
+    unsigned char lengths[NUM_SYMBOLS];
+    const huff_entry_t *entry;
+    unsigned long acc;
+    unsigned int bits;
+    size_t i, pos, pad;
+
+    if (inLen < HUFF_HEADER)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < HUFF_HEADER; i++)
+    {
+        lengths[2 * i] = in[i] & 0x0F;
+        lengths[2 * i + 1] = in[i] >> 4;
+    }
+
+    if (BuildTable(table, lengths))
+    {
+        return -1;
+    }
+
+    pos = HUFF_HEADER;
+    pad = 0;
+    acc = 0;
+    bits = 0;
+    i = 0;
+
+    while (i < count)
+    {
+        /* top up the accumulator, padding with zeros past the end */
+        while (bits <= 24)
+        {
+            if (pos < inLen)
+            {
+                acc = (acc << 8) | in[pos++];
+            }
+            else
+            {
+                acc <<= 8;
+                pad++;
+            }
+
+            bits += 8;
+        }
+
+        if ((count - i) >= 2)
+        {
+            entry = &table->multi[(acc >> (bits - HUFF_MAX_BITS)) &
+                INDEX_MASK];
+            out[i] = entry->symbol[0];
+            out[i + 1] = entry->symbol[1];
+            bits -= entry->bits;
+        }
+        else
+        {
+            entry = &table->single[(acc >> (bits - HUFF_MAX_BITS)) &
+                INDEX_MASK];
+            out[i] = entry->symbol[0];
+            bits -= entry->firstBits;
+        }
+
+        if (0 == entry->count)
+        {
+            return -1;
+        }
+
+        i += entry->count;
+    }
+
+    /* the padding must not have been used */
+    return ((pad * 8) > bits) ? -1 : 0;
+}
+
+/***************************************************************************
+*   Function   : BuildLengths
+*   Description: This routine finds the Huffman code length of every
+*                symbol.  If the tree is deeper than HUFF_MAX_BITS, the
+*                frequencies are halved (keeping used symbols non-zero)
+*                until it isn't.  A lone symbol gets a 1 bit code.
+*   Parameters : freq - Frequency of each symbol
+*                lengths - Set to the code length of each symbol (0 for
+*                          unused symbols)
+*   Effects    : lengths is filled in
+*   Returned   : None
+***************************************************************************/
+static void BuildLengths(const unsigned long *freq, unsigned char *lengths)
+{
+    unsigned long scaled[NUM_SYMBOLS];
+    int i;
+
+    memcpy(scaled, freq, sizeof(scaled));
+
+    while (TreeLengths(scaled, lengths) > HUFF_MAX_BITS)
+    {
+        for (i = 0; i < NUM_SYMBOLS; i++)
+        {
+            scaled[i] = (scaled[i] + 1) / 2;
+        }
+    }
+}
+
+/***************************************************************************
+*   Function   : TreeLengths
+*   Description: This routine builds a Huffman tree by repeatedly joining
+*                the two lightest nodes, then sets each symbol's code
+*                length to its depth.  The alphabet is small enough that a
+*                linear search for the lightest nodes is fine.
+*   Parameters : freq - Frequency of each symbol
+*                lengths - Set to the code length of each symbol
+*   Effects    : lengths is filled in
+*   Returned   : The longest code length
+***************************************************************************/
+static int TreeLengths(const unsigned long *freq, unsigned char *lengths)
+{
+    unsigned long weight[MAX_NODES];
+    int parent[MAX_NODES];
+    int live[MAX_NODES];
+    int symbol[NUM_SYMBOLS];
+    int nodes, leaves, remaining, i, maxLen;
+
+    leaves = 0;
+
+    for (i = 0; i < NUM_SYMBOLS; i++)
+    {
+        lengths[i] = 0;
+
+        if (freq[i] > 0)
+        {
+            weight[leaves] = freq[i];
+            parent[leaves] = -1;
+            live[leaves] = 1;
+            symbol[leaves] = i;
+            leaves++;
+        }
+    }
+
+    if (leaves <= 1)
+    {
+        if (1 == leaves)
+        {
+            lengths[symbol[0]] = 1;
+        }
+
+        return leaves;
+    }
+
+    nodes = leaves;
+
+    for (remaining = leaves; remaining > 1; remaining--)
+    {
+        int a, b;
+
+        a = -1;
+        b = -1;
+
+        for (i = 0; i < nodes; i++)
+        {
+            if (!live[i])
+            {
+                continue;
+            }
+
+            if ((a < 0) || (weight[i] < weight[a]))
+            {
+                b = a;
+                a = i;
+            }
+            else if ((b < 0) || (weight[i] < weight[b]))
+            {
+                b = i;
+            }
+        }
+
+        weight[nodes] = weight[a] + weight[b];
+        parent[nodes] = -1;
+        live[nodes] = 1;
+        parent[a] = nodes;
+        parent[b] = nodes;
+        live[a] = 0;
+        live[b] = 0;
+        nodes++;
+    }
+
+    maxLen = 0;
+
+    for (i = 0; i < leaves; i++)
+    {
+        int depth, n;
+
+        depth = 0;
+
+        for (n = i; parent[n] >= 0; n = parent[n])
+        {
+            depth++;
+        }
+
+        /* too deep is reported, but must not overflow a nibble */
+        lengths[symbol[i]] = (unsigned char)((depth < 15) ? depth : 15);
+
+        if (depth > maxLen)
+        {
+            maxLen = depth;
+        }
+    }
+
+    return maxLen;
+}
+
+/***************************************************************************
+*   Function   : AssignCodes
+*   Description: This routine assigns canonical codes: shorter codes come
+*                first, and codes of the same length are in symbol order.
+*   Parameters : lengths - Code length of each symbol
+*                codes - Set to the code of each symbol
+*   Effects    : codes is filled in
+*   Returned   : None
+***************************************************************************/
+static void AssignCodes(const unsigned char *lengths, unsigned int *codes)
+{
+    unsigned int count[16];
+    unsigned int next[16];
+    unsigned int code;
+    int i;
+
+    memset(count, 0, sizeof(count));
+
+    for (i = 0; i < NUM_SYMBOLS; i++)
+    {
+        count[lengths[i]]++;
+    }
+
+    count[0] = 0;
+    code = 0;
+
+    for (i = 1; i < 16; i++)
+    {
+        code = (code + count[i - 1]) << 1;
+        next[i] = code;
+    }
+
+    for (i = 0; i < NUM_SYMBOLS; i++)
+    {
+        codes[i] = (0 == lengths[i]) ? 0 : next[lengths[i]]++;
+    }
+}
+
+/***************************************************************************
+*   Function   : BuildTable
+*   Description: This routine builds the decode tables for a set of code
+*                lengths.  Each single table entry holds the symbol whose
+*                code starts its index.  Each multi table entry adds the
+*                symbol that follows if its code also fits in the index.
+*                Indices that no code starts are left with a count of 0.
+*   Parameters : table - Tables being built
+*                lengths - Code length of each symbol
+*   Effects    : table is filled in
+*   Returned   : 0 for success, -1 if the lengths aren't a prefix code.
+***************************************************************************/
+static int BuildTable(huff_table_t *table, const unsigned char *lengths)
+{
+    unsigned int codes[NUM_SYMBOLS];
+    int i;
+
+    AssignCodes(lengths, codes);
+    memset(table->single, 0, sizeof(table->single));
+
+    for (i = 0; i < NUM_SYMBOLS; i++)
+    {
+        unsigned int len, first, span, k;
+
+        len = lengths[i];
+
+        if (0 == len)
+        {
+            continue;
+        }
+
+        if ((len > HUFF_MAX_BITS) || (codes[i] >= (1U << len)))
+        {
+            return -1;          /* too long, or more codes than fit */
+        }
+
+        first = codes[i] << (HUFF_MAX_BITS - len);
+        span = 1U << (HUFF_MAX_BITS - len);
+
+        for (k = 0; k < span; k++)
+        {
+            huff_entry_t *entry;
+
+            entry = &table->single[first + k];
+            entry->symbol[0] = (unsigned char)i;
+            entry->count = 1;
+            entry->firstBits = (unsigned char)len;
+            entry->bits = (unsigned char)len;
+        }
+    }
+
+    for (i = 0; i < HUFF_TABLE_SIZE; i++)
+    {
+        const huff_entry_t *next;
+        huff_entry_t *entry;
+
+        entry = &table->multi[i];
+        *entry = table->single[i];
+
+        if (0 == entry->count)
+        {
+            continue;
+        }
+
+        /* the bits after the first code start the second one */
+        next = &table->single[(i << entry->firstBits) & INDEX_MASK];
+
+        if ((0 != next->count) &&
+            (next->firstBits <= (HUFF_MAX_BITS - entry->firstBits)))
+        {
+            entry->symbol[1] = next->symbol[0];
+            entry->count = 2;
+            entry->bits = entry->firstBits + next->firstBits;
+        }
+    }
+
+    return 0;
+}
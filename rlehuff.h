@@ -0,0 +1,81 @@
+/***************************************************************************
+*                   Header for Huffman Entropy Coding Routines
+*
+*   File    : rlehuff.h
+*   Purpose : Provides the internal interface to the Huffman coder used by
+*             the block container to squeeze the token streams produced by
+*             the run length encoders.  This header is not part of the
+*             public library interface.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+#ifndef _RLEHUFF_H_
+#define _RLEHUFF_H_
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stddef.h>
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define HUFF_MAX_BITS   11              /* longest code (and table index) */
+#define HUFF_TABLE_SIZE (1 << HUFF_MAX_BITS)
+#define HUFF_HEADER     128             /* bytes of code lengths */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/* a decode table entry.  it holds every symbol whose code fits entirely in
+ * the HUFF_MAX_BITS bits used to look it up (up to 2). */
+typedef struct
+{
+    unsigned char symbol[2];            /* decoded symbols */
+    unsigned char count;                /* symbols decoded (0 = bad code) */
+    unsigned char firstBits;            /* bits used by symbol[0] */
+    unsigned char bits;                 /* bits used by all symbols */
+} huff_entry_t;
+
+typedef struct
+{
+    huff_entry_t single[HUFF_TABLE_SIZE];   /* one symbol per entry */
+    huff_entry_t multi[HUFF_TABLE_SIZE];    /* up to two per entry */
+} huff_table_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+
+/* code len bytes.  returns the coded size or 0 if it won't be smaller */
+size_t HuffEncode(const unsigned char *data, size_t len, unsigned char *out);
+
+/* decode count symbols.  returns 0 for success or -1 for bad data */
+int HuffDecode(huff_table_t *table, const unsigned char *in, size_t inLen,
+    unsigned char *out, size_t count);
+
+#endif  /* ndef _RLEHUFF_H_ */
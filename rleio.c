@@ -0,0 +1,1138 @@
+/***************************************************************************
+*                    Buffered Source and Sink Stream Library
+*
+*   File    : rleio.c
+*   Purpose : Provide the buffered streams used by the codecs to read from
+*             an rle_source_t and write to an rle_sink_t, along with
+*             sources and sinks for FILE streams and memory buffers, and a
+*             tap that reports the progress of any source and sink.  When
+*             a source or sink can lend its own memory, the streams work
+*             directly in that memory and nothing is copied.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int FileRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got);
+static int FileWrite(void *handle, const unsigned char *buf, size_t size);
+static int BufferRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got);
+static int BufferLend(void *handle, const unsigned char **buf, size_t *got);
+static int BufferWrite(void *handle, const unsigned char *buf, size_t size);
+static int BufferBorrow(void *handle, unsigned char **buf, size_t *size);
+static int BufferCommit(void *handle, size_t used);
+static int TapRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got);
+static int TapLend(void *handle, const unsigned char **buf, size_t *got);
+static int TapWrite(void *handle, const unsigned char *buf, size_t size);
+static int TapBorrow(void *handle, unsigned char **buf, size_t *size);
+static int TapCommit(void *handle, size_t used);
+static int TapCheck(rle_progress_tap_t *tap);
+static void TapReport(rle_progress_tap_t *tap);
+static void StepIntoHeld(in_stream_t *in);
+static void OutFail(out_stream_t *out);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleFileSource
+*   Description: This routine sets up a source that reads from a FILE
+*                stream.
+*   Parameters : source - Pointer to the source being set up
+*                file - Pointer to the opened file to read from
+*   Effects    : source reads from file
+*   Returned   : None
+***************************************************************************/
+void RleFileSource(rle_source_t *source, FILE *file)
+{
+    source->handle = file;
+    source->read = FileRead;
+    source->borrow = NULL;
+}
+
+/***************************************************************************
+*   Function   : RleFileSink
+*   Description: This routine sets up a sink that writes to a FILE stream.
+*   Parameters : sink - Pointer to the sink being set up
+*                file - Pointer to the opened file to write to
+*   Effects    : sink writes to file
+*   Returned   : None
+***************************************************************************/
+void RleFileSink(rle_sink_t *sink, FILE *file)
+{
+    sink->handle = file;
+    sink->write = FileWrite;
+    sink->borrow = NULL;
+    sink->commit = NULL;
+}
+
+/***************************************************************************
+*   Function   : RleBufferSource
+*   Description: This routine sets up a source that reads the bytes of a
+*                memory buffer from buffer->pos to buffer->size.  The
+*                memory is lent to the codec, so it is not copied.
+*   Parameters : source - Pointer to the source being set up
+*                buffer - Pointer to the memory to read from
+*   Effects    : source reads from buffer.  buffer->pos is advanced as
+*                data is read.
+*   Returned   : None
+***************************************************************************/
+void RleBufferSource(rle_source_t *source, rle_buffer_t *buffer)
+{
+    source->handle = buffer;
+    source->read = BufferRead;
+    source->borrow = BufferLend;
+}
+
+/***************************************************************************
+*   Function   : RleBufferSink
+*   Description: This routine sets up a sink that writes to a memory buffer
+*                starting at buffer->pos.  Codecs write directly into the
+*                memory.  Running out of space is an error (ENOSPC).
+*   Parameters : sink - Pointer to the sink being set up
+*                buffer - Pointer to the memory to write to
+*   Effects    : sink writes to buffer.  buffer->pos is advanced as data is
+*                written.
+*   Returned   : None
+***************************************************************************/
+void RleBufferSink(rle_sink_t *sink, rle_buffer_t *buffer)
+{
+    sink->handle = buffer;
+    sink->write = BufferWrite;
+    sink->borrow = BufferBorrow;
+    sink->commit = BufferCommit;
+}
+
+/***************************************************************************
+*   Function   : RleProgressTap
+*   Description: This routine sets up a source and sink that pass data
+*                through to another source and sink, counting the bytes
+*                that go by.  The callback is called when another interval
+*                bytes have been read and written, between chunks of data,
+*                so it costs nothing per byte.  If it returns non-zero, the
+*                next read fails with ECANCELED.  Encoders and decoders
+*                only fail at a read, after writing the complete results of
+*                everything read before it, so a cancelled codec leaves
+*                valid output for a prefix of its input.
+*   Parameters : tap - Pointer to the tap being set up.  Give the codec
+*                      &tap->source and &tap->sink.
+*                source - Pointer to the source being reported on
+*                sink - Pointer to the sink being reported on
+*                interval - Bytes read and written between callbacks
+*                callback - Function receiving the byte counts
+*                userData - Passed to the callback
+*   Effects    : tap is ready for use.  tap->consumed and tap->produced
+*                hold the totals once the codec returns.
+*   Returned   : None
+***************************************************************************/
+void RleProgressTap(rle_progress_tap_t *tap, rle_source_t *source,
+    rle_sink_t *sink, unsigned long interval, rle_progress_t callback,
+    void *userData)
+{
+    tap->source.handle = tap;
+    tap->source.read = TapRead;
+    tap->source.borrow = (NULL != source->borrow) ? TapLend : NULL;
+    tap->sink.handle = tap;
+    tap->sink.write = TapWrite;
+    tap->sink.borrow = (NULL != sink->borrow) ? TapBorrow : NULL;
+    tap->sink.commit = (NULL != sink->borrow) ? TapCommit : NULL;
+    tap->wrappedSource = source;
+    tap->wrappedSink = sink;
+    tap->callback = callback;
+    tap->userData = userData;
+    tap->interval = interval;
+    tap->consumed = 0;
+    tap->produced = 0;
+    tap->next = interval;
+    tap->cancelled = 0;
+    tap->held = NULL;
+    tap->heldLen = 0;
+}
+
+/***************************************************************************
+*   Function   : InitInStream
+*   Description: This routine prepares an input stream for reading from a
+*                source.
+*   Parameters : in - Pointer to the stream being initialized
+*                source - Pointer to the source of data
+*                buf - Buffer used when source can't lend its data
+*                bufSize - Size of buf (at least IN_CARRY_SIZE)
+*   Effects    : in is ready for reading
+*   Returned   : None
+***************************************************************************/
+void InitInStream(in_stream_t *in, rle_source_t *source, unsigned char *buf,
+    size_t bufSize)
+{
+    in->source = source;
+    in->next = buf;
+    in->end = buf;
+    in->heldNext = NULL;
+    in->heldEnd = NULL;
+    in->mirror = NULL;
+    in->buf = buf;
+    in->bufSize = bufSize;
+    in->eof = 0;
+}
+
+/***************************************************************************
+*   Function   : InFill
+*   Description: This routine makes the next chunk of input available
+*                between in->next and in->end.  It should only be called
+*                after all of the current chunk has been used.
+*   Parameters : in - Pointer to the input stream
+*   Effects    : Data may be read or borrowed from the source
+*   Returned   : 1 if data is available, 0 at the end of the data, and -1
+*                for failure (errno will be set).
+***************************************************************************/
+int InFill(in_stream_t *in)
+{
+    size_t got;
+
+    if (NULL != in->mirror)
+    {
+        StepIntoHeld(in);
+
+        if (in->next < in->end)
+        {
+            return 1;
+        }
+    }
+
+    if (in->eof)
+    {
+        return 0;
+    }
+
+    if (NULL != in->source->borrow)
+    {
+        const unsigned char *chunk;
+
+        if (in->source->borrow(in->source->handle, &chunk, &got))
+        {
+            return -1;
+        }
+
+        if (got > 0)
+        {
+            in->next = chunk;
+            in->end = chunk + got;
+        }
+    }
+    else
+    {
+        if (in->source->read(in->source->handle, in->buf, in->bufSize,
+            &got))
+        {
+            return -1;
+        }
+
+        in->next = in->buf;
+        in->end = in->buf + got;
+    }
+
+    if (0 == got)
+    {
+        in->eof = 1;
+        in->next = in->end;
+        return 0;
+    }
+
+    return 1;
+}
+
+/***************************************************************************
+*   Function   : InRead
+*   Description: This routine copies up to len bytes of input to a buffer.
+*                Fewer bytes are only copied if the end of the data is
+*                reached.
+*   Parameters : in - Pointer to the input stream
+*                buf - Buffer receiving the data
+*                len - Number of bytes wanted
+*                got - Set to the number of bytes copied
+*   Effects    : Data may be read or borrowed from the source
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+int InRead(in_stream_t *in, unsigned char *buf, size_t len, size_t *got)
+{
+    *got = 0;
+
+    while (*got < len)
+    {
+        size_t n;
+
+        if (in->next == in->end)
+        {
+            int result;
+
+            result = InFill(in);
+
+            if (result <= 0)
+            {
+                return result;
+            }
+        }
+
+        n = in->end - in->next;
+
+        if (n > (len - *got))
+        {
+            n = len - *got;
+        }
+
+        memcpy(buf + *got, in->next, n);
+        in->next += n;
+        *got += n;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : InEnsure
+*   Description: This routine makes sure that at least need contiguous
+*                bytes are readable at in->next, unless the end of the data
+*                is reached first.  Read buffers are compacted and
+*                refilled.  Bytes that straddle two borrowed chunks are
+*                joined in a small carry buffer; once the bytes copied from
+*                the second chunk are reached, reading continues in that
+*                chunk itself.
+*   Parameters : in - Pointer to the input stream
+*                need - Number of bytes required (at most IN_CARRY_SIZE)
+*   Effects    : Data may be read or borrowed from the source
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+int InEnsure(in_stream_t *in, size_t need)
+{
+    size_t avail;
+    size_t n;
+
+    if ((NULL != in->mirror) && (in->next >= in->mirror))
+    {
+        StepIntoHeld(in);
+    }
+
+    avail = in->end - in->next;
+
+    if (avail >= need)
+    {
+        return 0;
+    }
+
+    if (0 == avail)
+    {
+        int result;
+
+        result = InFill(in);
+
+        if (result <= 0)
+        {
+            return result;
+        }
+
+        avail = in->end - in->next;
+
+        if (avail >= need)
+        {
+            return 0;
+        }
+    }
+
+    if (in->eof)
+    {
+        return 0;
+    }
+
+    if (NULL == in->source->borrow)
+    {
+        /* slide unread bytes to the front of the buffer and read more */
+        memmove(in->buf, in->next, avail);
+        n = avail;
+
+        while ((n < need) && !in->eof)
+        {
+            size_t got;
+
+            if (in->source->read(in->source->handle, in->buf + n,
+                in->bufSize - n, &got))
+            {
+                return -1;
+            }
+
+            n += got;
+            in->eof = (0 == got);
+        }
+
+        in->next = in->buf;
+        in->end = in->buf + n;
+        return 0;
+    }
+
+    /* join the end of this chunk with the start of the next one */
+    n = (NULL != in->mirror) ? (size_t)(in->mirror - in->next) : avail;
+    memmove(in->carry, in->next, n);
+    in->mirror = NULL;
+    in->next = in->carry;
+    in->end = in->carry + n;
+
+    while (n < need)
+    {
+        size_t k;
+
+        if (NULL == in->heldNext)
+        {
+            const unsigned char *chunk;
+            size_t got;
+
+            if (in->source->borrow(in->source->handle, &chunk, &got))
+            {
+                return -1;
+            }
+
+            if (0 == got)
+            {
+                in->eof = 1;
+                break;
+            }
+
+            in->heldNext = chunk;
+            in->heldEnd = chunk + got;
+        }
+
+        k = in->heldEnd - in->heldNext;
+
+        if (k <= (need - n))
+        {
+            /* the whole chunk fits in the carry */
+            memcpy(in->carry + n, in->heldNext, k);
+            n += k;
+            in->heldNext = NULL;
+            in->heldEnd = NULL;
+        }
+        else
+        {
+            /* copy just enough, the chunk is used directly afterwards */
+            memcpy(in->carry + n, in->heldNext, need - n);
+            in->mirror = in->carry + n;
+            n = need;
+        }
+    }
+
+    in->end = in->carry + n;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : TapRead
+*   Description: This routine is the read callback of a progress tap.
+*   Parameters : handle - The rle_progress_tap_t being read
+*                buf - Buffer receiving the data
+*                size - Size of buf
+*                got - Set to the number of bytes read
+*   Effects    : Data is read from the wrapped source
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int TapRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got)
+{
+    rle_progress_tap_t *tap;
+
+    tap = (rle_progress_tap_t *)handle;
+
+    if (TapCheck(tap) ||
+        tap->wrappedSource->read(tap->wrappedSource->handle, buf, size, got))
+    {
+        return -1;
+    }
+
+    tap->consumed += *got;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : TapLend
+*   Description: This routine is the borrow callback of a progress tap.
+*                Lent chunks are passed on at most IO_BUF_SIZE bytes at a
+*                time, so a source that lends all of its data at once is
+*                still reported on (and can be cancelled) as it is used.
+*   Parameters : handle - The rle_progress_tap_t being read
+*                buf - Set to point to the next chunk of data
+*                got - Set to the size of the chunk
+*   Effects    : Data may be borrowed from the wrapped source
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int TapLend(void *handle, const unsigned char **buf, size_t *got)
+{
+    rle_progress_tap_t *tap;
+
+    tap = (rle_progress_tap_t *)handle;
+
+    if (TapCheck(tap))
+    {
+        return -1;
+    }
+
+    if ((0 == tap->heldLen) &&
+        tap->wrappedSource->borrow(tap->wrappedSource->handle, &tap->held,
+        &tap->heldLen))
+    {
+        return -1;
+    }
+
+    *buf = tap->held;
+    *got = (tap->heldLen < IO_BUF_SIZE) ? tap->heldLen : IO_BUF_SIZE;
+    tap->held += *got;
+    tap->heldLen -= *got;
+    tap->consumed += *got;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : TapWrite, TapBorrow, TapCommit
+*   Description: These routines are the sink callbacks of a progress tap.
+*                Writes are never refused, a cancel takes effect at the
+*                next read.  Borrowed space is passed on at most
+*                IO_BUF_SIZE bytes at a time, so a sink that lends all of
+*                its space at once is committed to, and its output
+*                counted, as it is used instead of only when the codec
+*                finishes.
+*   Parameters : handle - The rle_progress_tap_t being written
+*                buf - Data to write, or set to the borrowed space
+*                size - Number of bytes to write, or set to the size of
+*                       the borrowed space
+*                used - Number of borrowed bytes that were written
+*   Effects    : Data is passed to the wrapped sink
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int TapWrite(void *handle, const unsigned char *buf, size_t size)
+{
+    rle_progress_tap_t *tap;
+
+    tap = (rle_progress_tap_t *)handle;
+
+    if (tap->wrappedSink->write(tap->wrappedSink->handle, buf, size))
+    {
+        return -1;
+    }
+
+    tap->produced += size;
+    TapReport(tap);
+    return 0;
+}
+
+static int TapBorrow(void *handle, unsigned char **buf, size_t *size)
+{
+    rle_progress_tap_t *tap;
+
+    tap = (rle_progress_tap_t *)handle;
+
+    if (tap->wrappedSink->borrow(tap->wrappedSink->handle, buf, size))
+    {
+        return -1;
+    }
+
+    if (*size > IO_BUF_SIZE)
+    {
+        *size = IO_BUF_SIZE;
+    }
+
+    return 0;
+}
+
+static int TapCommit(void *handle, size_t used)
+{
+    rle_progress_tap_t *tap;
+
+    tap = (rle_progress_tap_t *)handle;
+
+    if (tap->wrappedSink->commit(tap->wrappedSink->handle, used))
+    {
+        return -1;
+    }
+
+    tap->produced += used;
+    TapReport(tap);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : TapCheck
+*   Description: This routine is called before each read from a progress
+*                tap.  It reports progress if it is due and refuses the
+*                read once the callback has asked to cancel.
+*   Parameters : tap - Pointer to the tap
+*   Effects    : The callback may be called
+*   Returned   : 0 if the read may go ahead, -1 if the codec was cancelled
+*                (errno will be set to ECANCELED).
+***************************************************************************/
+static int TapCheck(rle_progress_tap_t *tap)
+{
+    TapReport(tap);
+
+    if (tap->cancelled)
+    {
+        errno = ECANCELED;
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : TapReport
+*   Description: This routine calls a progress tap's callback if another
+*                interval bytes have been read and written since the last
+*                call.
+*   Parameters : tap - Pointer to the tap
+*   Effects    : The callback may be called and may cancel the codec
+*   Returned   : None
+***************************************************************************/
+static void TapReport(rle_progress_tap_t *tap)
+{
+    unsigned long total;
+
+    total = tap->consumed + tap->produced;
+
+    if ((total >= tap->next) && !tap->cancelled)
+    {
+        tap->next = total + tap->interval;
+
+        if (tap->callback(tap->consumed, tap->produced, tap->userData))
+        {
+            tap->cancelled = 1;
+        }
+    }
+}
+
+/***************************************************************************
+*   Function   : StepIntoHeld
+*   Description: This routine moves an input stream that has reached the
+*                carry bytes copied from a held chunk into the held chunk
+*                itself.
+*   Parameters : in - Pointer to the input stream
+*   Effects    : in->next and in->end point into the held chunk
+*   Returned   : None
+***************************************************************************/
+static void StepIntoHeld(in_stream_t *in)
+{
+    in->next = in->heldNext + (in->next - in->mirror);
+    in->end = in->heldEnd;
+    in->heldNext = NULL;
+    in->heldEnd = NULL;
+    in->mirror = NULL;
+}
+
+/***************************************************************************
+*   Function   : InitOutStream
+*   Description: This routine prepares an output stream for writing to a
+*                sink.
+*   Parameters : out - Pointer to the stream being initialized
+*                sink - Pointer to the sink receiving data
+*                buf - Buffer used when sink can't lend its memory
+*                bufSize - Size of buf
+*   Effects    : out is ready for writing
+*   Returned   : None
+***************************************************************************/
+void InitOutStream(out_stream_t *out, rle_sink_t *sink, unsigned char *buf,
+    size_t bufSize)
+{
+    out->sink = sink;
+    out->start = buf;
+    out->next = buf;
+    out->end = buf;
+    out->buf = buf;
+    out->bufSize = bufSize;
+    out->lent = 0;
+    out->error = 0;
+}
+
+/***************************************************************************
+*   Function   : OpenStreams
+*   Description: This routine prepares an input and an output stream for
+*                one codec call, allocating their IO_BUF_SIZE buffers from
+*                the heap instead of the caller's stack.  Buffers are only
+*                allocated for a source that can't lend its data and a sink
+*                that can't lend its memory, so memory to memory calls
+*                allocate nothing.
+*   Parameters : in - Pointer to the input stream being initialized
+*                source - Pointer to the source supplying data
+*                out - Pointer to the output stream being initialized
+*                sink - Pointer to the sink receiving data
+*   Effects    : in and out are ready for use.  CloseStreams must be
+*                called when they are no longer needed.
+*   Returned   : 0 for success, -1 for failure (errno will be set to
+*                ENOMEM).
+***************************************************************************/
+int OpenStreams(in_stream_t *in, rle_source_t *source, out_stream_t *out,
+    rle_sink_t *sink)
+{
+    unsigned char *buf;
+    size_t inSize, outSize;
+
+    inSize = (NULL == source->borrow) ? IO_BUF_SIZE : 0;
+    outSize = (NULL == sink->borrow) ? IO_BUF_SIZE : 0;
+    buf = NULL;
+
+    if ((inSize + outSize) > 0)
+    {
+        buf = (unsigned char *)malloc(inSize + outSize);
+
+        if (NULL == buf)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+
+    InitInStream(in, source, buf, inSize);
+    InitOutStream(out, sink, (NULL != buf) ? (buf + inSize) : NULL,
+        outSize);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : CloseStreams
+*   Description: This routine frees the buffers allocated by OpenStreams.
+*                It doesn't flush out.
+*   Parameters : in - Pointer to the input stream
+*                out - Pointer to the output stream
+*   Effects    : The stream buffers are freed
+*   Returned   : None
+***************************************************************************/
+void CloseStreams(in_stream_t *in, out_stream_t *out)
+{
+    /* the buffers were allocated together, input first */
+    if (in->bufSize > 0)
+    {
+        free(in->buf);
+    }
+    else if (out->bufSize > 0)
+    {
+        free(out->buf);
+    }
+}
+
+/***************************************************************************
+*   Function   : OutFlush
+*   Description: This routine hands all buffered output to the sink and
+*                makes new space available for writing.
+*   Parameters : out - Pointer to the output stream
+*   Effects    : Data is written or committed to the sink
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+int OutFlush(out_stream_t *out)
+{
+    size_t used;
+
+    if (out->error)
+    {
+        return -1;
+    }
+
+    used = out->next - out->start;
+
+    if (NULL != out->sink->borrow)
+    {
+        unsigned char *space;
+        size_t size;
+
+        if (out->lent && out->sink->commit(out->sink->handle, used))
+        {
+            OutFail(out);
+            return -1;
+        }
+
+        out->lent = 0;
+
+        if (out->sink->borrow(out->sink->handle, &space, &size))
+        {
+            OutFail(out);
+            return -1;
+        }
+
+        if (0 == size)
+        {
+            errno = ENOSPC;
+            OutFail(out);
+            return -1;
+        }
+
+        out->start = space;
+        out->next = space;
+        out->end = space + size;
+        out->lent = 1;
+    }
+    else
+    {
+        if ((used > 0) &&
+            out->sink->write(out->sink->handle, out->start, used))
+        {
+            OutFail(out);
+            return -1;
+        }
+
+        out->start = out->buf;
+        out->next = out->buf;
+        out->end = out->buf + out->bufSize;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : OutFinish
+*   Description: This routine hands all buffered output to the sink without
+*                asking it for more space.  It is called once a codec has
+*                written all of its output.
+*   Parameters : out - Pointer to the output stream
+*   Effects    : Data is written or committed to the sink
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+int OutFinish(out_stream_t *out)
+{
+    size_t used;
+    int result;
+
+    if (out->error)
+    {
+        return -1;
+    }
+
+    used = out->next - out->start;
+    result = 0;
+
+    if (out->lent)
+    {
+        result = out->sink->commit(out->sink->handle, used);
+    }
+    else if (used > 0)
+    {
+        result = out->sink->write(out->sink->handle, out->start, used);
+    }
+
+    out->lent = 0;
+    out->start = out->buf;
+    out->next = out->buf;
+    out->end = out->buf;
+
+    if (result)
+    {
+        out->error = 1;
+    }
+
+    return result ? -1 : 0;
+}
+
+/***************************************************************************
+*   Function   : OutPutc
+*   Description: This routine writes one byte when an output stream has no
+*                space left.  It is the slow path of OUT_PUTC.
+*   Parameters : out - Pointer to the output stream
+*                c - The byte to write
+*   Effects    : The stream is flushed and c is written
+*   Returned   : None (failures are recorded in out->error)
+***************************************************************************/
+void OutPutc(out_stream_t *out, unsigned char c)
+{
+    if (0 == OutFlush(out))
+    {
+        *out->next++ = c;
+    }
+}
+
+/***************************************************************************
+*   Function   : OutWrite
+*   Description: This routine writes a block of bytes to an output stream.
+*                Blocks larger than the stream's buffer are handed straight
+*                to a sink that copies its data anyway.
+*   Parameters : out - Pointer to the output stream
+*                data - Pointer to the bytes to write
+*                len - Number of bytes to write
+*   Effects    : Data is written to the stream
+*   Returned   : None (failures are recorded in out->error)
+***************************************************************************/
+void OutWrite(out_stream_t *out, const unsigned char *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t space;
+
+        space = out->end - out->next;
+
+        if (0 == space)
+        {
+            if (OutFlush(out))
+            {
+                return;
+            }
+
+            if ((NULL == out->sink->borrow) && (len >= out->bufSize))
+            {
+                if (out->sink->write(out->sink->handle, data, len))
+                {
+                    OutFail(out);
+                }
+
+                return;
+            }
+
+            continue;
+        }
+
+        if (space > len)
+        {
+            space = len;
+        }
+
+        memcpy(out->next, data, space);
+        out->next += space;
+        data += space;
+        len -= space;
+    }
+}
+
+/***************************************************************************
+*   Function   : OutFill
+*   Description: This routine writes len copies of a byte to an output
+*                stream.
+*   Parameters : out - Pointer to the output stream
+*                c - The byte to write
+*                len - Number of copies to write
+*   Effects    : Data is written to the stream
+*   Returned   : None (failures are recorded in out->error)
+***************************************************************************/
+void OutFill(out_stream_t *out, unsigned char c, size_t len)
+{
+    while (len > 0)
+    {
+        size_t space;
+
+        space = out->end - out->next;
+
+        if (0 == space)
+        {
+            if (OutFlush(out))
+            {
+                return;
+            }
+
+            continue;
+        }
+
+        if (space > len)
+        {
+            space = len;
+        }
+
+        memset(out->next, c, space);
+        out->next += space;
+        len -= space;
+    }
+}
+
+/***************************************************************************
+*   Function   : OutFail
+*   Description: This routine records a failure in an output stream and
+*                leaves it with no writable space, so every further write
+*                takes the slow path and is discarded.
+*   Parameters : out - Pointer to the output stream
+*   Effects    : out->error is set
+*   Returned   : None
+***************************************************************************/
+static void OutFail(out_stream_t *out)
+{
+    out->error = 1;
+    out->lent = 0;
+    out->start = out->buf;
+    out->next = out->buf;
+    out->end = out->buf;
+}
+
+/***************************************************************************
+*   Function   : FileRead
+*   Description: Source read callback for FILE streams.
+*   Parameters : handle - The FILE being read
+*                buf - Buffer receiving the data
+*                size - Size of buf
+*                got - Set to the number of bytes read
+*   Effects    : Data is read from the file
+*   Returned   : 0 for success, -1 for a read error.
+***************************************************************************/
+static int FileRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got)
+{
+    *got = fread(buf, sizeof(unsigned char), size, (FILE *)handle);
+
+    if ((*got < size) && ferror((FILE *)handle))
+    {
+        errno = (0 != errno) ? errno : EIO;
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : FileWrite
+*   Description: Sink write callback for FILE streams.
+*   Parameters : handle - The FILE being written
+*                buf - Data to write
+*                size - Number of bytes to write
+*   Effects    : Data is written to the file
+*   Returned   : 0 for success, -1 for a write error.
+***************************************************************************/
+static int FileWrite(void *handle, const unsigned char *buf, size_t size)
+{
+    if (fwrite(buf, sizeof(unsigned char), size, (FILE *)handle) != size)
+    {
+        errno = (0 != errno) ? errno : EIO;
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : BufferRead
+*   Description: Source read callback for memory buffers.
+*   Parameters : handle - The rle_buffer_t being read
+*                buf - Buffer receiving the data
+*                size - Size of buf
+*                got - Set to the number of bytes copied
+*   Effects    : Data is copied and the buffer position advances
+*   Returned   : 0
+***************************************************************************/
+static int BufferRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got)
+{
+    rle_buffer_t *buffer;
+
+    buffer = (rle_buffer_t *)handle;
+    *got = buffer->size - buffer->pos;
+
+    if (*got > size)
+    {
+        *got = size;
+    }
+
+    memcpy(buf, buffer->data + buffer->pos, *got);
+    buffer->pos += *got;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : BufferLend
+*   Description: Source borrow callback for memory buffers.  Everything
+*                left in the buffer is lent at once.
+*   Parameters : handle - The rle_buffer_t being read
+*                buf - Set to the unread data
+*                got - Set to the number of unread bytes
+*   Effects    : The buffer position advances to its end
+*   Returned   : 0
+***************************************************************************/
+static int BufferLend(void *handle, const unsigned char **buf, size_t *got)
+{
+    rle_buffer_t *buffer;
+
+    buffer = (rle_buffer_t *)handle;
+    *buf = buffer->data + buffer->pos;
+    *got = buffer->size - buffer->pos;
+    buffer->pos = buffer->size;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : BufferWrite
+*   Description: Sink write callback for memory buffers.
+*   Parameters : handle - The rle_buffer_t being written
+*                buf - Data to write
+*                size - Number of bytes to write
+*   Effects    : Data is copied and the buffer position advances
+*   Returned   : 0 for success, -1 (ENOSPC) if the data doesn't fit.
+***************************************************************************/
+static int BufferWrite(void *handle, const unsigned char *buf, size_t size)
+{
+    rle_buffer_t *buffer;
+
+    buffer = (rle_buffer_t *)handle;
+
+    if (size > (buffer->size - buffer->pos))
+    {
+        errno = ENOSPC;
+        return -1;
+    }
+
+    memcpy(buffer->data + buffer->pos, buf, size);
+    buffer->pos += size;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : BufferBorrow
+*   Description: Sink borrow callback for memory buffers.  All unused space
+*                is lent at once.
+*   Parameters : handle - The rle_buffer_t being written
+*                buf - Set to the unused space
+*                size - Set to the amount of unused space
+*   Effects    : None
+*   Returned   : 0
+***************************************************************************/
+static int BufferBorrow(void *handle, unsigned char **buf, size_t *size)
+{
+    rle_buffer_t *buffer;
+
+    buffer = (rle_buffer_t *)handle;
+    *buf = buffer->data + buffer->pos;
+    *size = buffer->size - buffer->pos;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : BufferCommit
+*   Description: Sink commit callback for memory buffers.
+*   Parameters : handle - The rle_buffer_t being written
+*                used - Number of borrowed bytes that were written
+*   Effects    : The buffer position advances
+*   Returned   : 0
+***************************************************************************/
+static int BufferCommit(void *handle, size_t used)
+{
+    ((rle_buffer_t *)handle)->pos += used;
+    return 0;
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+*                 Header for Buffered Source and Sink Streams
+*
+*   File    : rleio.h
+*   Purpose : Provides the internal interface to the buffered streams that
+*             sit between the codecs and the rle_source_t/rle_sink_t
+*             callbacks.  Codecs read whole chunks of input and write their
+*             output a symbol at a time through macros, so a callback is
+*             only made once per buffer.  This header is not part of the
+*             public library interface.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+#ifndef _RLEIO_H_
+#define _RLEIO_H_
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stddef.h>
+#include "rle.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define IO_BUF_SIZE     65536           /* default stream buffer size */
+#define IN_CARRY_SIZE   16              /* largest look ahead InEnsure */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef struct
+{
+    rle_source_t *source;               /* where data comes from */
+    const unsigned char *next;          /* next unread byte */
+    const unsigned char *end;           /* end of readable bytes */
+    const unsigned char *heldNext;      /* borrowed chunk not yet reached */
+    const unsigned char *heldEnd;       /* end of held chunk */
+    const unsigned char *mirror;        /* carry bytes copied from held */
+    unsigned char *buf;                 /* buffer for source->read */
+    size_t bufSize;                     /* size of buf */
+    int eof;                            /* source has no more data */
+    unsigned char carry[IN_CARRY_SIZE]; /* joins borrowed chunks */
+} in_stream_t;
+
+typedef struct
+{
+    rle_sink_t *sink;                   /* where data goes */
+    unsigned char *start;               /* start of unflushed output */
+    unsigned char *next;                /* next byte to write */
+    unsigned char *end;                 /* end of writable space */
+    unsigned char *buf;                 /* buffer for sink->write */
+    size_t bufSize;                     /* size of buf */
+    int lent;                           /* start..end was borrowed */
+    int error;                          /* non-zero after a failure */
+} out_stream_t;
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+
+/* write one byte to an out_stream_t */
+#define OUT_PUTC(out, c)                                                    \
+    do                                                                      \
+    {                                                                       \
+        if ((out)->next < (out)->end)                                       \
+        {                                                                   \
+            *(out)->next++ = (unsigned char)(c);                            \
+        }                                                                   \
+        else                                                                \
+        {                                                                   \
+            OutPutc((out), (unsigned char)(c));                             \
+        }                                                                   \
+    } while (0)
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+
+/* input streams */
+void InitInStream(in_stream_t *in, rle_source_t *source, unsigned char *buf,
+    size_t bufSize);
+int InFill(in_stream_t *in);
+int InEnsure(in_stream_t *in, size_t need);
+int InRead(in_stream_t *in, unsigned char *buf, size_t len, size_t *got);
+
+/* output streams */
+void InitOutStream(out_stream_t *out, rle_sink_t *sink, unsigned char *buf,
+    size_t bufSize);
+int OutFlush(out_stream_t *out);
+int OutFinish(out_stream_t *out);
+void OutPutc(out_stream_t *out, unsigned char c);
+void OutWrite(out_stream_t *out, const unsigned char *data, size_t len);
+void OutFill(out_stream_t *out, unsigned char c, size_t len);
+
+/* streams with heap buffers for one codec call, see OpenStreams */
+int OpenStreams(in_stream_t *in, rle_source_t *source, out_stream_t *out,
+    rle_sink_t *sink);
+void CloseStreams(in_stream_t *in, out_stream_t *out);
+
+#endif  /* ndef _RLEIO_H_ */
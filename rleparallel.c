@@ -0,0 +1,672 @@
+/***************************************************************************
+*                Parallel Decoding of Packbits Variant Data
+*
+*   File    : rleparallel.c
+*   Purpose : Decode data written by the packbits variant encoder with
+*             several threads.  A first pass reads only the block headers,
+*             skipping copy block payloads, to build an index of the
+*             encoded and decoded offsets of blocks spaced about
+*             INDEX_SPACING decoded bytes apart.  The encoded data is then
+*             cut at indexed blocks and each piece is decoded by its own
+*             thread straight into its place in the output.  An index may
+*             be saved next to the encoded data so later decodes skip the
+*             first pass.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+* Index file layout (all values are 8 byte little endian)
+*
+*   "RLEI" version(1)
+*   encodedLen decodedLen count
+*   entries: encOffset decOffset (count times)
+*
+* Entries are in increasing order and the first is always 0 0.  encodedLen
+* is checked against the data being decoded, so an index isn't used with
+* data it wasn't built for.
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define MIN_RUN         3               /* vpackbits minimum run length */
+#define INDEX_SPACING   (1UL << 20)     /* decoded bytes between entries */
+#define MAX_THREADS     64              /* most threads used by a decode */
+#define INDEX_HEADER    29              /* index file header size */
+#define VERSION         1               /* index file version */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef struct
+{
+    size_t encOffset;                   /* offset of a block header */
+    size_t decOffset;                   /* decoded offset of its data */
+} index_entry_t;
+
+struct rle_index_t
+{
+    size_t encodedLen;                  /* length of the indexed data */
+    size_t decodedLen;                  /* length once decoded */
+    size_t count;                       /* number of entries */
+    size_t maxEntries;                  /* entries allocated */
+    index_entry_t *entries;             /* indexed blocks */
+};
+
+/* part of the encoded data decoded by one thread */
+typedef struct
+{
+    const unsigned char *in;            /* first encoded byte */
+    size_t inLen;                       /* encoded bytes in the part */
+    unsigned char *out;                 /* where decoded data goes */
+    size_t outSize;                     /* decoded bytes in the part */
+    int result;                         /* 0 for success, -1 for failure */
+    int error;                          /* errno value for a failure */
+} part_t;
+
+#if defined(_WIN32)
+typedef HANDLE thread_t;
+#else
+typedef pthread_t thread_t;
+#endif
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int AddEntry(rle_index_t *index, size_t encOffset, size_t decOffset);
+static void DecodePart(part_t *part);
+static void PutSize(unsigned char *buf, size_t value);
+static int GetSize(const unsigned char *buf, size_t *value);
+
+#if defined(_WIN32)
+static DWORD WINAPI PartThread(LPVOID arg);
+#else
+static void *PartThread(void *arg);
+#endif
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : VPackBitsIndexBuild
+*   Description: This routine builds the index of data encoded by the
+*                packbits variant encoder.  Only block headers are read:
+*                a run block is two bytes and a copy block's payload is
+*                skipped by its length.  Truncated blocks at the end are
+*                counted the same way VPackBitsDecode decodes them.
+*   Parameters : in - Pointer to the encoded data
+*                inLen - Length of the encoded data
+*   Effects    : An index is allocated
+*   Returned   : Pointer to the index, or NULL for failure (errno will be
+*                set).
+***************************************************************************/
+rle_index_t *VPackBitsIndexBuild(const unsigned char *in, size_t inLen)
+{
+    rle_index_t *index;
+    size_t pos, dec, mark;
+
+    if ((NULL == in) && (inLen > 0))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    index = (rle_index_t *)calloc(1, sizeof(rle_index_t));
+
+    if ((NULL == index) || AddEntry(index, 0, 0))
+    {
+        VPackBitsIndexFree(index);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    pos = 0;
+    dec = 0;
+    mark = INDEX_SPACING;
+
+    while (pos < inLen)
+    {
+        int header;
+
+        if ((dec >= mark) && (pos > 0))
+        {
+            if (AddEntry(index, pos, dec))
+            {
+                VPackBitsIndexFree(index);
+                errno = ENOMEM;
+                return NULL;
+            }
+
+            mark = dec + INDEX_SPACING;
+        }
+
+        header = (signed char)in[pos];
+
+        if (header < 0)
+        {
+            if (inLen - pos < 2)
+            {
+                break;          /* run block is too short */
+            }
+
+            dec += (MIN_RUN - 1) - header;
+            pos += 2;
+        }
+        else if ((size_t)header + 1 < inLen - pos)
+        {
+            dec += header + 1;
+            pos += header + 2;
+        }
+        else
+        {
+            dec += inLen - pos - 1;     /* copy block may be too short */
+            break;
+        }
+    }
+
+    index->encodedLen = inLen;
+    index->decodedLen = dec;
+    return index;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsIndexFree
+*   Description: This routine frees an index.
+*   Parameters : index - Pointer to the index (may be NULL)
+*   Effects    : The index is freed
+*   Returned   : None
+***************************************************************************/
+void VPackBitsIndexFree(rle_index_t *index)
+{
+    if (NULL != index)
+    {
+        free(index->entries);
+        free(index);
+    }
+}
+
+/***************************************************************************
+*   Function   : VPackBitsIndexDecodedSize
+*   Description: This routine returns the decoded length of the data an
+*                index was built for, which is the output buffer size that
+*                VPackBitsDecodeParallel needs.
+*   Parameters : index - Pointer to the index
+*   Effects    : None
+*   Returned   : Decoded length
+***************************************************************************/
+size_t VPackBitsIndexDecodedSize(const rle_index_t *index)
+{
+    return (NULL == index) ? 0 : index->decodedLen;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsIndexSave
+*   Description: This routine writes an index to a file so that it can be
+*                loaded instead of being built again.
+*   Parameters : index - Pointer to the index
+*                outFile - Pointer to the file receiving the index
+*   Effects    : The index is written to outFile
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  outFile will be left open.
+***************************************************************************/
+int VPackBitsIndexSave(const rle_index_t *index, FILE *outFile)
+{
+    unsigned char buf[INDEX_HEADER];
+    size_t i;
+
+    if ((NULL == index) || (NULL == outFile))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    memcpy(buf, "RLEI", 4);
+    buf[4] = VERSION;
+    PutSize(buf + 5, index->encodedLen);
+    PutSize(buf + 13, index->decodedLen);
+    PutSize(buf + 21, index->count);
+
+    if (fwrite(buf, 1, INDEX_HEADER, outFile) != INDEX_HEADER)
+    {
+        return -1;
+    }
+
+    for (i = 0; i < index->count; i++)
+    {
+        PutSize(buf, index->entries[i].encOffset);
+        PutSize(buf + 8, index->entries[i].decOffset);
+
+        if (fwrite(buf, 1, 16, outFile) != 16)
+        {
+            return -1;
+        }
+    }
+
+    return (0 == fflush(outFile)) ? 0 : -1;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsIndexLoad
+*   Description: This routine reads an index written by VPackBitsIndexSave.
+*   Parameters : inFile - Pointer to the file holding the index
+*   Effects    : An index is allocated
+*   Returned   : Pointer to the index, or NULL for failure.  errno will be
+*                set in the event of a failure (EILSEQ if the file isn't a
+*                valid index, ERANGE if its offsets don't fit in a size_t).
+*                inFile will be left open.
+***************************************************************************/
+rle_index_t *VPackBitsIndexLoad(FILE *inFile)
+{
+    unsigned char buf[INDEX_HEADER];
+    rle_index_t *index;
+    size_t count, i;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    if (fread(buf, 1, INDEX_HEADER, inFile) != INDEX_HEADER)
+    {
+        errno = ferror(inFile) ? errno : EILSEQ;
+        return NULL;
+    }
+
+    if ((0 != memcmp(buf, "RLEI", 4)) || (VERSION != buf[4]))
+    {
+        errno = EILSEQ;
+        return NULL;
+    }
+
+    index = (rle_index_t *)calloc(1, sizeof(rle_index_t));
+
+    if (NULL == index)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    if (GetSize(buf + 5, &index->encodedLen) ||
+        GetSize(buf + 13, &index->decodedLen) || GetSize(buf + 21, &count))
+    {
+        VPackBitsIndexFree(index);
+        errno = ERANGE;
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        size_t enc, dec;
+
+        if (fread(buf, 1, 16, inFile) != 16)
+        {
+            VPackBitsIndexFree(index);
+            errno = ferror(inFile) ? errno : EILSEQ;
+            return NULL;
+        }
+
+        if (GetSize(buf, &enc) || GetSize(buf + 8, &dec))
+        {
+            VPackBitsIndexFree(index);
+            errno = ERANGE;
+            return NULL;
+        }
+
+        /* entries must start at 0 0 and grow within the data */
+        if (((0 == i) && ((0 != enc) || (0 != dec))) ||
+            ((i > 0) && ((enc <= index->entries[i - 1].encOffset) ||
+            (dec < index->entries[i - 1].decOffset))) ||
+            (enc > index->encodedLen) || (dec > index->decodedLen))
+        {
+            VPackBitsIndexFree(index);
+            errno = EILSEQ;
+            return NULL;
+        }
+
+        if (AddEntry(index, enc, dec))
+        {
+            VPackBitsIndexFree(index);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+
+    if (0 == index->count)
+    {
+        VPackBitsIndexFree(index);
+        errno = EILSEQ;
+        return NULL;
+    }
+
+    return index;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsDecodeParallel
+*   Description: This routine decodes packbits variant data held in memory
+*                with up to threads threads.  The data is cut into parts
+*                with about the same decoded size at indexed blocks.  Each
+*                part is a complete encoding of its own, so each thread
+*                runs the ordinary decoder on its part, writing directly to
+*                the part's place in out.
+*   Parameters : in - Pointer to the encoded data
+*                inLen - Length of the encoded data
+*                out - Pointer to memory receiving the decoded data
+*                outSize - Size of out
+*                outLen - Set to the number of bytes decoded
+*                index - Pointer to the index of the data, or NULL to build
+*                        one for this decode
+*                threads - Most threads to use (0 or 1 means the caller's
+*                          thread only)
+*   Effects    : Encoded data is decoded into out
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if out is smaller than the
+*                decoded data, EINVAL if index is for other data).
+*                Programs using this routine must link with the system
+*                thread library.
+***************************************************************************/
+int VPackBitsDecodeParallel(const unsigned char *in, size_t inLen,
+    unsigned char *out, size_t outSize, size_t *outLen,
+    const rle_index_t *index, unsigned int threads)
+{
+    part_t parts[MAX_THREADS];
+    thread_t handles[MAX_THREADS];
+    int started[MAX_THREADS];
+    rle_index_t *built;
+    size_t e, share;
+    unsigned int p, numParts;
+    int result;
+
+    if (((NULL == in) && (inLen > 0)) || (NULL == out) || (NULL == outLen))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    *outLen = 0;
+    built = NULL;
+
+    if (NULL == index)
+    {
+        if (NULL == (built = VPackBitsIndexBuild(in, inLen)))
+        {
+            return -1;
+        }
+
+        index = built;
+    }
+
+    if (index->encodedLen != inLen)
+    {
+        VPackBitsIndexFree(built);
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (outSize < index->decodedLen)
+    {
+        VPackBitsIndexFree(built);
+        errno = ENOSPC;
+        return -1;
+    }
+
+    threads = (threads < 1) ? 1 : threads;
+    threads = (threads > MAX_THREADS) ? MAX_THREADS : threads;
+    share = (index->decodedLen / threads) + 1;
+
+    /* each part starts at an indexed block and ends where the next starts */
+    numParts = 0;
+    e = 0;
+
+    while (e < index->count)
+    {
+        part_t *part;
+        size_t last;
+
+        part = &parts[numParts];
+        part->in = in + index->entries[e].encOffset;
+        part->out = out + index->entries[e].decOffset;
+
+        /* the last part takes whatever is left */
+        last = e + 1;
+
+        while ((last < index->count) && ((numParts + 1 == threads) ||
+            (index->entries[last].decOffset - index->entries[e].decOffset <
+            share)))
+        {
+            last++;
+        }
+
+        if (last < index->count)
+        {
+            part->inLen = index->entries[last].encOffset -
+                index->entries[e].encOffset;
+            part->outSize = index->entries[last].decOffset -
+                index->entries[e].decOffset;
+        }
+        else
+        {
+            part->inLen = inLen - index->entries[e].encOffset;
+            part->outSize = index->decodedLen - index->entries[e].decOffset;
+        }
+
+        numParts++;
+        e = last;
+    }
+
+    for (p = 1; p < numParts; p++)
+    {
+#if defined(_WIN32)
+        handles[p] = CreateThread(NULL, 0, PartThread, &parts[p], 0, NULL);
+        started[p] = (NULL != handles[p]);
+#else
+        started[p] =
+            (0 == pthread_create(&handles[p], NULL, PartThread, &parts[p]));
+#endif
+    }
+
+    DecodePart(&parts[0]);
+
+    for (p = 1; p < numParts; p++)
+    {
+        if (started[p])
+        {
+#if defined(_WIN32)
+            WaitForSingleObject(handles[p], INFINITE);
+            CloseHandle(handles[p]);
+#else
+            pthread_join(handles[p], NULL);
+#endif
+        }
+        else
+        {
+            DecodePart(&parts[p]);
+        }
+    }
+
+    result = 0;
+
+    for (p = 0; p < numParts; p++)
+    {
+        if (0 != parts[p].result)
+        {
+            result = -1;
+            errno = parts[p].error;
+            break;
+        }
+    }
+
+    if (0 == result)
+    {
+        *outLen = index->decodedLen;
+    }
+
+    VPackBitsIndexFree(built);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : AddEntry
+*   Description: This routine adds an entry to the end of an index,
+*                growing the entry table as needed.
+*   Parameters : index - Pointer to the index
+*                encOffset - Offset of a block header in the encoded data
+*                decOffset - Decoded offset of the block's data
+*   Effects    : The entry is added to index
+*   Returned   : 0 for success, -1 if memory can't be allocated.
+***************************************************************************/
+static int AddEntry(rle_index_t *index, size_t encOffset, size_t decOffset)
+{
+    if (index->count == index->maxEntries)
+    {
+        index_entry_t *entries;
+        size_t newMax;
+
+        newMax = (0 == index->maxEntries) ? 64 : 2 * index->maxEntries;
+        entries = (index_entry_t *)realloc(index->entries,
+            newMax * sizeof(index_entry_t));
+
+        if (NULL == entries)
+        {
+            return -1;
+        }
+
+        index->entries = entries;
+        index->maxEntries = newMax;
+    }
+
+    index->entries[index->count].encOffset = encOffset;
+    index->entries[index->count].decOffset = decOffset;
+    index->count++;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : DecodePart
+*   Description: This routine decodes one part of the encoded data.  The
+*                decoded size must match what the index says, or the index
+*                doesn't describe the data.
+*   Parameters : part - Pointer to the part to decode
+*   Effects    : The part is decoded.  part->result and part->error are
+*                set.
+*   Returned   : None
+***************************************************************************/
+static void DecodePart(part_t *part)
+{
+    size_t len;
+
+    part->result = VPackBitsDecodeBuffer(NULL, part->in, part->inLen,
+        part->out, part->outSize, &len);
+    part->error = (0 == part->result) ? 0 : errno;
+
+    if ((0 == part->result) && (len != part->outSize))
+    {
+        part->result = -1;
+        part->error = EILSEQ;
+    }
+}
+
+/***************************************************************************
+*   Function   : PartThread
+*   Description: This routine is the entry point of a thread decoding one
+*                part of the encoded data.
+*   Parameters : arg - Pointer to the part to decode
+*   Effects    : The part is decoded
+*   Returned   : Nothing useful
+***************************************************************************/
+#if defined(_WIN32)
+static DWORD WINAPI PartThread(LPVOID arg)
+{
+    DecodePart((part_t *)arg);
+    return 0;
+}
+#else
+static void *PartThread(void *arg)
+{
+    DecodePart((part_t *)arg);
+    return NULL;
+}
+#endif
+
+/***************************************************************************
+*   Function   : PutSize, GetSize
+*   Description: These routines write and read 8 byte little endian values.
+*   Parameters : buf - Where the value is stored
+*                value - Value to write, or where the value read goes
+*   Effects    : PutSize writes 8 bytes to buf
+*   Returned   : GetSize returns 0 for success, or -1 if the value doesn't
+*                fit in a size_t.
+***************************************************************************/
+static void PutSize(unsigned char *buf, size_t value)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        buf[i] = (unsigned char)(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+static int GetSize(const unsigned char *buf, size_t *value)
+{
+    int i;
+
+    *value = 0;
+
+    for (i = 7; i >= 0; i--)
+    {
+        if (*value > ((size_t)-1 >> 8))
+        {
+            return -1;
+        }
+
+        *value = (*value << 8) | buf[i];
+    }
+
+    return 0;
+}
@@ -0,0 +1,550 @@
+/***************************************************************************
+*               Periodic Pattern Encoding and Decoding Library
+*
+*   File    : rlepattern.c
+*   Purpose : Compress and decompress data with runs of short repeating
+*             patterns, like "ABABAB", three byte RGB fills, or 0x00 0xFF
+*             alternations, as well as runs of a single symbol.  Each
+*             block of data begins with a header byte decoded as follows.
+*
+*             Byte (n)   | Meaning
+*             -----------+---------------------------------------------
+*             0 - 127    | Copy the next n + 1 bytes
+*             128 - 255  | Pattern run.  Bits 4 - 6 hold the period p - 1
+*                        | and bits 0 - 3 with the next byte hold a
+*                        | 12 bit count c.  The p pattern bytes follow,
+*                        | and are repeated to make c + 5 bytes.
+*
+*             Patterns are found by comparing the data with itself
+*             shifted by each period from 1 to 8, using the vector scan
+*             kernels where the CPU has them.  The decoder writes the
+*             pattern once and then doubles it with copies of what it has
+*             already written, so pattern runs decode at about the speed
+*             of memset.
+*
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rlecodec.h"
+#include "rlescan.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define MAX_COPY        128             /* maximum characters to copy */
+#define RUN_FLAG        0x80            /* header bit marking a pattern run */
+
+/* shortest and longest pattern runs */
+#define MIN_PATTERN_RUN (1 + SCAN_PERIOD_MATCH)
+#define MAX_PATTERN_RUN (4095 + MIN_PATTERN_RUN)
+
+/* largest piece of a run built on the stack when out has no room */
+#define PATTERN_CHUNK   256
+
+/* data the encoder holds, and how much must follow a pattern's start for
+ * the pattern to be found and measured the same way every time */
+#define WINDOW_SIZE     65536
+#define LOOKAHEAD       (MAX_PATTERN_RUN + SCAN_MAX_PERIOD)
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static size_t EncodeWindow(const unsigned char *data, size_t len,
+    size_t limit, out_stream_t *out);
+static void WriteLiterals(out_stream_t *out, const unsigned char *data,
+    size_t len);
+static void WritePattern(out_stream_t *out, const unsigned char *pattern,
+    size_t period, size_t len);
+static void PutPattern(out_stream_t *out, const unsigned char *pattern,
+    size_t period, size_t len);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RlePatternEncodeFile
+*   Description: This routine reads an input file and writes out a version
+*                of it with runs of repeating patterns encoded.
+*   Parameters : inFile - Pointer to the file to encode
+*                outFile - Pointer to the file to write encoded output to
+*   Effects    : File is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int RlePatternEncodeFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    /* validate input and output files */
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return RlePatternEncode(&source, &sink);
+}
+
+/***************************************************************************
+*   Function   : RlePatternDecodeFile
+*   Description: This routine decodes a file encoded by RlePatternEncodeFile
+*                to an output file.
+*   Parameters : inFile - Pointer to the file to decode
+*                outFile - Pointer to the file to write decoded output to
+*   Effects    : Encoded file is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int RlePatternDecodeFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    /* validate input and output files */
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return RlePatternDecode(&source, &sink);
+}
+
+/***************************************************************************
+*   Function   : RlePatternEncode
+*   Description: This routine reads data from a source and writes a
+*                version of it with runs of repeating patterns encoded to a
+*                sink.
+*   Parameters : source - Pointer to the source of data to encode
+*                sink - Pointer to the sink receiving the encoded output
+*   Effects    : Data is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RlePatternEncode(rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
+
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
+
+    result = RlePatternEncodeStream(&in, &out);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : RlePatternEncodeStream
+*   Description: This routine encodes everything read from an input stream,
+*                writing the results to an output stream.  Input is
+*                gathered in a window, and patterns are only looked for
+*                where at least LOOKAHEAD bytes follow (or the data ends),
+*                so the output doesn't depend on how the source delivers
+*                its data.  The rest of the window is kept for next time.
+*                The window is allocated from the heap to keep the stack
+*                small.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*   Effects    : Data is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOMEM if the window can't be
+*                allocated).
+***************************************************************************/
+int RlePatternEncodeStream(in_stream_t *in, out_stream_t *out)
+{
+    unsigned char *window;
+    size_t len, used;
+    int eof;
+    int result;
+
+    window = (unsigned char *)malloc(WINDOW_SIZE);
+
+    if (NULL == window)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    len = 0;
+    eof = 0;
+    result = 0;
+
+    while (!out->error)
+    {
+        size_t got;
+
+        if ((result = InRead(in, window + len, WINDOW_SIZE - len, &got)) < 0)
+        {
+            break;
+        }
+
+        len += got;
+        eof = (len < WINDOW_SIZE);
+        used = EncodeWindow(window, len, eof ? len : (len - LOOKAHEAD), out);
+
+        if (eof)
+        {
+            break;
+        }
+
+        memmove(window, window + used, len - used);
+        len -= used;
+    }
+
+    free(window);
+
+    if (OutFinish(out) || (result < 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : RlePatternDecode
+*   Description: This routine reads data encoded by RlePatternEncode from a
+*                source and writes the decoded data to a sink.
+*   Parameters : source - Pointer to the source of encoded data
+*                sink - Pointer to the sink receiving the decoded output
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RlePatternDecode(rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
+
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
+
+    result = RlePatternDecodeStream(&in, &out);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : RlePatternDecodeStream
+*   Description: This routine decodes data read from an input stream,
+*                writing the results to an output stream.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (EILSEQ if the data ends part way
+*                through a block).
+***************************************************************************/
+int RlePatternDecodeStream(in_stream_t *in, out_stream_t *out)
+{
+    int result;
+
+    result = 0;
+
+    while (!out->error)
+    {
+        unsigned int header;
+
+        if ((result = InEnsure(in, 1)) < 0)
+        {
+            break;
+        }
+
+        if (in->next == in->end)
+        {
+            break;                      /* end of data */
+        }
+
+        header = *in->next;
+
+        if (header & RUN_FLAG)
+        {
+            size_t period, len;
+
+            period = ((header >> 4) & 0x07) + 1;
+
+            if ((result = InEnsure(in, 2 + period)) < 0)
+            {
+                break;
+            }
+
+            if ((size_t)(in->end - in->next) < (2 + period))
+            {
+                errno = EILSEQ;         /* run block is too short */
+                result = -1;
+                break;
+            }
+
+            len = (((header & 0x0F) << 8) | in->next[1]) + MIN_PATTERN_RUN;
+            PutPattern(out, in->next + 2, period, len);
+            in->next += 2 + period;
+        }
+        else
+        {
+            size_t left;
+
+            left = header + 1;
+            in->next++;
+
+            while (left > 0)
+            {
+                size_t k;
+
+                if ((in->next == in->end) && ((result = InFill(in)) <= 0))
+                {
+                    if (0 == result)
+                    {
+                        errno = EILSEQ; /* copy block is too short */
+                        result = -1;
+                    }
+
+                    break;
+                }
+
+                k = in->end - in->next;
+                k = (k < left) ? k : left;
+                OutWrite(out, in->next, k);
+                in->next += k;
+                left -= k;
+            }
+
+            if (result < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    if (OutFinish(out) || (result < 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : EncodeWindow
+*   Description: This routine encodes the start of a window of data.  The
+*                vector scans find the next place a pattern repeats and
+*                measure how far it goes, and everything between patterns
+*                is written as literals.
+*   Parameters : data - Pointer to the window
+*                len - Number of bytes in the window
+*                limit - Patterns are only looked for before limit
+*                out - Pointer to the output stream
+*   Effects    : Encoded data is written to out
+*   Returned   : Number of bytes of the window encoded (at least limit)
+***************************************************************************/
+static size_t EncodeWindow(const unsigned char *data, size_t len,
+    size_t limit, out_stream_t *out)
+{
+    size_t pos, start;
+
+    pos = 0;
+    start = 0;
+
+    while (pos < limit)
+    {
+        size_t found, period, span, runLen;
+
+        /* just enough to test every start before limit */
+        span = (limit - pos) + (SCAN_MAX_PERIOD + SCAN_PERIOD_MATCH - 1);
+        span = (span < (len - pos)) ? span : (len - pos);
+        found = FindPeriodic(data + pos, span, &period);
+
+        if (found >= (limit - pos))
+        {
+            pos = limit;
+            break;
+        }
+
+        pos += found;
+        runLen = len - pos;
+        runLen = (runLen < MAX_PATTERN_RUN) ? runLen : MAX_PATTERN_RUN;
+        runLen = period + MatchShifted(data + pos, runLen, period);
+
+        WriteLiterals(out, data + start, pos - start);
+        WritePattern(out, data + pos, period, runLen);
+        pos += runLen;
+        start = pos;
+    }
+
+    WriteLiterals(out, data + start, pos - start);
+    return pos;
+}
+
+/***************************************************************************
+*   Function   : WriteLiterals
+*   Description: This routine writes data as copy blocks of up to MAX_COPY
+*                bytes.
+*   Parameters : out - Pointer to the output stream
+*                data - Pointer to the data
+*                len - Number of bytes of data
+*   Effects    : Copy blocks are written to out
+*   Returned   : None
+***************************************************************************/
+static void WriteLiterals(out_stream_t *out, const unsigned char *data,
+    size_t len)
+{
+    while (len > 0)
+    {
+        size_t k;
+
+        k = (len < MAX_COPY) ? len : MAX_COPY;
+        OUT_PUTC(out, k - 1);
+        OutWrite(out, data, k);
+        data += k;
+        len -= k;
+    }
+}
+
+/***************************************************************************
+*   Function   : WritePattern
+*   Description: This routine writes a pattern run block.
+*   Parameters : out - Pointer to the output stream
+*                pattern - Pointer to the first period bytes of the run
+*                period - Length of the pattern (1 - SCAN_MAX_PERIOD)
+*                len - Length of the run (MIN_PATTERN_RUN - MAX_PATTERN_RUN)
+*   Effects    : A pattern run block is written to out
+*   Returned   : None
+***************************************************************************/
+static void WritePattern(out_stream_t *out, const unsigned char *pattern,
+    size_t period, size_t len)
+{
+    len -= MIN_PATTERN_RUN;
+    OUT_PUTC(out, RUN_FLAG | ((period - 1) << 4) | (len >> 8));
+    OUT_PUTC(out, len & 0xFF);
+    OutWrite(out, pattern, period);
+}
+
+/***************************************************************************
+*   Function   : PutPattern
+*   Description: This routine writes a decoded pattern run.  The pattern
+*                is written once, then what has been written is copied
+*                after itself, doubling it each time, so there are only a
+*                few copies however short the pattern.  A one symbol
+*                pattern is just a fill.  If the output stream doesn't
+*                have room for the run, the run is built PATTERN_CHUNK
+*                bytes (whole periods) at a time and written in pieces.
+*   Parameters : out - Pointer to the output stream
+*                pattern - Pointer to the pattern
+*                period - Length of the pattern
+*                len - Length of the run
+*   Effects    : The run is written to out
+*   Returned   : None
+***************************************************************************/
+static void PutPattern(out_stream_t *out, const unsigned char *pattern,
+    size_t period, size_t len)
+{
+    unsigned char buf[PATTERN_CHUNK];
+    unsigned char *dest;
+    size_t size, done;
+
+    if (1 == period)
+    {
+        OutFill(out, pattern[0], len);
+        return;
+    }
+
+    /* build the run in place if there's room */
+    if ((size_t)(out->end - out->next) >= len)
+    {
+        dest = out->next;
+        size = len;
+    }
+    else
+    {
+        dest = buf;
+        size = (len < PATTERN_CHUNK) ? len :
+            (PATTERN_CHUNK - (PATTERN_CHUNK % period));
+    }
+
+    done = (period < size) ? period : size;
+    memcpy(dest, pattern, done);
+
+    while (done < size)
+    {
+        size_t k;
+
+        k = ((size - done) < done) ? (size - done) : done;
+        memcpy(dest + done, dest, k);
+        done += k;
+    }
+
+    if (dest == out->next)
+    {
+        out->next += len;
+        return;
+    }
+
+    /* every piece starts on a period boundary */
+    while (len > 0)
+    {
+        done = (len < size) ? len : size;
+        OutWrite(out, buf, done);
+        len -= done;
+    }
+}
@@ -0,0 +1,696 @@
+/***************************************************************************
+*                   Lazy Decompressing Reader Library
+*
+*   File    : rleread.c
+*   Purpose : Read data encoded by either the traditional RLE or the
+*             packbits variant encoder as if it were a normal file, with
+*             read, seek, and tell.  Data is only decoded as far as it is
+*             read, and runs that are skipped are never expanded.  A
+*             checkpoint index of decoder states is built while decoding,
+*             so seeking backwards restarts from the nearest checkpoint
+*             instead of from the start of the data.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rletoken.h"
+#include "rlescan.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define WINDOW_SIZE     65536           /* decoded bytes kept for reads */
+#define CHECK_SPACING   (1UL << 20)     /* decoded bytes between checkpoints */
+#define MIN_RUN         3               /* vpackbits minimum run length */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/* decoder state at a token boundary */
+typedef struct
+{
+    unsigned long encOffset;            /* offset of the next token */
+    unsigned long decOffset;            /* decoded offset at the token */
+    int prevChar;                       /* RLE symbol that starts a pair */
+    int needCount;                      /* RLE count byte is next */
+} checkpoint_t;
+
+struct rle_reader_t
+{
+    FILE *file;                         /* encoded data */
+    long start;                         /* file offset of encoded data */
+    format_t format;                    /* encoding used by the file */
+
+    /* encoded input */
+    unsigned char buf[IO_BUF_SIZE];     /* encoded data read from file */
+    size_t bufPos;                      /* next unused byte of buf */
+    size_t bufLen;                      /* bytes in buf */
+    unsigned long bufOffset;            /* encoded offset of buf[0] */
+
+    /* decoder */
+    unsigned long decPos;               /* decoded offset of next symbol */
+    size_t litLeft;                     /* symbols left in a literal */
+    size_t runLeft;                     /* symbols left in a run */
+    unsigned char runChar;              /* symbol of the run */
+    int prevChar;                       /* RLE symbol that starts a pair */
+    int needCount;                      /* RLE count byte is next */
+    int pairEnd;                        /* RLE literal ends with a pair */
+
+    /* decoded data kept for the caller */
+    unsigned char window[WINDOW_SIZE];  /* decoded symbols */
+    unsigned long winStart;             /* decoded offset of window[0] */
+    size_t winLen;                      /* symbols in window */
+    unsigned long pos;                  /* caller's position */
+
+    /* checkpoint index, sorted by offset */
+    checkpoint_t *checks;               /* saved decoder states */
+    size_t numChecks;                   /* number of saved states */
+    size_t maxChecks;                   /* space allocated for states */
+};
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static rle_reader_t *OpenReader(FILE *inFile, format_t format);
+static int Advance(rle_reader_t *reader, unsigned char *out, size_t len,
+    size_t *done);
+static int ReadToken(rle_reader_t *reader);
+static int Refill(rle_reader_t *reader);
+static void AddCheckpoint(rle_reader_t *reader);
+static int Restore(rle_reader_t *reader, unsigned long target);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleReaderOpen, VPackBitsReaderOpen
+*   Description: These routines create a reader for data encoded by
+*                RleEncodeFile or VPackBitsEncodeFile.  The encoded data
+*                starts at the current position of inFile, which must
+*                support fseek.
+*   Parameters : inFile - Pointer to the opened encoded file.  It must stay
+*                         open until the reader is closed.
+*   Effects    : A reader is allocated
+*   Returned   : Pointer to the reader, or NULL for failure (errno will be
+*                set).
+***************************************************************************/
+rle_reader_t *RleReaderOpen(FILE *inFile)
+{
+    return OpenReader(inFile, format_rle);
+}
+
+rle_reader_t *VPackBitsReaderOpen(FILE *inFile)
+{
+    return OpenReader(inFile, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : RleReaderClose
+*   Description: This routine frees a reader.  The file it reads from is
+*                left open.
+*   Parameters : reader - Pointer to the reader (may be NULL)
+*   Effects    : The reader is freed
+*   Returned   : None
+***************************************************************************/
+void RleReaderClose(rle_reader_t *reader)
+{
+    if (NULL != reader)
+    {
+        free(reader->checks);
+        free(reader);
+    }
+}
+
+/***************************************************************************
+*   Function   : RleReaderRead
+*   Description: This routine reads decoded data from the reader's current
+*                position.  Data still in the window is copied from it.
+*                Otherwise the decoder is moved to the position (skipping
+*                forward, or restarting from a checkpoint to go back) and
+*                the window is refilled.  Large reads are decoded straight
+*                into buf.
+*   Parameters : reader - Pointer to the reader
+*                buf - Buffer receiving the data
+*                size - Number of bytes wanted
+*                got - Set to the number of bytes read.  Less than size is
+*                      only returned at the end of the data.
+*   Effects    : The reader's position moves forward by *got
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+int RleReaderRead(rle_reader_t *reader, void *buf, size_t size, size_t *got)
+{
+    unsigned char *out;
+    size_t done;
+
+    if ((NULL == reader) || ((NULL == buf) && (size > 0)) || (NULL == got))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    out = (unsigned char *)buf;
+    *got = 0;
+
+    while (*got < size)
+    {
+        size_t want;
+
+        want = size - *got;
+
+        if ((reader->pos >= reader->winStart) &&
+            (reader->pos - reader->winStart < reader->winLen))
+        {
+            /* copy what the window has */
+            size_t k;
+
+            k = reader->winLen - (size_t)(reader->pos - reader->winStart);
+            k = (k < want) ? k : want;
+            memcpy(out + *got, reader->window +
+                (reader->pos - reader->winStart), k);
+            reader->pos += k;
+            *got += k;
+            continue;
+        }
+
+        if ((reader->pos < reader->decPos) && Restore(reader, reader->pos))
+        {
+            return -1;
+        }
+
+        if (reader->pos > reader->decPos)
+        {
+            if (Advance(reader, NULL, reader->pos - reader->decPos, &done))
+            {
+                return -1;
+            }
+
+            if (reader->pos > reader->decPos)
+            {
+                break;                  /* position is past the end */
+            }
+        }
+
+        if (want >= WINDOW_SIZE)
+        {
+            /* too big for the window, decode straight to the caller */
+            if (Advance(reader, out + *got, want, &done))
+            {
+                return -1;
+            }
+
+            reader->pos += done;
+            *got += done;
+        }
+        else
+        {
+            if (Advance(reader, reader->window, WINDOW_SIZE, &done))
+            {
+                return -1;
+            }
+
+            reader->winStart = reader->pos;
+            reader->winLen = done;
+        }
+
+        if (0 == done)
+        {
+            break;                      /* end of data */
+        }
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : RleReaderSeek
+*   Description: This routine sets the position of the next read, the same
+*                way that fseek does for files.  Nothing is decoded until
+*                the next read, except that SEEK_END finds the end of the
+*                decoded data, which skips over every remaining token.
+*   Parameters : reader - Pointer to the reader
+*                offset - Offset from origin
+*                origin - SEEK_SET, SEEK_CUR, or SEEK_END
+*   Effects    : The reader's position is changed
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+int RleReaderSeek(rle_reader_t *reader, long offset, int origin)
+{
+    unsigned long base;
+
+    if (NULL == reader)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    switch (origin)
+    {
+        case SEEK_SET:
+            base = 0;
+            break;
+
+        case SEEK_CUR:
+            base = reader->pos;
+            break;
+
+        case SEEK_END:
+            {
+                size_t done;
+
+                /* skip everything left to find the decoded length */
+                do
+                {
+                    if (Advance(reader, NULL, (size_t)-1, &done))
+                    {
+                        return -1;
+                    }
+                } while (done > 0);
+
+                base = reader->decPos;
+            }
+            break;
+
+        default:
+            errno = EINVAL;
+            return -1;
+    }
+
+    /* negate in unsigned arithmetic, -LONG_MIN doesn't fit in a long */
+    if ((offset < 0) && ((0UL - (unsigned long)offset) > base))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    reader->pos = (offset < 0) ? base - (0UL - (unsigned long)offset) :
+        base + (unsigned long)offset;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : RleReaderTell
+*   Description: This routine returns the reader's position.
+*   Parameters : reader - Pointer to the reader
+*   Effects    : None
+*   Returned   : Decoded offset of the next byte to be read
+***************************************************************************/
+unsigned long RleReaderTell(rle_reader_t *reader)
+{
+    return (NULL == reader) ? 0 : reader->pos;
+}
+
+/***************************************************************************
+*   Function   : OpenReader
+*   Description: This routine allocates a reader and gives it a checkpoint
+*                for the start of the data.
+*   Parameters : inFile - Pointer to the opened encoded file
+*                format - The encoding used by the file
+*   Effects    : A reader is allocated
+*   Returned   : Pointer to the reader, or NULL for failure.
+***************************************************************************/
+static rle_reader_t *OpenReader(FILE *inFile, format_t format)
+{
+    rle_reader_t *reader;
+    long start;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    if ((start = ftell(inFile)) < 0)
+    {
+        return NULL;
+    }
+
+    reader = (rle_reader_t *)malloc(sizeof(rle_reader_t));
+
+    if (NULL == reader)
+    {
+        return NULL;
+    }
+
+    reader->checks = (checkpoint_t *)malloc(16 * sizeof(checkpoint_t));
+
+    if (NULL == reader->checks)
+    {
+        free(reader);
+        return NULL;
+    }
+
+    reader->file = inFile;
+    reader->start = start;
+    reader->format = format;
+    reader->maxChecks = 16;
+    reader->numChecks = 1;
+    reader->checks[0].encOffset = 0;
+    reader->checks[0].decOffset = 0;
+    reader->checks[0].prevChar = EOF;
+    reader->checks[0].needCount = 0;
+    reader->winStart = 0;
+    reader->winLen = 0;
+    reader->pos = 0;
+    reader->bufOffset = 0;
+    reader->bufPos = 0;
+    reader->bufLen = 0;
+    reader->decPos = 0;
+    reader->litLeft = 0;
+    reader->runLeft = 0;
+    reader->prevChar = EOF;
+    reader->needCount = 0;
+    reader->pairEnd = 0;
+    return reader;
+}
+
+/***************************************************************************
+*   Function   : Advance
+*   Description: This routine decodes symbols from the decoder's position.
+*                Skipped runs cost nothing and skipped literals are only
+*                stepped over.  A checkpoint is saved at the first token
+*                boundary CHECK_SPACING symbols past the last one.
+*   Parameters : reader - Pointer to the reader
+*                out - Buffer receiving the symbols, or NULL to skip them
+*                len - Number of symbols wanted
+*                done - Set to the number of symbols decoded.  Less than
+*                       len is only returned at the end of the data.
+*   Effects    : The decoder moves forward by *done symbols
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int Advance(rle_reader_t *reader, unsigned char *out, size_t len,
+    size_t *done)
+{
+    *done = 0;
+
+    while (*done < len)
+    {
+        size_t k;
+
+        k = len - *done;
+
+        if (reader->runLeft > 0)
+        {
+            k = (k < reader->runLeft) ? k : reader->runLeft;
+
+            if (NULL != out)
+            {
+                memset(out + *done, reader->runChar, k);
+            }
+
+            reader->runLeft -= k;
+        }
+        else if (reader->litLeft > 0)
+        {
+            int result;
+
+            if ((result = Refill(reader)) <= 0)
+            {
+                reader->litLeft = 0;    /* truncated literal */
+
+                if (result < 0)
+                {
+                    return -1;
+                }
+
+                break;
+            }
+
+            k = (k < reader->litLeft) ? k : reader->litLeft;
+            k = (k < (reader->bufLen - reader->bufPos)) ? k :
+                (reader->bufLen - reader->bufPos);
+
+            if (NULL != out)
+            {
+                memcpy(out + *done, reader->buf + reader->bufPos, k);
+            }
+
+            reader->bufPos += k;
+            reader->litLeft -= k;
+
+            if ((0 == reader->litLeft) && reader->pairEnd)
+            {
+                reader->needCount = 1;
+                reader->pairEnd = 0;
+            }
+        }
+        else
+        {
+            int result;
+
+            /* token boundary */
+            if (reader->decPos >=
+                reader->checks[reader->numChecks - 1].decOffset +
+                CHECK_SPACING)
+            {
+                AddCheckpoint(reader);
+            }
+
+            if ((result = ReadToken(reader)) <= 0)
+            {
+                return result;
+            }
+
+            continue;
+        }
+
+        *done += k;
+        reader->decPos += k;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : ReadToken
+*   Description: This routine reads the next token of encoded data and sets
+*                up the decoder to produce its symbols.  An RLE literal is
+*                every symbol up to and including the next pair of matching
+*                symbols in the buffer, since encoded and decoded symbols
+*                are the same until a pair's count.
+*   Parameters : reader - Pointer to the reader at a token boundary
+*   Effects    : Encoded data is read
+*   Returned   : 1 if a token was read, 0 at the end of the data, and -1
+*                for failure (errno will be set).
+***************************************************************************/
+static int ReadToken(rle_reader_t *reader)
+{
+    const unsigned char *p;
+    size_t avail;
+    int result;
+
+    if ((result = Refill(reader)) <= 0)
+    {
+        return result;
+    }
+
+    p = reader->buf + reader->bufPos;
+    avail = reader->bufLen - reader->bufPos;
+
+    if (format_vpackbits == reader->format)
+    {
+        int header;
+
+        header = (signed char)*p;
+        reader->bufPos++;
+
+        if (header >= 0)
+        {
+            reader->litLeft = header + 1;
+            return 1;
+        }
+
+        if ((result = Refill(reader)) <= 0)
+        {
+            return result;              /* run block is too short */
+        }
+
+        reader->runChar = reader->buf[reader->bufPos++];
+        reader->runLeft = (MIN_RUN - 1) - header;
+        return 1;
+    }
+
+    if (reader->needCount)
+    {
+        reader->runChar = (unsigned char)reader->prevChar;
+        reader->runLeft = *p;
+        reader->bufPos++;
+        reader->needCount = 0;
+        reader->prevChar = EOF;     /* force next char to be different */
+    }
+    else if (*p == reader->prevChar)
+    {
+        /* the pair straddles buffers */
+        reader->litLeft = 1;
+        reader->pairEnd = 1;
+    }
+    else
+    {
+        size_t pair;
+
+        pair = FindPair(p, avail);
+
+        if (pair < avail)
+        {
+            reader->litLeft = pair + 2;
+            reader->prevChar = p[pair];
+            reader->pairEnd = 1;
+        }
+        else
+        {
+            reader->litLeft = avail;
+            reader->prevChar = p[avail - 1];
+        }
+    }
+
+    return 1;
+}
+
+/***************************************************************************
+*   Function   : Refill
+*   Description: This routine reads more encoded data if all of the buffer
+*                has been used.
+*   Parameters : reader - Pointer to the reader
+*   Effects    : Encoded data may be read into the buffer
+*   Returned   : 1 if data is available, 0 at the end of the data, and -1
+*                for failure (errno will be set).
+***************************************************************************/
+static int Refill(rle_reader_t *reader)
+{
+    if (reader->bufPos < reader->bufLen)
+    {
+        return 1;
+    }
+
+    reader->bufOffset += reader->bufLen;
+    reader->bufPos = 0;
+    reader->bufLen = fread(reader->buf, 1, IO_BUF_SIZE, reader->file);
+
+    if (reader->bufLen > 0)
+    {
+        return 1;
+    }
+
+    return ferror(reader->file) ? -1 : 0;
+}
+
+/***************************************************************************
+*   Function   : AddCheckpoint
+*   Description: This routine saves the decoder state at a token boundary.
+*                If there's no memory for it, the checkpoint is skipped;
+*                seeks will just have further to go.
+*   Parameters : reader - Pointer to the reader at a token boundary
+*   Effects    : A checkpoint may be added to the index
+*   Returned   : None
+***************************************************************************/
+static void AddCheckpoint(rle_reader_t *reader)
+{
+    checkpoint_t *check;
+
+    if (reader->numChecks == reader->maxChecks)
+    {
+        check = (checkpoint_t *)realloc(reader->checks,
+            2 * reader->maxChecks * sizeof(checkpoint_t));
+
+        if (NULL == check)
+        {
+            return;
+        }
+
+        reader->checks = check;
+        reader->maxChecks *= 2;
+    }
+
+    check = &reader->checks[reader->numChecks];
+    check->encOffset = reader->bufOffset + reader->bufPos;
+    check->decOffset = reader->decPos;
+    check->prevChar = reader->prevChar;
+    check->needCount = reader->needCount;
+    reader->numChecks++;
+}
+
+/***************************************************************************
+*   Function   : Restore
+*   Description: This routine moves the decoder back to the last checkpoint
+*                at or before a decoded offset.
+*   Parameters : reader - Pointer to the reader
+*                target - Decoded offset the caller wants to reach
+*   Effects    : The encoded file is repositioned and the decoder reset
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int Restore(rle_reader_t *reader, unsigned long target)
+{
+    const checkpoint_t *check;
+    size_t low, high;
+
+    /* binary search for the last checkpoint at or before target */
+    low = 0;
+    high = reader->numChecks;
+
+    while ((high - low) > 1)
+    {
+        size_t mid;
+
+        mid = low + (high - low) / 2;
+
+        if (reader->checks[mid].decOffset <= target)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    check = &reader->checks[low];
+
+    if (fseek(reader->file, reader->start + (long)check->encOffset,
+        SEEK_SET))
+    {
+        return -1;
+    }
+
+    reader->bufOffset = check->encOffset;
+    reader->bufPos = 0;
+    reader->bufLen = 0;
+    reader->decPos = check->decOffset;
+    reader->litLeft = 0;
+    reader->runLeft = 0;
+    reader->prevChar = check->prevChar;
+    reader->needCount = check->needCount;
+    reader->pairEnd = 0;
+    return 0;
+}
@@ -0,0 +1,477 @@
+/***************************************************************************
+*                         Symbol Scanning Routines
+*
+*   File    : rlescan.c
+*   Purpose : Scan blocks of symbols for runs.  The portable scans compare
+*             a machine word of symbols at a time and only fall back to
+*             comparing single symbols once a word containing a match is
+*             found.  Vector versions of the scans are built for x86
+*             instruction sets in their own files, and the best one the
+*             CPU supports is chosen the first time a scan is used.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include "rle.h"
+#include "rlescan.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define WORD_SIZE   sizeof(unsigned long)
+#define ONES        (~0UL / 0xFF)       /* 0x01 in every byte */
+#define HIGHS       (ONES * 0x80)       /* 0x80 in every byte */
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+
+/* non-zero if any byte of the word w is zero */
+#define HAS_ZERO_BYTE(w)    (((w) - ONES) & ~(w) & HIGHS)
+
+/* non-zero if the CPU (and OS) supports an instruction set extension */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CPU_INIT()          __builtin_cpu_init()
+#define CPU_HAS(feature)    __builtin_cpu_supports(feature)
+#else
+#define CPU_INIT()
+#define CPU_HAS(feature)    0
+#endif
+
+/* read and publish the chosen kernels.  with GNU C the pointer is read
+ * atomically, so once the kernels are chosen using them costs one load.
+ * elsewhere every use goes through CHOOSE_ONCE. */
+#if defined(__GNUC__)
+#define LOAD_KERNELS()      __atomic_load_n(&kernels, __ATOMIC_ACQUIRE)
+#define STORE_KERNELS(k)    __atomic_store_n(&kernels, (k), __ATOMIC_RELEASE)
+#else
+#define LOAD_KERNELS()      NULL
+#define STORE_KERNELS(k)    (kernels = (k))
+#endif
+
+/* choose the kernels exactly once, however many threads get here */
+#if defined(_WIN32)
+#define CHOOSE_ONCE()       InitOnceExecuteOnce(&kernelsOnce, SelectOnce, \
+                                NULL, NULL)
+#else
+#define CHOOSE_ONCE()       pthread_once(&kernelsOnce, SelectKernels)
+#endif
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static const scan_kernels_t *GetKernels(void);
+static void SelectKernels(void);
+#if defined(_WIN32)
+static BOOL CALLBACK SelectOnce(PINIT_ONCE once, PVOID param,
+    PVOID *context);
+#endif
+
+/***************************************************************************
+*                            GLOBAL VARIABLES
+***************************************************************************/
+static const scan_kernels_t genericKernels =
+{
+    "generic", ScanRunGeneric, FindPairGeneric, FindTripleGeneric,
+    MatchShiftedGeneric, FindPeriodicGeneric
+};
+
+/* chosen on first use, by exactly one thread (see GetKernels) */
+static const scan_kernels_t *kernels = NULL;
+
+#if defined(_WIN32)
+static INIT_ONCE kernelsOnce = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t kernelsOnce = PTHREAD_ONCE_INIT;
+#endif
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : ScanRun, FindPair, FindTriple, MatchShifted, FindPeriodic
+*   Description: These routines run the chosen version of each scan (see
+*                ScanRunGeneric, FindPairGeneric, FindTripleGeneric,
+*                MatchShiftedGeneric, and FindPeriodicGeneric).
+***************************************************************************/
+size_t ScanRun(const unsigned char *data, size_t len, unsigned char c)
+{
+    return GetKernels()->scanRun(data, len, c);
+}
+
+size_t FindPair(const unsigned char *data, size_t len)
+{
+    return GetKernels()->findPair(data, len);
+}
+
+size_t FindTriple(const unsigned char *data, size_t len)
+{
+    return GetKernels()->findTriple(data, len);
+}
+
+size_t MatchShifted(const unsigned char *data, size_t len, size_t shift)
+{
+    return GetKernels()->matchShifted(data, len, shift);
+}
+
+size_t FindPeriodic(const unsigned char *data, size_t len, size_t *period)
+{
+    return GetKernels()->findPeriodic(data, len, period);
+}
+
+/***************************************************************************
+*   Function   : RleKernelVariant
+*   Description: This routine returns the name of the scan kernels used by
+*                the library, choosing them if that hasn't been done yet.
+*   Parameters : None
+*   Effects    : The kernels may be chosen
+*   Returned   : "generic", "sse2", "avx2", or "avx512"
+***************************************************************************/
+const char *RleKernelVariant(void)
+{
+    return GetKernels()->name;
+}
+
+/***************************************************************************
+*   Function   : GetKernels
+*   Description: This routine returns the kernels to use.  The first call
+*                chooses them with SelectKernels, run through CHOOSE_ONCE
+*                so that threads making their first calls together wait
+*                for one choice instead of racing to make it.
+*   Parameters : None
+*   Effects    : The kernels may be chosen
+*   Returned   : Pointer to the chosen kernels
+***************************************************************************/
+static const scan_kernels_t *GetKernels(void)
+{
+    const scan_kernels_t *chosen;
+
+    chosen = LOAD_KERNELS();
+
+    if (NULL == chosen)
+    {
+        /* CHOOSE_ONCE orders the choice before the read that follows */
+        CHOOSE_ONCE();
+        chosen = kernels;
+    }
+
+    return chosen;
+}
+
+#if defined(_WIN32)
+/***************************************************************************
+*   Function   : SelectOnce
+*   Description: This routine is the InitOnceExecuteOnce callback that
+*                runs SelectKernels.
+*   Parameters : once - Unused
+*                param - Unused
+*                context - Unused
+*   Effects    : The kernels are chosen
+*   Returned   : TRUE
+***************************************************************************/
+static BOOL CALLBACK SelectOnce(PINIT_ONCE once, PVOID param,
+    PVOID *context)
+{
+    (void)once;
+    (void)param;
+    (void)context;
+    SelectKernels();
+    return TRUE;
+}
+#endif
+
+/***************************************************************************
+*   Function   : SelectKernels
+*   Description: This routine chooses the fastest kernels that were built
+*                and that the CPU supports.  The RLE_KERNELS environment
+*                variable may name a variant to use instead, for testing.
+*                A variant that wasn't built or that the CPU can't run is
+*                ignored.  It is only run through CHOOSE_ONCE.
+*   Parameters : None
+*   Effects    : The kernels are chosen and published
+*   Returned   : None
+***************************************************************************/
+static void SelectKernels(void)
+{
+    const scan_kernels_t *usable[4];    /* fastest first */
+    const char *forced;
+    size_t count;
+    size_t i;
+
+    CPU_INIT();
+    count = 0;
+
+    if ((NULL != avx512Kernels.scanRun) && CPU_HAS("avx512bw"))
+    {
+        usable[count++] = &avx512Kernels;
+    }
+
+    if ((NULL != avx2Kernels.scanRun) && CPU_HAS("avx2"))
+    {
+        usable[count++] = &avx2Kernels;
+    }
+
+    if ((NULL != sse2Kernels.scanRun) && CPU_HAS("sse2"))
+    {
+        usable[count++] = &sse2Kernels;
+    }
+
+    usable[count++] = &genericKernels;
+    forced = getenv("RLE_KERNELS");
+
+    for (i = 0; (NULL != forced) && (i < count); i++)
+    {
+        if (0 == strcmp(forced, usable[i]->name))
+        {
+            STORE_KERNELS(usable[i]);
+            return;
+        }
+    }
+
+    STORE_KERNELS(usable[0]);
+}
+
+/***************************************************************************
+*   Function   : ScanRunGeneric
+*   Description: This routine counts the number of symbols at the start of
+*                a block that match a given symbol.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*                c - Symbol being matched
+*   Effects    : None
+*   Returned   : Number of leading symbols equal to c
+***************************************************************************/
+size_t ScanRunGeneric(const unsigned char *data, size_t len,
+    unsigned char c)
+{
+    unsigned long pattern;
+    size_t i;
+
+    pattern = ONES * c;
+
+    for (i = 0; (i + WORD_SIZE) <= len; i += WORD_SIZE)
+    {
+        unsigned long w;
+
+        memcpy(&w, data + i, WORD_SIZE);
+
+        if (w != pattern)
+        {
+            break;
+        }
+    }
+
+    while ((i < len) && (data[i] == c))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/***************************************************************************
+*   Function   : FindPairGeneric
+*   Description: This routine finds the first pair of adjacent matching
+*                symbols in a block.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*   Effects    : None
+*   Returned   : Index of the first symbol of the pair, or len if the block
+*                doesn't contain a pair.
+***************************************************************************/
+size_t FindPairGeneric(const unsigned char *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; (i + WORD_SIZE) < len; i += WORD_SIZE)
+    {
+        unsigned long a, b;
+
+        memcpy(&a, data + i, WORD_SIZE);
+        memcpy(&b, data + i + 1, WORD_SIZE);
+        a ^= b;
+
+        if (HAS_ZERO_BYTE(a))
+        {
+            break;
+        }
+    }
+
+    for (; (i + 1) < len; i++)
+    {
+        if (data[i] == data[i + 1])
+        {
+            return i;
+        }
+    }
+
+    return len;
+}
+
+/***************************************************************************
+*   Function   : FindTripleGeneric
+*   Description: This routine finds the first three adjacent matching
+*                symbols in a block.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*   Effects    : None
+*   Returned   : Index of the first of the three symbols, or len if the
+*                block doesn't contain three matching symbols.
+***************************************************************************/
+size_t FindTripleGeneric(const unsigned char *data, size_t len)
+{
+    size_t i;
+
+    for (i = 0; (i + WORD_SIZE + 1) < len; i += WORD_SIZE)
+    {
+        unsigned long a, b, c;
+
+        memcpy(&a, data + i, WORD_SIZE);
+        memcpy(&b, data + i + 1, WORD_SIZE);
+        memcpy(&c, data + i + 2, WORD_SIZE);
+        a = (a ^ b) | (b ^ c);
+
+        if (HAS_ZERO_BYTE(a))
+        {
+            break;
+        }
+    }
+
+    for (; (i + 2) < len; i++)
+    {
+        if ((data[i] == data[i + 1]) && (data[i] == data[i + 2]))
+        {
+            return i;
+        }
+    }
+
+    return len;
+}
+
+/***************************************************************************
+*   Function   : MatchShiftedGeneric
+*   Description: This routine compares a block of symbols with itself,
+*                shifted by a given number of symbols, and counts how many
+*                symbols match before the first difference.  If data[0]
+*                through data[shift - 1] is a pattern, shift plus the count
+*                is the length of the pattern's repeats.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*                shift - Distance between the symbols compared
+*   Effects    : None
+*   Returned   : Number of leading symbols equal to the symbol shift later
+*                (at most len - shift)
+***************************************************************************/
+size_t MatchShiftedGeneric(const unsigned char *data, size_t len,
+    size_t shift)
+{
+    size_t i;
+
+    if (len <= shift)
+    {
+        return 0;
+    }
+
+    len -= shift;
+
+    for (i = 0; (i + WORD_SIZE) <= len; i += WORD_SIZE)
+    {
+        unsigned long a, b;
+
+        memcpy(&a, data + i, WORD_SIZE);
+        memcpy(&b, data + i + shift, WORD_SIZE);
+
+        if (a != b)
+        {
+            break;
+        }
+    }
+
+    while ((i < len) && (data[i] == data[i + shift]))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/***************************************************************************
+*   Function   : FindPeriodicGeneric
+*   Description: This routine finds the first place in a block where a
+*                short pattern starts repeating.  That's the first index i
+*                where, for some period from 1 to SCAN_MAX_PERIOD,
+*                SCAN_PERIOD_MATCH symbols starting at i match the symbols a
+*                period later.  The shortest period that works is chosen.
+*   Parameters : data - Pointer to the block of symbols
+*                len - Number of symbols in the block
+*                period - Set to the period found
+*   Effects    : None
+*   Returned   : Index of the start of the pattern, or len if the block
+*                doesn't contain a repeating pattern.
+***************************************************************************/
+size_t FindPeriodicGeneric(const unsigned char *data, size_t len,
+    size_t *period)
+{
+    size_t i, q;
+
+    for (i = 0; (i + 1 + SCAN_PERIOD_MATCH) <= len; i++)
+    {
+        for (q = 1; (q <= SCAN_MAX_PERIOD) &&
+            ((i + q + SCAN_PERIOD_MATCH) <= len); q++)
+        {
+            size_t k;
+
+            for (k = 0; (k < SCAN_PERIOD_MATCH) &&
+                (data[i + k] == data[i + k + q]); k++)
+            {
+                /* count matches */
+            }
+
+            if (SCAN_PERIOD_MATCH == k)
+            {
+                *period = q;
+                return i;
+            }
+        }
+    }
+
+    return len;
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+*                     Header for Symbol Scanning Routines
+*
+*   File    : rlescan.h
+*   Purpose : Provides the internal interface to the routines that scan
+*             blocks of symbols for runs.  These are the innermost loops of
+*             the encoders and token readers.  This header is not part of
+*             the public library interface.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+#ifndef _RLESCAN_H_
+#define _RLESCAN_H_
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stddef.h>
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define SCAN_MAX_PERIOD     8           /* longest period FindPeriodic tries */
+#define SCAN_PERIOD_MATCH   4           /* symbols that must repeat a period */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+
+/* the scans built for one instruction set */
+typedef struct
+{
+    const char *name;                   /* name of the instruction set */
+    size_t (*scanRun)(const unsigned char *data, size_t len,
+        unsigned char c);               /* NULL if the set wasn't built */
+    size_t (*findPair)(const unsigned char *data, size_t len);
+    size_t (*findTriple)(const unsigned char *data, size_t len);
+    size_t (*matchShifted)(const unsigned char *data, size_t len,
+        size_t shift);
+    size_t (*findPeriodic)(const unsigned char *data, size_t len,
+        size_t *period);
+} scan_kernels_t;
+
+/***************************************************************************
+*                                EXTERNS
+***************************************************************************/
+
+/* vector kernels, each from a file built with its own target flags */
+extern const scan_kernels_t sse2Kernels;
+extern const scan_kernels_t avx2Kernels;
+extern const scan_kernels_t avx512Kernels;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+
+/* number of leading symbols in data that match c */
+size_t ScanRun(const unsigned char *data, size_t len, unsigned char c);
+
+/* index of the first pair of matching symbols, len if there isn't one */
+size_t FindPair(const unsigned char *data, size_t len);
+
+/* index of the first three matching symbols, len if there aren't any */
+size_t FindTriple(const unsigned char *data, size_t len);
+
+/* number of leading symbols in data that match the symbol shift later */
+size_t MatchShifted(const unsigned char *data, size_t len, size_t shift);
+
+/* index of the first SCAN_PERIOD_MATCH symbols that repeat the period
+ * (1 - SCAN_MAX_PERIOD) symbols before them, len if there aren't any */
+size_t FindPeriodic(const unsigned char *data, size_t len, size_t *period);
+
+/* portable versions, also used by the vector kernels for short tails */
+size_t ScanRunGeneric(const unsigned char *data, size_t len,
+    unsigned char c);
+size_t FindPairGeneric(const unsigned char *data, size_t len);
+size_t FindTripleGeneric(const unsigned char *data, size_t len);
+size_t MatchShiftedGeneric(const unsigned char *data, size_t len,
+    size_t shift);
+size_t FindPeriodicGeneric(const unsigned char *data, size_t len,
+    size_t *period);
+
+#endif  /* ndef _RLESCAN_H_ */
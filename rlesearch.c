@@ -0,0 +1,418 @@
+/***************************************************************************
+*                  Compressed Domain Pattern Search Library
+*
+*   File    : rlesearch.c
+*   Purpose : Search data encoded by the traditional RLE or the packbits
+*             variant encoder for a byte pattern without decoding it.
+*             The encoded data is walked as a stream of runs and literal
+*             blocks.  Literal blocks are scanned with memchr and runs are
+*             fed to a Knuth-Morris-Pratt matcher as (symbol, length) pairs,
+*             so a run never costs more than the length of the pattern no
+*             matter how long it is.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rletoken.h"
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef struct
+{
+    const unsigned char *pattern;       /* pattern being searched for */
+    size_t length;                      /* length of pattern */
+    size_t lead;                        /* number of leading pattern[0] */
+    size_t *fail;                       /* KMP failure function */
+    size_t state;                       /* length of matched prefix */
+    unsigned long offset;               /* decoded offset of next symbol */
+    rle_match_t onMatch;                /* match callback */
+    void *userData;                     /* data passed to onMatch */
+    int stopped;                        /* onMatch asked to stop */
+} search_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int Search(rle_source_t *source, format_t format,
+    const unsigned char *pattern, size_t patternLen, rle_match_t onMatch,
+    void *userData);
+static void FeedSymbol(search_t *search, unsigned char symbol);
+static void FeedLiteral(search_t *search, const unsigned char *data,
+    size_t length);
+static void FeedRun(search_t *search, unsigned char symbol, size_t length);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleSearchFile
+*   Description: This routine searches a file encoded by RleEncodeFile for
+*                every occurrence of a pattern in its decoded data.
+*   Parameters : inFile - Pointer to the encoded file to search
+*                pattern - Pointer to the pattern being searched for
+*                patternLen - Length of pattern (must not be 0)
+*                onMatch - Function called with the decoded offset of each
+*                          match.  The search stops if it returns non-zero.
+*                userData - Pointer passed unmodified to onMatch
+*   Effects    : Encoded file is read and onMatch is called for each match
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  inFile will be left open.
+***************************************************************************/
+int RleSearchFile(FILE *inFile, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return Search(&source, format_rle, pattern, patternLen, onMatch,
+        userData);
+}
+
+/***************************************************************************
+*   Function   : VPackBitsSearchFile
+*   Description: This routine searches a file encoded by
+*                VPackBitsEncodeFile for every occurrence of a pattern in
+*                its decoded data.
+*   Parameters : inFile - Pointer to the encoded file to search
+*                pattern - Pointer to the pattern being searched for
+*                patternLen - Length of pattern (must not be 0)
+*                onMatch - Function called with the decoded offset of each
+*                          match.  The search stops if it returns non-zero.
+*                userData - Pointer passed unmodified to onMatch
+*   Effects    : Encoded file is read and onMatch is called for each match
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  inFile will be left open.
+***************************************************************************/
+int VPackBitsSearchFile(FILE *inFile, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return Search(&source, format_vpackbits, pattern, patternLen, onMatch,
+        userData);
+}
+
+/***************************************************************************
+*   Function   : RleSearch
+*   Description: This routine searches data encoded by RleEncode for every
+*                occurrence of a pattern in its decoded data.
+*   Parameters : source - Pointer to the source of encoded data
+*                pattern - Pointer to the pattern being searched for
+*                patternLen - Length of pattern (must not be 0)
+*                onMatch - Function called with the decoded offset of each
+*                          match.  The search stops if it returns non-zero.
+*                userData - Pointer passed unmodified to onMatch
+*   Effects    : Encoded data is read and onMatch is called for each match
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleSearch(rle_source_t *source, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData)
+{
+    return Search(source, format_rle, pattern, patternLen, onMatch,
+        userData);
+}
+
+/***************************************************************************
+*   Function   : VPackBitsSearch
+*   Description: This routine searches data encoded by VPackBitsEncode for
+*                every occurrence of a pattern in its decoded data.
+*   Parameters : source - Pointer to the source of encoded data
+*                pattern - Pointer to the pattern being searched for
+*                patternLen - Length of pattern (must not be 0)
+*                onMatch - Function called with the decoded offset of each
+*                          match.  The search stops if it returns non-zero.
+*                userData - Pointer passed unmodified to onMatch
+*   Effects    : Encoded data is read and onMatch is called for each match
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int VPackBitsSearch(rle_source_t *source, const unsigned char *pattern,
+    size_t patternLen, rle_match_t onMatch, void *userData)
+{
+    return Search(source, format_vpackbits, pattern, patternLen, onMatch,
+        userData);
+}
+
+/***************************************************************************
+*   Function   : Search
+*   Description: This routine builds the KMP failure function for a pattern
+*                then feeds every token of the encoded data to the matcher.
+*   Parameters : source - Pointer to the source of encoded data
+*                format - Encoding used by the data
+*                pattern - Pointer to the pattern being searched for
+*                patternLen - Length of pattern
+*                onMatch - Match callback
+*                userData - Pointer passed unmodified to onMatch
+*   Effects    : Encoded data is read and onMatch is called for each match
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+static int Search(rle_source_t *source, format_t format,
+    const unsigned char *pattern, size_t patternLen, rle_match_t onMatch,
+    void *userData)
+{
+    search_t search;
+    token_reader_t *reader;
+    token_t token;
+    size_t i, k;
+    int result;
+
+    /* validate parameters */
+    if ((NULL == source) || (NULL == pattern) || (0 == patternLen) ||
+        (NULL == onMatch))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* the reader holds an IO_BUF_SIZE buffer, keep it off the stack */
+    search.fail = (size_t *)malloc((patternLen + 1) * sizeof(size_t));
+    reader = (token_reader_t *)malloc(sizeof(token_reader_t));
+
+    if ((NULL == search.fail) || (NULL == reader))
+    {
+        free(search.fail);
+        free(reader);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    /* fail[q] is the longest proper border of pattern[0 .. q - 1] */
+    search.fail[0] = 0;
+    search.fail[1] = 0;
+    k = 0;
+
+    for (i = 1; i < patternLen; i++)
+    {
+        while ((k > 0) && (pattern[i] != pattern[k]))
+        {
+            k = search.fail[k];
+        }
+
+        if (pattern[i] == pattern[k])
+        {
+            k++;
+        }
+
+        search.fail[i + 1] = k;
+    }
+
+    for (search.lead = 1; search.lead < patternLen; search.lead++)
+    {
+        if (pattern[search.lead] != pattern[0])
+        {
+            break;
+        }
+    }
+
+    search.pattern = pattern;
+    search.length = patternLen;
+    search.state = 0;
+    search.offset = 0;
+    search.onMatch = onMatch;
+    search.userData = userData;
+    search.stopped = 0;
+    result = 0;
+
+    InitTokenReader(reader, source, format);
+
+    while (!search.stopped && ((result = NextToken(reader, &token)) > 0))
+    {
+        if (token_run == token.kind)
+        {
+            FeedRun(&search, token.symbol, token.length);
+        }
+        else
+        {
+            FeedLiteral(&search, token.data, token.length);
+        }
+    }
+
+    free(search.fail);
+    free(reader);
+    return (search.stopped || (result >= 0)) ? 0 : -1;
+}
+
+/***************************************************************************
+*   Function   : FeedSymbol
+*   Description: This routine advances the matcher by one decoded symbol,
+*                reporting a match if the symbol completes the pattern.
+*   Parameters : search - Pointer to the search state
+*                symbol - The next decoded symbol
+*   Effects    : Matcher state and offset are updated.  onMatch may be
+*                called.
+*   Returned   : None
+***************************************************************************/
+static void FeedSymbol(search_t *search, unsigned char symbol)
+{
+    size_t q;
+
+    q = search->state;
+
+    while ((q > 0) && (search->pattern[q] != symbol))
+    {
+        q = search->fail[q];
+    }
+
+    if (search->pattern[q] == symbol)
+    {
+        q++;
+    }
+
+    search->offset++;
+
+    if (q == search->length)
+    {
+        if (search->onMatch(search->offset - q, search->userData))
+        {
+            search->stopped = 1;
+        }
+
+        q = search->fail[q];
+    }
+
+    search->state = q;
+}
+
+/***************************************************************************
+*   Function   : FeedLiteral
+*   Description: This routine advances the matcher over a block of literal
+*                symbols.  When no partial match is pending, memchr skips
+*                directly to the next occurrence of the first pattern
+*                symbol.
+*   Parameters : search - Pointer to the search state
+*                data - Pointer to the literal symbols
+*                length - Number of literal symbols
+*   Effects    : Matcher state and offset are updated.  onMatch may be
+*                called.
+*   Returned   : None
+***************************************************************************/
+static void FeedLiteral(search_t *search, const unsigned char *data,
+    size_t length)
+{
+    const unsigned char *end;
+
+    end = data + length;
+
+    while ((data < end) && !search->stopped)
+    {
+        if (0 == search->state)
+        {
+            const unsigned char *hit;
+
+            hit = (const unsigned char *)memchr(data, search->pattern[0],
+                end - data);
+
+            if (NULL == hit)
+            {
+                search->offset += end - data;
+                return;
+            }
+
+            search->offset += hit - data;
+            data = hit;
+        }
+
+        FeedSymbol(search, *data);
+        data++;
+    }
+}
+
+/***************************************************************************
+*   Function   : FeedRun
+*   Description: This routine advances the matcher over a run without
+*                expanding it.  After the first pattern length symbols of a
+*                run the matcher state can no longer change, so the rest of
+*                the run is skipped in constant time unless the pattern is
+*                itself a run of the same symbol, in which case every
+*                remaining position is a match.
+*   Parameters : search - Pointer to the search state
+*                symbol - The symbol repeated by the run
+*                length - Length of the run
+*   Effects    : Matcher state and offset are updated.  onMatch may be
+*                called.
+*   Returned   : None
+***************************************************************************/
+static void FeedRun(search_t *search, unsigned char symbol, size_t length)
+{
+    size_t fed;
+
+    for (fed = 0;
+        (fed < length) && (fed < search->length) && !search->stopped;
+        fed++)
+    {
+        FeedSymbol(search, symbol);
+    }
+
+    length -= fed;
+
+    if ((0 == length) || search->stopped)
+    {
+        search->offset += length;
+        return;
+    }
+
+    if ((symbol == search->pattern[0]) &&
+        (search->lead == search->length))
+    {
+        /* pattern is a run of symbol, every position ends a match */
+        while ((length > 0) && !search->stopped)
+        {
+            FeedSymbol(search, symbol);
+            length--;
+        }
+
+        search->offset += length;
+    }
+    else
+    {
+        search->state = (symbol == search->pattern[0]) ? search->lead : 0;
+        search->offset += length;
+    }
+}
@@ -0,0 +1,1063 @@
+/***************************************************************************
+*                    Shared Random Access Reader Library
+*
+*   File    : rleshared.c
+*   Purpose : Read ranges of data encoded by either the traditional RLE or
+*             the packbits variant encoder from many threads at once.  A
+*             shared reader is built by one pass over the encoded file
+*             that records a checkpoint of the decoder state about every
+*             64KB of decoded data, and it never changes after that.  Each
+*             read positions itself with pread at the nearest checkpoint
+*             and decodes with its own buffers, so reads don't wait on
+*             each other.  An optional cache of recently decoded blocks is
+*             split into shards, each with its own lock.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200809L         /* for pread */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rletoken.h"
+#include "rlescan.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define BLOCK_SPACING   65536UL         /* decoded bytes between checkpoints */
+#define CACHE_SHARDS    16              /* separately locked parts of cache */
+#define MIN_RUN         3               /* vpackbits minimum run length */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+#if defined(_WIN32)
+typedef CRITICAL_SECTION lock_t;
+#else
+typedef pthread_mutex_t lock_t;
+#endif
+
+/* decoder state at a token boundary, the start of a block */
+typedef struct
+{
+    unsigned long encOffset;            /* offset of the next token */
+    unsigned long decOffset;            /* decoded offset at the token */
+    int prevChar;                       /* RLE symbol that starts a pair */
+    int needCount;                      /* RLE count byte is next */
+} checkpoint_t;
+
+/* decoded block held by the cache, the data follows the structure */
+typedef struct cache_entry_t
+{
+    size_t block;                       /* number of the block */
+    struct cache_entry_t *newer;        /* next more recently used entry */
+    struct cache_entry_t *older;        /* next less recently used entry */
+} cache_entry_t;
+
+typedef struct
+{
+    lock_t lock;                        /* held while using the entries */
+    cache_entry_t *newest;              /* most recently used entry */
+    cache_entry_t *oldest;              /* least recently used entry */
+    size_t count;                       /* number of entries */
+    size_t max;                         /* most entries allowed */
+} cache_shard_t;
+
+struct rle_shared_t
+{
+    int fd;                             /* descriptor of the encoded file */
+    unsigned long start;                /* file offset of encoded data */
+    format_t format;                    /* encoding used by the file */
+    unsigned long size;                 /* decoded size */
+    size_t maxBlock;                    /* decoded size of largest block */
+
+    /* checkpoint index, sorted by offset */
+    checkpoint_t *checks;               /* saved decoder states */
+    size_t numChecks;                   /* number of saved states */
+    size_t maxChecks;                   /* space allocated for states */
+
+    cache_shard_t *shards;              /* block cache, NULL if unused */
+};
+
+/* decoder used by a single call */
+typedef struct
+{
+    rle_shared_t *shared;               /* reader being decoded */
+    int indexing;                       /* add checkpoints while decoding */
+
+    /* encoded input */
+    unsigned char buf[IO_BUF_SIZE];     /* encoded data read from file */
+    size_t bufPos;                      /* next unused byte of buf */
+    size_t bufLen;                      /* bytes in buf */
+    unsigned long bufOffset;            /* encoded offset of buf[0] */
+
+    /* decoder */
+    unsigned long decPos;               /* decoded offset of next symbol */
+    size_t litLeft;                     /* symbols left in a literal */
+    size_t runLeft;                     /* symbols left in a run */
+    unsigned char runChar;              /* symbol of the run */
+    int prevChar;                       /* RLE symbol that starts a pair */
+    int needCount;                      /* RLE count byte is next */
+    int pairEnd;                        /* RLE literal ends with a pair */
+} decoder_t;
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+#if defined(_WIN32)
+#define FILE_NO(f)      _fileno(f)
+#define LOCK_INIT(l)    InitializeCriticalSection(l)
+#define LOCK_FREE(l)    DeleteCriticalSection(l)
+#define LOCK(l)         EnterCriticalSection(l)
+#define UNLOCK(l)       LeaveCriticalSection(l)
+#else
+#define FILE_NO(f)      fileno(f)
+#define LOCK_INIT(l)    pthread_mutex_init((l), NULL)
+#define LOCK_FREE(l)    pthread_mutex_destroy(l)
+#define LOCK(l)         pthread_mutex_lock(l)
+#define UNLOCK(l)       pthread_mutex_unlock(l)
+#endif
+
+/* decoded data of a cache entry */
+#define ENTRY_DATA(e)   ((unsigned char *)((e) + 1))
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static rle_shared_t *OpenShared(FILE *inFile, format_t format,
+    size_t cacheBlocks);
+static size_t FindBlock(const rle_shared_t *shared, unsigned long offset);
+static size_t BlockLength(const rle_shared_t *shared, size_t block);
+static int DecodeRange(decoder_t *dec, size_t block, size_t from,
+    unsigned char *out, size_t len);
+static void Restart(decoder_t *dec, size_t block);
+static int Advance(decoder_t *dec, unsigned char *out, size_t len,
+    size_t *done);
+static int ReadToken(decoder_t *dec);
+static int Refill(decoder_t *dec);
+static int AddCheckpoint(decoder_t *dec);
+static int CacheGet(rle_shared_t *shared, size_t block, size_t from,
+    unsigned char *out, size_t len);
+static void CachePut(rle_shared_t *shared, size_t block,
+    const unsigned char *data, size_t len);
+static cache_entry_t *FindEntry(cache_shard_t *shard, size_t block);
+static void Unlink(cache_shard_t *shard, cache_entry_t *entry);
+static void MakeNewest(cache_shard_t *shard, cache_entry_t *entry);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleSharedOpen, VPackBitsSharedOpen
+*   Description: These routines create a shared reader for data encoded by
+*                RleEncodeFile or VPackBitsEncodeFile.  The encoded data
+*                starts at the current position of inFile and is read once
+*                to build the reader's checkpoint index.  After that the
+*                file is only read with positioned reads, so its stdio
+*                position doesn't matter and isn't changed.
+*   Parameters : inFile - Pointer to the opened encoded file.  It must stay
+*                         open and unchanged until the reader is closed.
+*                cacheBlocks - Number of decoded 64KB (or so) blocks to
+*                              cache, 0 for no cache
+*   Effects    : A reader is allocated
+*   Returned   : Pointer to the reader, or NULL for failure (errno will be
+*                set).
+***************************************************************************/
+rle_shared_t *RleSharedOpen(FILE *inFile, size_t cacheBlocks)
+{
+    return OpenShared(inFile, format_rle, cacheBlocks);
+}
+
+rle_shared_t *VPackBitsSharedOpen(FILE *inFile, size_t cacheBlocks)
+{
+    return OpenShared(inFile, format_vpackbits, cacheBlocks);
+}
+
+/***************************************************************************
+*   Function   : RleSharedClose
+*   Description: This routine frees a shared reader and its cache.  No
+*                other thread may be using the reader.  The encoded file is
+*                left open.
+*   Parameters : shared - Pointer to the reader (may be NULL)
+*   Effects    : The reader is freed
+*   Returned   : None
+***************************************************************************/
+void RleSharedClose(rle_shared_t *shared)
+{
+    size_t i;
+
+    if (NULL == shared)
+    {
+        return;
+    }
+
+    if (NULL != shared->shards)
+    {
+        for (i = 0; i < CACHE_SHARDS; i++)
+        {
+            cache_entry_t *entry;
+
+            while (NULL != (entry = shared->shards[i].newest))
+            {
+                shared->shards[i].newest = entry->older;
+                free(entry);
+            }
+
+            LOCK_FREE(&shared->shards[i].lock);
+        }
+
+        free(shared->shards);
+    }
+
+    free(shared->checks);
+    free(shared);
+}
+
+/***************************************************************************
+*   Function   : RleSharedSize
+*   Description: This routine returns the decoded size of a shared reader's
+*                data.
+*   Parameters : shared - Pointer to the reader
+*   Effects    : None
+*   Returned   : Number of decoded bytes
+***************************************************************************/
+unsigned long RleSharedSize(const rle_shared_t *shared)
+{
+    return (NULL == shared) ? 0 : shared->size;
+}
+
+/***************************************************************************
+*   Function   : RleSharedRead
+*   Description: This routine reads decoded data starting at an offset.
+*                Any number of threads may call it at the same time with
+*                the same reader.  Each block the range touches is copied
+*                from the cache, or decoded from its checkpoint with a
+*                decoder belonging to this call.  Without a cache, only
+*                the requested part of a block is decoded, straight into
+*                buf.
+*   Parameters : shared - Pointer to the reader
+*                offset - Decoded offset of the first byte to read
+*                buf - Buffer receiving the data
+*                size - Number of bytes wanted
+*                got - Set to the number of bytes read.  Less than size is
+*                      only returned at the end of the data.
+*   Effects    : buf is filled and the cache may be updated
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+int RleSharedRead(rle_shared_t *shared, unsigned long offset, void *buf,
+    size_t size, size_t *got)
+{
+    unsigned char *out;
+    unsigned char *scratch;
+    decoder_t *dec;
+    size_t block;
+    int result;
+
+    if ((NULL == shared) || ((NULL == buf) && (size > 0)) || (NULL == got))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    *got = 0;
+
+    if (offset >= shared->size)
+    {
+        return 0;
+    }
+
+    if (size > (shared->size - offset))
+    {
+        size = shared->size - offset;
+    }
+
+    if (0 == size)
+    {
+        return 0;
+    }
+
+    dec = (decoder_t *)malloc(sizeof(decoder_t));
+
+    if (NULL == dec)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    dec->shared = shared;
+    dec->indexing = 0;
+    out = (unsigned char *)buf;
+    scratch = NULL;
+    block = FindBlock(shared, offset);
+    result = 0;
+
+    while ((*got < size) && (0 == result))
+    {
+        size_t from, len, blockLen;
+
+        blockLen = BlockLength(shared, block);
+        from = (offset + *got) - shared->checks[block].decOffset;
+        len = blockLen - from;
+        len = (len < (size - *got)) ? len : (size - *got);
+
+        if (NULL == shared->shards)
+        {
+            result = DecodeRange(dec, block, from, out + *got, len);
+        }
+        else if (!CacheGet(shared, block, from, out + *got, len))
+        {
+            /* decode the whole block so it can be cached */
+            if (len == blockLen)
+            {
+                result = DecodeRange(dec, block, 0, out + *got, len);
+
+                if (0 == result)
+                {
+                    CachePut(shared, block, out + *got, len);
+                }
+            }
+            else
+            {
+                if (NULL == scratch)
+                {
+                    scratch = (unsigned char *)malloc(shared->maxBlock);
+                }
+
+                if (NULL == scratch)
+                {
+                    result = DecodeRange(dec, block, from, out + *got, len);
+                }
+                else if (0 == (result =
+                    DecodeRange(dec, block, 0, scratch, blockLen)))
+                {
+                    memcpy(out + *got, scratch + from, len);
+                    CachePut(shared, block, scratch, blockLen);
+                }
+            }
+        }
+
+        *got += (0 == result) ? len : 0;
+        block++;
+    }
+
+    free(scratch);
+    free(dec);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : OpenShared
+*   Description: This routine does the work for RleSharedOpen and
+*                VPackBitsSharedOpen.  All of the encoded data is stepped
+*                through, saving a checkpoint at the first token boundary
+*                after every BLOCK_SPACING decoded symbols.  Each checkpoint
+*                starts a block.
+*   Parameters : inFile - Pointer to the opened encoded file
+*                format - The encoding used by the file
+*                cacheBlocks - Number of blocks to cache
+*   Effects    : A reader is allocated
+*   Returned   : Pointer to the reader, or NULL for failure.
+***************************************************************************/
+static rle_shared_t *OpenShared(FILE *inFile, format_t format,
+    size_t cacheBlocks)
+{
+    rle_shared_t *shared;
+    decoder_t *dec;
+    size_t done, i;
+    long start;
+    int result;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return NULL;
+    }
+
+    if ((start = ftell(inFile)) < 0)
+    {
+        return NULL;
+    }
+
+    shared = (rle_shared_t *)malloc(sizeof(rle_shared_t));
+    dec = (decoder_t *)malloc(sizeof(decoder_t));
+
+    if ((NULL == shared) || (NULL == dec) ||
+        (NULL == (shared->checks =
+        (checkpoint_t *)malloc(16 * sizeof(checkpoint_t)))))
+    {
+        free(shared);
+        free(dec);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    shared->fd = FILE_NO(inFile);
+    shared->start = (unsigned long)start;
+    shared->format = format;
+    shared->maxChecks = 16;
+    shared->numChecks = 1;
+    shared->checks[0].encOffset = 0;
+    shared->checks[0].decOffset = 0;
+    shared->checks[0].prevChar = EOF;
+    shared->checks[0].needCount = 0;
+    shared->shards = NULL;
+
+    dec->shared = shared;
+    dec->indexing = 1;
+    Restart(dec, 0);
+
+    do
+    {
+        result = Advance(dec, NULL, BLOCK_SPACING, &done);
+    } while ((0 == result) && (BLOCK_SPACING == done));
+
+    shared->size = dec->decPos;
+    free(dec);
+
+    if (0 != result)
+    {
+        RleSharedClose(shared);
+        return NULL;
+    }
+
+    /* a checkpoint at the very end would start an empty block */
+    if ((shared->numChecks > 1) &&
+        (shared->checks[shared->numChecks - 1].decOffset == shared->size))
+    {
+        shared->numChecks--;
+    }
+
+    shared->maxBlock = 0;
+
+    for (i = 0; i < shared->numChecks; i++)
+    {
+        size_t len;
+
+        len = BlockLength(shared, i);
+        shared->maxBlock = (len > shared->maxBlock) ? len : shared->maxBlock;
+    }
+
+    if (cacheBlocks > 0)
+    {
+        shared->shards =
+            (cache_shard_t *)malloc(CACHE_SHARDS * sizeof(cache_shard_t));
+
+        if (NULL == shared->shards)
+        {
+            RleSharedClose(shared);
+            errno = ENOMEM;
+            return NULL;
+        }
+
+        for (i = 0; i < CACHE_SHARDS; i++)
+        {
+            LOCK_INIT(&shared->shards[i].lock);
+            shared->shards[i].newest = NULL;
+            shared->shards[i].oldest = NULL;
+            shared->shards[i].count = 0;
+            shared->shards[i].max =
+                (cacheBlocks + CACHE_SHARDS - 1) / CACHE_SHARDS;
+        }
+    }
+
+    return shared;
+}
+
+/***************************************************************************
+*   Function   : FindBlock
+*   Description: This routine finds the block holding a decoded offset by
+*                binary searching the checkpoints.
+*   Parameters : shared - Pointer to the reader
+*                offset - Decoded offset (less than the decoded size)
+*   Effects    : None
+*   Returned   : Number of the block
+***************************************************************************/
+static size_t FindBlock(const rle_shared_t *shared, unsigned long offset)
+{
+    size_t low, high;
+
+    low = 0;
+    high = shared->numChecks;
+
+    while ((high - low) > 1)
+    {
+        size_t mid;
+
+        mid = low + (high - low) / 2;
+
+        if (shared->checks[mid].decOffset <= offset)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/***************************************************************************
+*   Function   : BlockLength
+*   Description: This routine returns the number of decoded symbols in a
+*                block.
+*   Parameters : shared - Pointer to the reader
+*                block - Number of the block
+*   Effects    : None
+*   Returned   : Decoded length of the block
+***************************************************************************/
+static size_t BlockLength(const rle_shared_t *shared, size_t block)
+{
+    unsigned long end;
+
+    end = ((block + 1) < shared->numChecks) ?
+        shared->checks[block + 1].decOffset : shared->size;
+    return end - shared->checks[block].decOffset;
+}
+
+/***************************************************************************
+*   Function   : DecodeRange
+*   Description: This routine decodes part of a block.  The symbols before
+*                the part are skipped, so runs among them cost nothing.
+*   Parameters : dec - Pointer to the call's decoder
+*                block - Number of the block
+*                from - Offset of the part within the block
+*                out - Buffer receiving the part
+*                len - Length of the part
+*   Effects    : The encoded file is read and out is filled
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int DecodeRange(decoder_t *dec, size_t block, size_t from,
+    unsigned char *out, size_t len)
+{
+    size_t done;
+
+    Restart(dec, block);
+
+    if ((0 != Advance(dec, NULL, from, &done)) ||
+        ((done == from) && (0 != Advance(dec, out, len, &done))))
+    {
+        return -1;
+    }
+
+    if (done != len)
+    {
+        errno = EIO;                    /* the file changed after opening */
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : Restart
+*   Description: This routine sets a decoder to the state saved at the
+*                start of a block.
+*   Parameters : dec - Pointer to the decoder
+*                block - Number of the block
+*   Effects    : The decoder is reset
+*   Returned   : None
+***************************************************************************/
+static void Restart(decoder_t *dec, size_t block)
+{
+    const checkpoint_t *check;
+
+    check = &dec->shared->checks[block];
+    dec->bufOffset = check->encOffset;
+    dec->bufPos = 0;
+    dec->bufLen = 0;
+    dec->decPos = check->decOffset;
+    dec->litLeft = 0;
+    dec->runLeft = 0;
+    dec->prevChar = check->prevChar;
+    dec->needCount = check->needCount;
+    dec->pairEnd = 0;
+}
+
+/***************************************************************************
+*   Function   : Advance
+*   Description: This routine decodes symbols from the decoder's position.
+*                Skipped runs cost nothing and skipped literals are only
+*                stepped over.  While indexing, a checkpoint is saved at
+*                the first token boundary BLOCK_SPACING symbols past the
+*                last one.
+*   Parameters : dec - Pointer to the decoder
+*                out - Buffer receiving the symbols, or NULL to skip them
+*                len - Number of symbols wanted
+*                done - Set to the number of symbols decoded.  Less than
+*                       len is only returned at the end of the data.
+*   Effects    : The decoder moves forward by *done symbols
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int Advance(decoder_t *dec, unsigned char *out, size_t len,
+    size_t *done)
+{
+    *done = 0;
+
+    while (*done < len)
+    {
+        size_t k;
+
+        k = len - *done;
+
+        if (dec->runLeft > 0)
+        {
+            k = (k < dec->runLeft) ? k : dec->runLeft;
+
+            if (NULL != out)
+            {
+                memset(out + *done, dec->runChar, k);
+            }
+
+            dec->runLeft -= k;
+        }
+        else if (dec->litLeft > 0)
+        {
+            int result;
+
+            if ((result = Refill(dec)) <= 0)
+            {
+                dec->litLeft = 0;       /* truncated literal */
+
+                if (result < 0)
+                {
+                    return -1;
+                }
+
+                break;
+            }
+
+            k = (k < dec->litLeft) ? k : dec->litLeft;
+            k = (k < (dec->bufLen - dec->bufPos)) ? k :
+                (dec->bufLen - dec->bufPos);
+
+            if (NULL != out)
+            {
+                memcpy(out + *done, dec->buf + dec->bufPos, k);
+            }
+
+            dec->bufPos += k;
+            dec->litLeft -= k;
+
+            if ((0 == dec->litLeft) && dec->pairEnd)
+            {
+                dec->needCount = 1;
+                dec->pairEnd = 0;
+            }
+        }
+        else
+        {
+            int result;
+
+            /* token boundary */
+            if (dec->indexing && (dec->decPos >=
+                dec->shared->checks[dec->shared->numChecks - 1].decOffset +
+                BLOCK_SPACING) && (0 != AddCheckpoint(dec)))
+            {
+                return -1;
+            }
+
+            if ((result = ReadToken(dec)) <= 0)
+            {
+                return result;
+            }
+
+            continue;
+        }
+
+        *done += k;
+        dec->decPos += k;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : ReadToken
+*   Description: This routine reads the next token of encoded data and sets
+*                up the decoder to produce its symbols.  An RLE literal is
+*                every symbol up to and including the next pair of matching
+*                symbols in the buffer, since encoded and decoded symbols
+*                are the same until a pair's count.
+*   Parameters : dec - Pointer to the decoder at a token boundary
+*   Effects    : Encoded data is read
+*   Returned   : 1 if a token was read, 0 at the end of the data, and -1
+*                for failure (errno will be set).
+***************************************************************************/
+static int ReadToken(decoder_t *dec)
+{
+    const unsigned char *p;
+    size_t avail;
+    int result;
+
+    if ((result = Refill(dec)) <= 0)
+    {
+        return result;
+    }
+
+    p = dec->buf + dec->bufPos;
+    avail = dec->bufLen - dec->bufPos;
+
+    if (format_vpackbits == dec->shared->format)
+    {
+        int header;
+
+        header = (signed char)*p;
+        dec->bufPos++;
+
+        if (header >= 0)
+        {
+            dec->litLeft = header + 1;
+            return 1;
+        }
+
+        if ((result = Refill(dec)) <= 0)
+        {
+            return result;              /* run block is too short */
+        }
+
+        dec->runChar = dec->buf[dec->bufPos++];
+        dec->runLeft = (MIN_RUN - 1) - header;
+        return 1;
+    }
+
+    if (dec->needCount)
+    {
+        dec->runChar = (unsigned char)dec->prevChar;
+        dec->runLeft = *p;
+        dec->bufPos++;
+        dec->needCount = 0;
+        dec->prevChar = EOF;            /* force next char to be different */
+    }
+    else if (*p == dec->prevChar)
+    {
+        /* the pair straddles buffers */
+        dec->litLeft = 1;
+        dec->pairEnd = 1;
+    }
+    else
+    {
+        size_t pair;
+
+        pair = FindPair(p, avail);
+
+        if (pair < avail)
+        {
+            dec->litLeft = pair + 2;
+            dec->prevChar = p[pair];
+            dec->pairEnd = 1;
+        }
+        else
+        {
+            dec->litLeft = avail;
+            dec->prevChar = p[avail - 1];
+        }
+    }
+
+    return 1;
+}
+
+/***************************************************************************
+*   Function   : Refill
+*   Description: This routine reads more encoded data with a positioned
+*                read if all of the buffer has been used.  Positioned reads
+*                don't share a file offset, so any number of decoders may
+*                read the file at once.
+*   Parameters : dec - Pointer to the decoder
+*   Effects    : Encoded data may be read into the buffer
+*   Returned   : 1 if data is available, 0 at the end of the data, and -1
+*                for failure (errno will be set).
+***************************************************************************/
+static int Refill(decoder_t *dec)
+{
+    unsigned long offset;
+#if defined(_WIN32)
+    OVERLAPPED overlapped;
+    DWORD got;
+#else
+    ssize_t got;
+#endif
+
+    if (dec->bufPos < dec->bufLen)
+    {
+        return 1;
+    }
+
+    dec->bufOffset += dec->bufLen;
+    dec->bufPos = 0;
+    dec->bufLen = 0;
+    offset = dec->shared->start + dec->bufOffset;
+
+#if defined(_WIN32)
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = (DWORD)offset;
+
+    if (!ReadFile((HANDLE)_get_osfhandle(dec->shared->fd), dec->buf,
+        IO_BUF_SIZE, &got, &overlapped))
+    {
+        if (ERROR_HANDLE_EOF == GetLastError())
+        {
+            return 0;
+        }
+
+        errno = EIO;
+        return -1;
+    }
+#else
+    do
+    {
+        got = pread(dec->shared->fd, dec->buf, IO_BUF_SIZE, (off_t)offset);
+    } while ((got < 0) && (EINTR == errno));
+
+    if (got < 0)
+    {
+        return -1;
+    }
+#endif
+
+    dec->bufLen = (size_t)got;
+    return (got > 0) ? 1 : 0;
+}
+
+/***************************************************************************
+*   Function   : AddCheckpoint
+*   Description: This routine saves the decoder state at a token boundary
+*                while the reader is being opened.
+*   Parameters : dec - Pointer to the indexing decoder at a token boundary
+*   Effects    : A checkpoint is added to the index
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int AddCheckpoint(decoder_t *dec)
+{
+    rle_shared_t *shared;
+    checkpoint_t *check;
+
+    shared = dec->shared;
+
+    if (shared->numChecks == shared->maxChecks)
+    {
+        check = (checkpoint_t *)realloc(shared->checks,
+            2 * shared->maxChecks * sizeof(checkpoint_t));
+
+        if (NULL == check)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+
+        shared->checks = check;
+        shared->maxChecks *= 2;
+    }
+
+    check = &shared->checks[shared->numChecks];
+    check->encOffset = dec->bufOffset + dec->bufPos;
+    check->decOffset = dec->decPos;
+    check->prevChar = dec->prevChar;
+    check->needCount = dec->needCount;
+    shared->numChecks++;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : CacheGet
+*   Description: This routine copies part of a block from the cache if the
+*                block is there.  Only the block's shard is locked, and
+*                only while the data is copied.
+*   Parameters : shared - Pointer to the reader
+*                block - Number of the block
+*                from - Offset of the part within the block
+*                out - Buffer receiving the part
+*                len - Length of the part
+*   Effects    : The block becomes the most recently used in its shard
+*   Returned   : Non-zero if the block was cached and copied.
+***************************************************************************/
+static int CacheGet(rle_shared_t *shared, size_t block, size_t from,
+    unsigned char *out, size_t len)
+{
+    cache_shard_t *shard;
+    cache_entry_t *entry;
+
+    shard = &shared->shards[block % CACHE_SHARDS];
+    LOCK(&shard->lock);
+    entry = FindEntry(shard, block);
+
+    if (NULL != entry)
+    {
+        Unlink(shard, entry);
+        MakeNewest(shard, entry);
+        memcpy(out, ENTRY_DATA(entry) + from, len);
+    }
+
+    UNLOCK(&shard->lock);
+    return (NULL != entry);
+}
+
+/***************************************************************************
+*   Function   : CachePut
+*   Description: This routine adds a decoded block to the cache.  A full
+*                shard reuses its least recently used entry.  If another
+*                thread cached the block first, its entry is kept.  A block
+*                that can't get memory just isn't cached.
+*   Parameters : shared - Pointer to the reader
+*                block - Number of the block
+*                data - The decoded block
+*                len - Length of the block
+*   Effects    : The block may be cached
+*   Returned   : None
+***************************************************************************/
+static void CachePut(rle_shared_t *shared, size_t block,
+    const unsigned char *data, size_t len)
+{
+    cache_shard_t *shard;
+    cache_entry_t *entry;
+
+    shard = &shared->shards[block % CACHE_SHARDS];
+    LOCK(&shard->lock);
+    entry = FindEntry(shard, block);
+
+    if (NULL != entry)
+    {
+        Unlink(shard, entry);           /* another thread cached it first */
+    }
+    else
+    {
+        if (shard->count < shard->max)
+        {
+            entry = (cache_entry_t *)malloc(sizeof(cache_entry_t) +
+                shared->maxBlock);
+            shard->count += (NULL != entry) ? 1 : 0;
+        }
+        else
+        {
+            entry = shard->oldest;
+            Unlink(shard, entry);
+        }
+
+        if (NULL != entry)
+        {
+            entry->block = block;
+            memcpy(ENTRY_DATA(entry), data, len);
+        }
+    }
+
+    if (NULL != entry)
+    {
+        MakeNewest(shard, entry);
+    }
+
+    UNLOCK(&shard->lock);
+}
+
+/***************************************************************************
+*   Function   : FindEntry
+*   Description: This routine looks for a block in a cache shard, newest
+*                entry first.  Shards are small, so a list is searched.
+*   Parameters : shard - Pointer to the locked shard
+*                block - Number of the block
+*   Effects    : None
+*   Returned   : Pointer to the block's entry, or NULL if it isn't cached.
+***************************************************************************/
+static cache_entry_t *FindEntry(cache_shard_t *shard, size_t block)
+{
+    cache_entry_t *entry;
+
+    for (entry = shard->newest; NULL != entry; entry = entry->older)
+    {
+        if (entry->block == block)
+        {
+            break;
+        }
+    }
+
+    return entry;
+}
+
+/***************************************************************************
+*   Function   : Unlink, MakeNewest
+*   Description: These routines remove an entry from a shard's use order
+*                and add an entry as the most recently used.
+*   Parameters : shard - Pointer to the locked shard
+*                entry - Pointer to the entry
+*   Effects    : The shard's list is changed
+*   Returned   : None
+***************************************************************************/
+static void Unlink(cache_shard_t *shard, cache_entry_t *entry)
+{
+    if (NULL != entry->newer)
+    {
+        entry->newer->older = entry->older;
+    }
+    else
+    {
+        shard->newest = entry->older;
+    }
+
+    if (NULL != entry->older)
+    {
+        entry->older->newer = entry->newer;
+    }
+    else
+    {
+        shard->oldest = entry->newer;
+    }
+}
+
+static void MakeNewest(cache_shard_t *shard, cache_entry_t *entry)
+{
+    entry->newer = NULL;
+    entry->older = shard->newest;
+
+    if (NULL != shard->newest)
+    {
+        shard->newest->newer = entry;
+    }
+    else
+    {
+        shard->oldest = entry;
+    }
+
+    shard->newest = entry;
+}
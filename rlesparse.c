@@ -0,0 +1,486 @@
+/***************************************************************************
+*                          Sparse File Routines
+*
+*   File    : rlesparse.c
+*   Purpose : Encode sparse files and decode run length encoded files into
+*             sparse files.  When encoding, the holes of the input are
+*             found with SEEK_DATA and SEEK_HOLE and written as runs of
+*             zeros without being read.  When decoding, long runs of zeros
+*             are skipped over with fseek instead of being written, so file
+*             systems that support holes store only the real data.  Either
+*             way the encoded data is handled as runs and literal blocks,
+*             so the zeros are never expanded in memory.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#if defined(__linux__)
+#define _GNU_SOURCE                     /* for SEEK_DATA and SEEK_HOLE */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rletoken.h"
+#include "rlescan.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define DEFAULT_HOLE    4096            /* shortest hole if none is given */
+#define MAX_HOLE_STEP   ((size_t)INT_MAX)   /* most zeros per WriteRun */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef struct
+{
+    token_writer_t writer;              /* encodes the file's tokens */
+    unsigned char buf[IO_BUF_SIZE];     /* data read from the file */
+} sparse_encoder_t;
+
+typedef struct
+{
+    token_reader_t reader;              /* tokens of the encoded file */
+    out_stream_t out;                   /* decoded data that isn't a hole */
+    unsigned char buf[IO_BUF_SIZE];     /* buffer for out */
+} sparse_decoder_t;
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+#if defined(_WIN32)
+#define TRUNCATE_FILE(f, len)   _chsize(_fileno(f), (len))
+#else
+#define TRUNCATE_FILE(f, len)   ftruncate(fileno(f), (off_t)(len))
+#endif
+
+/* SEEK_DATA and SEEK_HOLE aren't standard, use them where they exist */
+#if defined(SEEK_DATA) && defined(SEEK_HOLE) && !defined(_WIN32)
+#define HAVE_SEEK_DATA
+#endif
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int EncodeSparse(FILE *inFile, FILE *outFile, format_t format);
+static int DecodeSparse(FILE *inFile, FILE *outFile, size_t minHole,
+    format_t format);
+static int PutZeros(out_stream_t *out, FILE *outFile, size_t len,
+    size_t minHole);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleEncodeSparseFile, VPackBitsEncodeSparseFile
+*   Description: These routines encode a file the same way as
+*                RleEncodeFile and VPackBitsEncodeFile, except that holes
+*                in the file are encoded as runs of zeros without being
+*                read.  Where holes can't be found (no SEEK_DATA support,
+*                or inFile isn't a regular file) the whole file is encoded
+*                by RleEncodeFile or VPackBitsEncodeFile.
+*   Parameters : inFile - Pointer to the file to encode
+*                outFile - Pointer to the file to write encoded output to
+*   Effects    : File is encoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int RleEncodeSparseFile(FILE *inFile, FILE *outFile)
+{
+    return EncodeSparse(inFile, outFile, format_rle);
+}
+
+int VPackBitsEncodeSparseFile(FILE *inFile, FILE *outFile)
+{
+    return EncodeSparse(inFile, outFile, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : RleDecodeSparseFile, VPackBitsDecodeSparseFile
+*   Description: These routines decode a file encoded by RleEncodeFile or
+*                VPackBitsEncodeFile, leaving holes in the output file
+*                wherever the decoded data has at least minHole zeros in a
+*                row.
+*   Parameters : inFile - Pointer to the file to decode
+*                outFile - Pointer to the file to write decoded output to.
+*                          It must support fseek.  Anything in the file
+*                          after its current position is discarded.
+*                minHole - Shortest run of zeros to skip (0 means 4096)
+*   Effects    : Encoded file is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int RleDecodeSparseFile(FILE *inFile, FILE *outFile, size_t minHole)
+{
+    return DecodeSparse(inFile, outFile, minHole, format_rle);
+}
+
+int VPackBitsDecodeSparseFile(FILE *inFile, FILE *outFile, size_t minHole)
+{
+    return DecodeSparse(inFile, outFile, minHole, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : EncodeSparse
+*   Description: This routine walks the data extents of a file.  The gap
+*                before each extent is a hole and is passed to a token
+*                writer as a single run of zeros.  Extents are read and
+*                passed to the writer as literals, which it scans for runs
+*                as usual.  The file's stdio position is left at its end.
+*   Parameters : inFile - Pointer to the file to encode
+*                outFile - Pointer to the file to write encoded output to
+*                format - The encoding to write
+*   Effects    : File is encoded
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int EncodeSparse(FILE *inFile, FILE *outFile, format_t format)
+{
+#if defined(HAVE_SEEK_DATA)
+    sparse_encoder_t *enc;
+    rle_sink_t sink;
+    off_t pos, end;
+    long start;
+    int fd;
+    int result;
+#endif
+
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+#if defined(HAVE_SEEK_DATA)
+    fd = fileno(inFile);
+
+    /* pipes and files that can't report holes go the usual way */
+    if (((start = ftell(inFile)) < 0) ||
+        ((end = lseek(fd, 0, SEEK_END)) < 0) ||
+        ((lseek(fd, start, SEEK_DATA) < 0) && (ENXIO != errno)))
+    {
+        if ((start >= 0) && fseek(inFile, start, SEEK_SET))
+        {
+            return -1;
+        }
+
+        errno = 0;
+        return (format_vpackbits == format) ?
+            VPackBitsEncodeFile(inFile, outFile) :
+            RleEncodeFile(inFile, outFile);
+    }
+
+    enc = (sparse_encoder_t *)malloc(sizeof(sparse_encoder_t));
+
+    if (NULL == enc)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    RleFileSink(&sink, outFile);
+    InitTokenWriter(&enc->writer, &sink, format);
+    pos = start;
+    result = 0;
+
+    while ((pos < end) && !enc->writer.out.error)
+    {
+        off_t data, hole;
+
+        data = lseek(fd, pos, SEEK_DATA);
+
+        if (data < 0)
+        {
+            if (ENXIO != errno)
+            {
+                result = -1;
+                break;
+            }
+
+            data = end;         /* the rest of the file is a hole */
+        }
+
+        data = (data < end) ? data : end;
+
+        /* a hole is one run however long it is */
+        while (pos < data)
+        {
+            size_t step;
+
+            step = ((data - pos) < (off_t)MAX_HOLE_STEP) ?
+                (size_t)(data - pos) : MAX_HOLE_STEP;
+            WriteRun(&enc->writer, 0, step);
+            pos += step;
+        }
+
+        if (pos >= end)
+        {
+            break;
+        }
+
+        if (((hole = lseek(fd, pos, SEEK_HOLE)) < 0) ||
+            (lseek(fd, pos, SEEK_SET) < 0))
+        {
+            result = -1;
+            break;
+        }
+
+        hole = (hole < end) ? hole : end;
+
+        while ((pos < hole) && !enc->writer.out.error)
+        {
+            ssize_t got;
+            size_t want;
+
+            want = ((hole - pos) < IO_BUF_SIZE) ?
+                (size_t)(hole - pos) : IO_BUF_SIZE;
+            got = read(fd, enc->buf, want);
+
+            if (got <= 0)
+            {
+                result = (0 == got) ? 0 : -1;
+                end = pos;              /* the file got shorter */
+                break;
+            }
+
+            WriteLiterals(&enc->writer, enc->buf, got);
+            pos += got;
+        }
+    }
+
+    if (FinishTokenWriter(&enc->writer))
+    {
+        result = -1;
+    }
+
+    free(enc);
+
+    if ((0 == result) && fseek(inFile, pos, SEEK_SET))
+    {
+        result = -1;
+    }
+
+    return result;
+#else
+    return (format_vpackbits == format) ?
+        VPackBitsEncodeFile(inFile, outFile) :
+        RleEncodeFile(inFile, outFile);
+#endif
+}
+
+/***************************************************************************
+*   Function   : DecodeSparse
+*   Description: This routine decodes a file a token at a time.  Zeros
+*                from runs and from the start of literal blocks are
+*                counted rather than written until something else comes
+*                along.  The output file is truncated at its starting
+*                position first, so anything skipped reads back as zeros,
+*                and it is truncated again at the end to give it its
+*                final size if it ends with a hole.
+*   Parameters : inFile - Pointer to the file to decode
+*                outFile - Pointer to the file to write decoded output to
+*                minHole - Shortest run of zeros to skip
+*                format - The encoding used to produce inFile
+*   Effects    : Encoded file is decoded
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int DecodeSparse(FILE *inFile, FILE *outFile, size_t minHole,
+    format_t format)
+{
+    sparse_decoder_t *dec;
+    rle_source_t source;
+    rle_sink_t sink;
+    token_t token;
+    size_t zeros;
+    long pos;
+    int result;
+
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    minHole = (0 == minHole) ? DEFAULT_HOLE : minHole;
+
+    if (fflush(outFile) || ((pos = ftell(outFile)) < 0) ||
+        TRUNCATE_FILE(outFile, pos))
+    {
+        return -1;
+    }
+
+    dec = (sparse_decoder_t *)malloc(sizeof(sparse_decoder_t));
+
+    if (NULL == dec)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    InitTokenReader(&dec->reader, &source, format);
+    InitOutStream(&dec->out, &sink, dec->buf, IO_BUF_SIZE);
+    zeros = 0;
+    result = 0;
+
+    while (!dec->out.error &&
+        ((result = NextToken(&dec->reader, &token)) > 0))
+    {
+        const unsigned char *data;
+        size_t len;
+
+        if (token_run == token.kind)
+        {
+            if (0 == token.symbol)
+            {
+                zeros += token.length;
+                continue;
+            }
+
+            data = NULL;
+            len = token.length;
+        }
+        else
+        {
+            len = ScanRun(token.data, token.length, 0);
+            zeros += len;
+            data = token.data + len;
+            len = token.length - len;
+
+            if (0 == len)
+            {
+                continue;
+            }
+        }
+
+        if ((zeros > 0) && PutZeros(&dec->out, outFile, zeros, minHole))
+        {
+            result = -1;
+            break;
+        }
+
+        zeros = 0;
+
+        if (NULL == data)
+        {
+            OutFill(&dec->out, token.symbol, len);
+        }
+        else
+        {
+            OutWrite(&dec->out, data, len);
+        }
+    }
+
+    if ((result >= 0) && (zeros > 0) &&
+        PutZeros(&dec->out, outFile, zeros, minHole))
+    {
+        result = -1;
+    }
+
+    if (OutFinish(&dec->out))
+    {
+        result = -1;
+    }
+
+    free(dec);
+
+    if (result < 0)
+    {
+        return -1;
+    }
+
+    /* a trailing hole only moved the file position, make it the size */
+    if (fflush(outFile) || ((pos = ftell(outFile)) < 0) ||
+        TRUNCATE_FILE(outFile, pos))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : PutZeros
+*   Description: This routine writes a run of zeros, or skips over it if
+*                it is long enough to be a hole.
+*   Parameters : out - Pointer to the stream writing outFile
+*                outFile - Pointer to the output file
+*                len - Number of zeros
+*                minHole - Shortest run of zeros to skip
+*   Effects    : The zeros are written or the file position moves past
+*                them
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int PutZeros(out_stream_t *out, FILE *outFile, size_t len,
+    size_t minHole)
+{
+    if (len < minHole)
+    {
+        OutFill(out, 0, len);
+        return out->error ? -1 : 0;
+    }
+
+    /* everything before the hole has to reach the file first */
+    if (OutFlush(out))
+    {
+        return -1;
+    }
+
+    while (len > 0)
+    {
+        long step;
+
+        step = (len > LONG_MAX) ? LONG_MAX : (long)len;
+
+        if (fseek(outFile, step, SEEK_CUR))
+        {
+            return -1;
+        }
+
+        len -= step;
+    }
+
+    return 0;
+}
@@ -0,0 +1,594 @@
+/***************************************************************************
+*                   Encoded Token Stream Reading Routines
+*
+*   File    : rletoken.c
+*   Purpose : Break data encoded by either the traditional RLE or the
+*             packbits variant encoder into a stream of tokens, and encode
+*             a stream of tokens in either format.  Each token is either a
+*             run (symbol, length) or a block of literal symbols.  Runs are
+*             never expanded, so routines built on these functions do work
+*             proportional to the encoded size.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include "rletoken.h"
+#include "rlescan.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define MIN_RUN     3                   /* vpackbits minimum run length */
+#define MAX_RUN     (128 + MIN_RUN - 1) /* vpackbits maximum run length */
+#define MAX_COPY    TOKEN_MAX_COPY      /* vpackbits maximum copy block */
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int NextRleToken(token_reader_t *reader, token_t *token);
+static int NextVPackBitsToken(token_reader_t *reader, token_t *token);
+static void FlushRun(token_writer_t *writer);
+static void RlePutRun(token_writer_t *writer, unsigned char symbol,
+    size_t len);
+static void RlePutLiterals(token_writer_t *writer, const unsigned char *data,
+    size_t len);
+static void VPackBitsPutRun(token_writer_t *writer, unsigned char symbol,
+    size_t len);
+static void VPackBitsPutLiterals(token_writer_t *writer,
+    const unsigned char *data, size_t len);
+static void VPackBitsPutCopies(token_writer_t *writer,
+    const unsigned char *data, size_t len);
+static void VPackBitsFlushCopies(token_writer_t *writer);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : InitTokenReader
+*   Description: This routine prepares a token reader for walking encoded
+*                data.
+*   Parameters : reader - Pointer to the reader being initialized
+*                source - Pointer to the source of encoded data
+*                format - The encoding used to produce the data
+*   Effects    : reader is ready for use by NextToken
+*   Returned   : None
+***************************************************************************/
+void InitTokenReader(token_reader_t *reader, rle_source_t *source,
+    format_t format)
+{
+    InitInStream(&reader->in, source, reader->buf, IO_BUF_SIZE);
+    reader->format = format;
+    reader->copyLeft = 0;
+}
+
+/***************************************************************************
+*   Function   : NextToken
+*   Description: This routine reads the next run or literal block of
+*                encoded data.  Long literal blocks may be returned as
+*                several consecutive literal tokens.
+*   Parameters : reader - Pointer to an initialized token reader
+*                token - Pointer to the token receiving the results
+*   Effects    : Encoded data is read from the reader's source
+*   Returned   : 1 if a token was read, 0 at the end of the encoded data,
+*                and -1 for a read error (errno will be set).
+***************************************************************************/
+int NextToken(token_reader_t *reader, token_t *token)
+{
+    if (format_vpackbits == reader->format)
+    {
+        return NextVPackBitsToken(reader, token);
+    }
+
+    return NextRleToken(reader, token);
+}
+
+/***************************************************************************
+*   Function   : NextRleToken
+*   Description: This routine reads the next token from data encoded by
+*                RleEncodeFile.  A pair of matching symbols followed by a
+*                count is a run, everything else is a literal.  The last
+*                available byte is held back from a literal until the
+*                following byte is known, so a pair is never split across
+*                two tokens.
+*   Parameters : reader - Pointer to the token reader
+*                token - Pointer to the token receiving the results
+*   Effects    : Encoded data is read from the reader's source
+*   Returned   : 1 if a token was read, 0 at the end of the encoded data,
+*                and -1 for a read error.
+***************************************************************************/
+static int NextRleToken(token_reader_t *reader, token_t *token)
+{
+    const unsigned char *p;
+    size_t avail;
+    size_t i;
+
+    if (InEnsure(&reader->in, 3))
+    {
+        return -1;
+    }
+
+    p = reader->in.next;
+    avail = reader->in.end - p;
+
+    if (0 == avail)
+    {
+        token->kind = token_none;
+        token->length = 0;
+        return 0;
+    }
+
+    if ((avail >= 2) && (p[0] == p[1]))
+    {
+        /* a run.  a missing count is treated as a run of just the pair */
+        token->kind = token_run;
+        token->symbol = p[0];
+        token->length = 2 + ((avail >= 3) ? p[2] : 0);
+        token->data = NULL;
+        reader->in.next += (avail >= 3) ? 3 : 2;
+        return 1;
+    }
+
+    /* literals continue up to the first pair of matching symbols */
+    i = FindPair(p, avail);
+
+    if (i == avail)
+    {
+        /* nothing follows the last symbol if this is the end of the data */
+        i = reader->in.eof ? avail : avail - 1;
+    }
+
+    token->kind = token_literal;
+    token->data = p;
+    token->length = i;
+    reader->in.next += i;
+    return 1;
+}
+
+/***************************************************************************
+*   Function   : NextVPackBitsToken
+*   Description: This routine reads the next token from data encoded by
+*                VPackBitsEncodeFile.  Copy blocks that span the end of the
+*                available data are returned as several literal tokens.
+*                Truncated blocks end the token stream.
+*   Parameters : reader - Pointer to the token reader
+*                token - Pointer to the token receiving the results
+*   Effects    : Encoded data is read from the reader's source
+*   Returned   : 1 if a token was read, 0 at the end of the encoded data,
+*                and -1 for a read error.
+***************************************************************************/
+static int NextVPackBitsToken(token_reader_t *reader, token_t *token)
+{
+    size_t avail;
+
+    token->kind = token_none;
+    token->length = 0;
+
+    if (0 == reader->copyLeft)
+    {
+        int header;
+
+        if (InEnsure(&reader->in, 2))
+        {
+            return -1;
+        }
+
+        avail = reader->in.end - reader->in.next;
+
+        if (0 == avail)
+        {
+            return 0;
+        }
+
+        header = (signed char)reader->in.next[0];
+
+        if (header < 0)
+        {
+            if (avail < 2)
+            {
+                reader->in.next = reader->in.end;
+                return 0;       /* run block is too short */
+            }
+
+            token->kind = token_run;
+            token->symbol = reader->in.next[1];
+            token->length = (MIN_RUN - 1) - header;
+            token->data = NULL;
+            reader->in.next += 2;
+            return 1;
+        }
+
+        reader->copyLeft = header + 1;
+        reader->in.next++;
+    }
+
+    if (InEnsure(&reader->in, 1))
+    {
+        return -1;
+    }
+
+    avail = reader->in.end - reader->in.next;
+
+    if (0 == avail)
+    {
+        reader->copyLeft = 0;
+        return 0;               /* copy block is too short */
+    }
+
+    token->kind = token_literal;
+    token->data = reader->in.next;
+    token->length = (avail < reader->copyLeft) ? avail : reader->copyLeft;
+    reader->copyLeft -= token->length;
+    reader->in.next += token->length;
+    return 1;
+}
+
+/***************************************************************************
+*   Function   : InitTokenWriter
+*   Description: This routine prepares a token writer for encoding data a
+*                run or literal block at a time.
+*   Parameters : writer - Pointer to the writer being initialized
+*                sink - Pointer to the sink receiving encoded data
+*                format - The encoding to write
+*   Effects    : writer is ready for use by WriteRun and WriteLiterals
+*   Returned   : None
+***************************************************************************/
+void InitTokenWriter(token_writer_t *writer, rle_sink_t *sink,
+    format_t format)
+{
+    InitOutStream(&writer->out, sink, writer->buf, IO_BUF_SIZE);
+    writer->format = format;
+    writer->runLen = 0;
+    writer->prevChar = EOF;
+    writer->inRun = 0;
+    writer->count = 0;
+    writer->copyLen = 0;
+}
+
+/***************************************************************************
+*   Function   : WriteRun
+*   Description: This routine adds a run to the encoded data.  The run is
+*                held back so that it can be merged with whatever follows
+*                it.
+*   Parameters : writer - Pointer to the writer
+*                symbol - Symbol of the run
+*                len - Length of the run
+*   Effects    : A held back run may be encoded
+*   Returned   : None
+***************************************************************************/
+void WriteRun(token_writer_t *writer, unsigned char symbol, size_t len)
+{
+    if ((writer->runLen > 0) && (symbol != writer->runSymbol))
+    {
+        FlushRun(writer);
+    }
+
+    writer->runSymbol = symbol;
+    writer->runLen += len;
+}
+
+/***************************************************************************
+*   Function   : WriteLiterals
+*   Description: This routine adds literals to the encoded data.  Leading
+*                symbols matching a held back run extend it, and the
+*                trailing run of the literals is held back in its place.
+*   Parameters : writer - Pointer to the writer
+*                data - Pointer to the literals
+*                len - Number of literals
+*   Effects    : Literals and held back runs may be encoded
+*   Returned   : None
+***************************************************************************/
+void WriteLiterals(token_writer_t *writer, const unsigned char *data,
+    size_t len)
+{
+    size_t tail;
+
+    if (writer->runLen > 0)
+    {
+        tail = ScanRun(data, len, writer->runSymbol);
+        writer->runLen += tail;
+        data += tail;
+        len -= tail;
+
+        if (0 == len)
+        {
+            return;
+        }
+
+        FlushRun(writer);
+    }
+
+    for (tail = 1; (tail < len) && (data[len - tail - 1] == data[len - 1]);
+        tail++)
+    {
+        /* count the symbols in the trailing run */
+    }
+
+    if (format_vpackbits == writer->format)
+    {
+        VPackBitsPutLiterals(writer, data, len - tail);
+    }
+    else
+    {
+        RlePutLiterals(writer, data, len - tail);
+    }
+
+    writer->runSymbol = data[len - 1];
+    writer->runLen = tail;
+}
+
+/***************************************************************************
+*   Function   : FlushRun
+*   Description: This routine encodes the held back run.
+*   Parameters : writer - Pointer to the writer
+*   Effects    : The held back run is encoded
+*   Returned   : None
+***************************************************************************/
+static void FlushRun(token_writer_t *writer)
+{
+    if (format_vpackbits == writer->format)
+    {
+        VPackBitsPutRun(writer, writer->runSymbol, writer->runLen);
+    }
+    else
+    {
+        RlePutRun(writer, writer->runSymbol, writer->runLen);
+    }
+
+    writer->runLen = 0;
+}
+
+/***************************************************************************
+*   Function   : FinishTokenWriter
+*   Description: This routine encodes everything still held by the writer
+*                and flushes its output.
+*   Parameters : writer - Pointer to the writer
+*   Effects    : The end of the encoded data is written
+*   Returned   : 0 for success, -1 for a write error (errno will be set).
+***************************************************************************/
+int FinishTokenWriter(token_writer_t *writer)
+{
+    FlushRun(writer);
+
+    if (format_vpackbits == writer->format)
+    {
+        VPackBitsFlushCopies(writer);
+    }
+    else if (writer->inRun)
+    {
+        OUT_PUTC(&writer->out, writer->count);
+    }
+
+    return OutFinish(&writer->out);
+}
+
+/***************************************************************************
+*   Function   : RlePutRun
+*   Description: This routine encodes a run using traditional RLE.  It
+*                makes the same choices as RleEncode would for the same
+*                symbols, so runs continue any run or pair in progress.
+*   Parameters : writer - Pointer to the writer
+*                symbol - Symbol of the run
+*                len - Length of the run
+*   Effects    : The run is encoded
+*   Returned   : None
+***************************************************************************/
+static void RlePutRun(token_writer_t *writer, unsigned char symbol,
+    size_t len)
+{
+    while (len > 0)
+    {
+        if (writer->inRun)
+        {
+            if (symbol == writer->prevChar)
+            {
+                size_t k;
+
+                k = UCHAR_MAX - writer->count;
+                k = (k < len) ? k : len;
+                writer->count += k;
+                len -= k;
+
+                if (writer->count < UCHAR_MAX)
+                {
+                    break;              /* the run may go on */
+                }
+            }
+
+            /* run is as long as it can get or a new symbol ended it */
+            OUT_PUTC(&writer->out, writer->count);
+            writer->inRun = 0;
+            writer->prevChar = EOF;
+            continue;
+        }
+
+        OUT_PUTC(&writer->out, symbol);
+        len--;
+
+        if (symbol == writer->prevChar)
+        {
+            writer->inRun = 1;
+            writer->count = 0;
+        }
+        else
+        {
+            writer->prevChar = symbol;
+        }
+    }
+}
+
+/***************************************************************************
+*   Function   : RlePutLiterals
+*   Description: This routine encodes literals using traditional RLE.
+*                Spans without pairs are written as is, and pairs are
+*                passed to RlePutRun.
+*   Parameters : writer - Pointer to the writer
+*                data - Pointer to the literals
+*                len - Number of literals
+*   Effects    : The literals are encoded
+*   Returned   : None
+***************************************************************************/
+static void RlePutLiterals(token_writer_t *writer, const unsigned char *data,
+    size_t len)
+{
+    while (len > 0)
+    {
+        size_t span;
+
+        if (writer->inRun || (data[0] == writer->prevChar))
+        {
+            RlePutRun(writer, data[0], 1);
+            data++;
+            len--;
+            continue;
+        }
+
+        /* everything up to and including the first symbol of a pair */
+        span = FindPair(data, len);
+        span += (span < len) ? 1 : 0;
+        OutWrite(&writer->out, data, span);
+        writer->prevChar = data[span - 1];
+        data += span;
+        len -= span;
+    }
+}
+
+/***************************************************************************
+*   Function   : VPackBitsPutRun
+*   Description: This routine encodes a run using the packbits variant.
+*                Runs too short to encode join the copy block.
+*   Parameters : writer - Pointer to the writer
+*                symbol - Symbol of the run
+*                len - Length of the run
+*   Effects    : The run is encoded
+*   Returned   : None
+***************************************************************************/
+static void VPackBitsPutRun(token_writer_t *writer, unsigned char symbol,
+    size_t len)
+{
+    while (len >= MIN_RUN)
+    {
+        size_t run;
+
+        run = (len < MAX_RUN) ? len : MAX_RUN;
+        VPackBitsFlushCopies(writer);
+        OUT_PUTC(&writer->out, (MIN_RUN - 1) - (int)run);
+        OUT_PUTC(&writer->out, symbol);
+        len -= run;
+    }
+
+    while (len > 0)
+    {
+        VPackBitsPutCopies(writer, &symbol, 1);
+        len--;
+    }
+}
+
+/***************************************************************************
+*   Function   : VPackBitsPutLiterals
+*   Description: This routine encodes literals using the packbits variant.
+*                Runs of MIN_RUN or more symbols within the literals are
+*                encoded as runs.
+*   Parameters : writer - Pointer to the writer
+*                data - Pointer to the literals
+*                len - Number of literals
+*   Effects    : The literals are encoded
+*   Returned   : None
+***************************************************************************/
+static void VPackBitsPutLiterals(token_writer_t *writer,
+    const unsigned char *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t span;
+
+        span = FindTriple(data, len);
+        VPackBitsPutCopies(writer, data, span);
+        data += span;
+        len -= span;
+
+        if (len > 0)
+        {
+            span = ScanRun(data, len, data[0]);
+            VPackBitsPutRun(writer, data[0], span);
+            data += span;
+            len -= span;
+        }
+    }
+}
+
+/***************************************************************************
+*   Function   : VPackBitsPutCopies
+*   Description: This routine adds symbols to the copy block, writing the
+*                block out each time it fills.
+*   Parameters : writer - Pointer to the writer
+*                data - Pointer to the symbols
+*                len - Number of symbols
+*   Effects    : Copy blocks may be encoded
+*   Returned   : None
+***************************************************************************/
+static void VPackBitsPutCopies(token_writer_t *writer,
+    const unsigned char *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t space;
+
+        space = MAX_COPY - writer->copyLen;
+        space = (space < len) ? space : len;
+        memcpy(writer->copy + writer->copyLen, data, space);
+        writer->copyLen += space;
+        data += space;
+        len -= space;
+
+        if (MAX_COPY == writer->copyLen)
+        {
+            VPackBitsFlushCopies(writer);
+        }
+    }
+}
+
+/***************************************************************************
+*   Function   : VPackBitsFlushCopies
+*   Description: This routine encodes the copy block if it isn't empty.
+*   Parameters : writer - Pointer to the writer
+*   Effects    : The copy block is encoded and emptied
+*   Returned   : None
+***************************************************************************/
+static void VPackBitsFlushCopies(token_writer_t *writer)
+{
+    if (writer->copyLen > 0)
+    {
+        OUT_PUTC(&writer->out, writer->copyLen - 1);
+        OutWrite(&writer->out, writer->copy, writer->copyLen);
+        writer->copyLen = 0;
+    }
+}
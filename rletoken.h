@@ -0,0 +1,122 @@
+/***************************************************************************
+*               Header for Encoded Token Stream Reading Routines
+*
+*   File    : rletoken.h
+*   Purpose : Provides the internal interface used by library routines that
+*             need to walk the runs and literal blocks of an encoded file
+*             without expanding them, or to encode data a run or literal
+*             block at a time.  This header is not part of the public
+*             library interface.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+#ifndef _RLETOKEN_H_
+#define _RLETOKEN_H_
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stddef.h>
+#include "rle.h"
+#include "rleio.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define TOKEN_MAX_COPY  128             /* longest vpackbits copy block */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef enum
+{
+    format_rle = 0,                     /* traditional RLE */
+    format_vpackbits = 1                /* packbits variant */
+} format_t;
+
+typedef enum
+{
+    token_none = 0,                     /* end of encoded data */
+    token_literal = 1,                  /* block of verbatim symbols */
+    token_run = 2                       /* run of a single symbol */
+} token_kind_t;
+
+typedef struct
+{
+    token_kind_t kind;                  /* type of token */
+    unsigned char symbol;               /* symbol repeated by a run */
+    size_t length;                      /* number of decoded symbols */
+    const unsigned char *data;          /* literal symbols (valid until the
+                                           next call to NextToken) */
+} token_t;
+
+typedef struct
+{
+    in_stream_t in;                     /* encoded input */
+    format_t format;                    /* encoding used by the input */
+    size_t copyLeft;                    /* unread bytes of a vpackbits copy
+                                           block */
+    unsigned char buf[IO_BUF_SIZE];     /* used if the source can't lend */
+} token_reader_t;
+
+typedef struct
+{
+    out_stream_t out;                   /* encoded output */
+    format_t format;                    /* encoding to write */
+    unsigned char runSymbol;            /* run not yet encoded, merged with */
+    size_t runLen;                      /* any run of the same symbol */
+    int prevChar;                       /* rle: symbol that may start a pair */
+    int inRun;                          /* rle: counting copies of prevChar */
+    unsigned int count;                 /* rle: copies after the pair */
+    size_t copyLen;                     /* vpackbits: symbols in copy */
+    unsigned char copy[TOKEN_MAX_COPY]; /* vpackbits: copy block */
+    unsigned char buf[IO_BUF_SIZE];     /* used if the sink can't lend */
+} token_writer_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+
+/* prepare a reader for the encoded data from a source */
+void InitTokenReader(token_reader_t *reader, rle_source_t *source,
+    format_t format);
+
+/* get the next token.  returns 1 for a token, 0 at the end, -1 for error */
+int NextToken(token_reader_t *reader, token_t *token);
+
+/* prepare a writer for encoding tokens to a sink */
+void InitTokenWriter(token_writer_t *writer, rle_sink_t *sink,
+    format_t format);
+
+/* encode a run or literals.  adjacent tokens are merged where possible */
+void WriteRun(token_writer_t *writer, unsigned char symbol, size_t len);
+void WriteLiterals(token_writer_t *writer, const unsigned char *data,
+    size_t len);
+
+/* encode anything held back and flush.  returns 0 or -1 for error */
+int FinishTokenWriter(token_writer_t *writer);
+
+#endif  /* ndef _RLETOKEN_H_ */
@@ -0,0 +1,199 @@
+/***************************************************************************
+*                 Conversion Between Run Length Encodings
+*
+*   File    : rletranscode.c
+*   Purpose : Convert data encoded by the traditional RLE encoder to the
+*             packbits variant and back without decoding it.  The encoded
+*             data is read as a stream of runs and literal blocks, and the
+*             same runs and literals are written in the other encoding, so
+*             a run costs the same no matter how long it is and memory use
+*             doesn't depend on the size of the data.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "rle.h"
+#include "rletoken.h"
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef struct
+{
+    token_reader_t reader;              /* tokens in the old encoding */
+    token_writer_t writer;              /* tokens in the new encoding */
+} transcoder_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int Transcode(rle_source_t *source, format_t from, rle_sink_t *sink,
+    format_t to);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleToVPackBitsFile
+*   Description: This routine converts a file encoded by RleEncodeFile to
+*                the encoding written by VPackBitsEncodeFile.
+*   Parameters : inFile - Pointer to the file to convert
+*                outFile - Pointer to the file receiving the converted data
+*   Effects    : Encoded data is converted
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int RleToVPackBitsFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return Transcode(&source, format_rle, &sink, format_vpackbits);
+}
+
+/***************************************************************************
+*   Function   : VPackBitsToRleFile
+*   Description: This routine converts a file encoded by
+*                VPackBitsEncodeFile to the encoding written by
+*                RleEncodeFile.
+*   Parameters : inFile - Pointer to the file to convert
+*                outFile - Pointer to the file receiving the converted data
+*   Effects    : Encoded data is converted
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int VPackBitsToRleFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return Transcode(&source, format_vpackbits, &sink, format_rle);
+}
+
+/***************************************************************************
+*   Function   : RleToVPackBits, VPackBitsToRle
+*   Description: These routines convert encoded data read from a source
+*                to the other encoding, writing it to a sink.
+*   Parameters : source - Pointer to the source of encoded data
+*                sink - Pointer to the sink receiving the converted data
+*   Effects    : Encoded data is converted
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleToVPackBits(rle_source_t *source, rle_sink_t *sink)
+{
+    return Transcode(source, format_rle, sink, format_vpackbits);
+}
+
+int VPackBitsToRle(rle_source_t *source, rle_sink_t *sink)
+{
+    return Transcode(source, format_vpackbits, sink, format_rle);
+}
+
+/***************************************************************************
+*   Function   : Transcode
+*   Description: This routine passes every token of the encoded data to a
+*                writer for the other encoding.  Runs stay runs, literal
+*                blocks become copy blocks or literals, and the writer
+*                repacks runs that are too short for the new encoding.
+*   Parameters : source - Pointer to the source of encoded data
+*                from - Encoding used by the source
+*                sink - Pointer to the sink receiving the converted data
+*                to - Encoding to write
+*   Effects    : Encoded data is converted
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+static int Transcode(rle_source_t *source, format_t from, rle_sink_t *sink,
+    format_t to)
+{
+    transcoder_t *transcoder;
+    token_t token;
+    int result;
+
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    transcoder = (transcoder_t *)malloc(sizeof(transcoder_t));
+
+    if (NULL == transcoder)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    InitTokenReader(&transcoder->reader, source, from);
+    InitTokenWriter(&transcoder->writer, sink, to);
+    result = 0;
+
+    while (!transcoder->writer.out.error &&
+        ((result = NextToken(&transcoder->reader, &token)) > 0))
+    {
+        if (token_run == token.kind)
+        {
+            WriteRun(&transcoder->writer, token.symbol, token.length);
+        }
+        else
+        {
+            WriteLiterals(&transcoder->writer, token.data, token.length);
+        }
+    }
+
+    if (FinishTokenWriter(&transcoder->writer))
+    {
+        result = -1;
+    }
+
+    free(transcoder);
+    return (result < 0) ? -1 : 0;
+}
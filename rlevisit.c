@@ -0,0 +1,519 @@
+/***************************************************************************
+*                Compressed Domain Aggregation Library
+*
+*   File    : rlevisit.c
+*   Purpose : Walk data encoded by the traditional RLE or the packbits
+*             variant encoder as runs and literal blocks without decoding
+*             it, handing each one to a caller supplied visitor.  Built on
+*             the walk are aggregations (a histogram with the sum, minimum,
+*             and maximum derived from it, and the count of one value)
+*             that use a run's length arithmetically, so their cost
+*             depends on the number of runs and literals rather than the
+*             size of the decoded data.
+*   Author  : Michael Dipperstein
+*   Date    : October 19, 2026
+*
+****************************************************************************
+*
+* RLE: An ANSI C Run Length Encoding/Decoding Routines
+* Copyright (C) 2026 by
+*       Michael Dipperstein (mdipperstein@gmail.com)
+*
+* This file is part of the RLE library.
+*
+* The RLE library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as published
+* by the Free Software Foundation; either version 3 of the License, or (at
+* your option) any later version.
+*
+* The RLE library is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser
+* General Public License for more details.
+*
+* You should have received a copy of the GNU Lesser General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+***************************************************************************/
+
+/***************************************************************************
+*                             INCLUDED FILES
+***************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "rle.h"
+#include "rletoken.h"
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define LANES           4               /* histograms filled in parallel */
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef struct
+{
+    unsigned char value;                /* value being counted */
+    unsigned long count;                /* occurrences so far */
+} count_t;
+
+/* working storage for Stats, too large for the stack */
+typedef struct
+{
+    token_reader_t reader;              /* tokens of the encoded data */
+    unsigned long lanes[LANES][256];    /* histograms filled in parallel */
+} stats_work_t;
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static int Visit(rle_source_t *source, format_t format, rle_visit_t visit,
+    void *userData);
+static int Stats(rle_source_t *source, format_t format, rle_stats_t *stats);
+static int CountValue(rle_source_t *source, format_t format,
+    unsigned char value, unsigned long *count);
+static int CountVisitor(const rle_segment_t *segment, void *userData);
+
+/***************************************************************************
+*                                FUNCTIONS
+***************************************************************************/
+
+/***************************************************************************
+*   Function   : RleVisit, VPackBitsVisit
+*   Description: These routines walk data encoded by RleEncode or
+*                VPackBitsEncode, calling a visitor with each run and
+*                literal block in order.  A run's segment has a NULL data
+*                pointer and gives its symbol and length.  A literal
+*                block's segment points to its symbols, which are only
+*                valid until the visitor returns.  Runs are never expanded.
+*   Parameters : source - Pointer to the source of encoded data
+*                visit - Function called with each segment.  The walk
+*                        stops if it returns non-zero.
+*                userData - Pointer passed unmodified to visit
+*   Effects    : Encoded data is read and visit is called for each segment
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleVisit(rle_source_t *source, rle_visit_t visit, void *userData)
+{
+    return Visit(source, format_rle, visit, userData);
+}
+
+int VPackBitsVisit(rle_source_t *source, rle_visit_t visit, void *userData)
+{
+    return Visit(source, format_vpackbits, visit, userData);
+}
+
+/***************************************************************************
+*   Function   : RleVisitFile, VPackBitsVisitFile
+*   Description: These routines are the same as RleVisit and
+*                VPackBitsVisit, except that the encoded data is read from
+*                a file.
+*   Parameters : inFile - Pointer to the encoded file
+*                visit - Function called with each segment.  The walk
+*                        stops if it returns non-zero.
+*                userData - Pointer passed unmodified to visit
+*   Effects    : Encoded file is read and visit is called for each segment
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  inFile will be left open.
+***************************************************************************/
+int RleVisitFile(FILE *inFile, rle_visit_t visit, void *userData)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return Visit(&source, format_rle, visit, userData);
+}
+
+int VPackBitsVisitFile(FILE *inFile, rle_visit_t visit, void *userData)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return Visit(&source, format_vpackbits, visit, userData);
+}
+
+/***************************************************************************
+*   Function   : RleStats, VPackBitsStats
+*   Description: These routines compute a histogram of the decoded bytes
+*                of data encoded by RleEncode or VPackBitsEncode, along
+*                with their number, sum, minimum, and maximum, without
+*                decoding it.
+*   Parameters : source - Pointer to the source of encoded data
+*                stats - Pointer to the structure receiving the results
+*   Effects    : Encoded data is read and stats is filled in
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleStats(rle_source_t *source, rle_stats_t *stats)
+{
+    return Stats(source, format_rle, stats);
+}
+
+int VPackBitsStats(rle_source_t *source, rle_stats_t *stats)
+{
+    return Stats(source, format_vpackbits, stats);
+}
+
+/***************************************************************************
+*   Function   : RleStatsFile, VPackBitsStatsFile
+*   Description: These routines are the same as RleStats and
+*                VPackBitsStats, except that the encoded data is read from
+*                a file.
+*   Parameters : inFile - Pointer to the encoded file
+*                stats - Pointer to the structure receiving the results
+*   Effects    : Encoded file is read and stats is filled in
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  inFile will be left open.
+***************************************************************************/
+int RleStatsFile(FILE *inFile, rle_stats_t *stats)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return Stats(&source, format_rle, stats);
+}
+
+int VPackBitsStatsFile(FILE *inFile, rle_stats_t *stats)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return Stats(&source, format_vpackbits, stats);
+}
+
+/***************************************************************************
+*   Function   : RleCountValue, VPackBitsCountValue
+*   Description: These routines count the decoded bytes of data encoded by
+*                RleEncode or VPackBitsEncode that equal a value, without
+*                decoding it.
+*   Parameters : source - Pointer to the source of encoded data
+*                value - The value to count
+*                count - Set to the number of decoded bytes equal to value
+*   Effects    : Encoded data is read
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int RleCountValue(rle_source_t *source, unsigned char value,
+    unsigned long *count)
+{
+    return CountValue(source, format_rle, value, count);
+}
+
+int VPackBitsCountValue(rle_source_t *source, unsigned char value,
+    unsigned long *count)
+{
+    return CountValue(source, format_vpackbits, value, count);
+}
+
+/***************************************************************************
+*   Function   : RleCountValueFile, VPackBitsCountValueFile
+*   Description: These routines are the same as RleCountValue and
+*                VPackBitsCountValue, except that the encoded data is read
+*                from a file.
+*   Parameters : inFile - Pointer to the encoded file
+*                value - The value to count
+*                count - Set to the number of decoded bytes equal to value
+*   Effects    : Encoded file is read
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  inFile will be left open.
+***************************************************************************/
+int RleCountValueFile(FILE *inFile, unsigned char value,
+    unsigned long *count)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return CountValue(&source, format_rle, value, count);
+}
+
+int VPackBitsCountValueFile(FILE *inFile, unsigned char value,
+    unsigned long *count)
+{
+    rle_source_t source;
+
+    if (NULL == inFile)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    return CountValue(&source, format_vpackbits, value, count);
+}
+
+/***************************************************************************
+*   Function   : Visit
+*   Description: This routine reads the tokens of encoded data and hands
+*                each one to a visitor as a segment.
+*   Parameters : source - Pointer to the source of encoded data
+*                format - Encoding used by the data
+*                visit - Function called with each segment
+*                userData - Pointer passed unmodified to visit
+*   Effects    : Encoded data is read and visit is called for each segment
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+static int Visit(rle_source_t *source, format_t format, rle_visit_t visit,
+    void *userData)
+{
+    token_reader_t *reader;
+    token_t token;
+    rle_segment_t segment;
+    int result;
+
+    /* validate parameters */
+    if ((NULL == source) || (NULL == visit))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* the reader holds an IO_BUF_SIZE buffer, keep it off the stack */
+    reader = (token_reader_t *)malloc(sizeof(token_reader_t));
+
+    if (NULL == reader)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    InitTokenReader(reader, source, format);
+    segment.offset = 0;
+
+    while ((result = NextToken(reader, &token)) > 0)
+    {
+        segment.length = token.length;
+
+        if (token_run == token.kind)
+        {
+            segment.data = NULL;
+            segment.symbol = token.symbol;
+        }
+        else
+        {
+            segment.data = token.data;
+            segment.symbol = token.data[0];
+        }
+
+        if (visit(&segment, userData))
+        {
+            result = 0;
+            break;
+        }
+
+        segment.offset += token.length;
+    }
+
+    free(reader);
+    return (result < 0) ? -1 : 0;
+}
+
+/***************************************************************************
+*   Function   : Stats
+*   Description: This routine builds a histogram of the decoded data by
+*                adding each run's length to its symbol's count and
+*                counting literals one at a time.  Literals are spread over
+*                LANES histograms, so that repeats of a symbol don't wait
+*                on each other's increments.  The other results are found
+*                from the histogram.
+*   Parameters : source - Pointer to the source of encoded data
+*                format - Encoding used by the data
+*                stats - Pointer to the structure receiving the results
+*   Effects    : Encoded data is read and stats is filled in
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+static int Stats(rle_source_t *source, format_t format, rle_stats_t *stats)
+{
+    stats_work_t *work;
+    unsigned long (*lanes)[256];
+    token_t token;
+    unsigned long *histogram;
+    int result;
+    size_t i;
+
+    /* validate parameters */
+    if ((NULL == source) || (NULL == stats))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    work = (stats_work_t *)malloc(sizeof(stats_work_t));
+
+    if (NULL == work)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    lanes = work->lanes;
+    memset(work->lanes, 0, sizeof(work->lanes));
+    histogram = stats->histogram;
+    InitTokenReader(&work->reader, source, format);
+
+    while ((result = NextToken(&work->reader, &token)) > 0)
+    {
+        const unsigned char *data;
+
+        if (token_run == token.kind)
+        {
+            lanes[0][token.symbol] += token.length;
+            continue;
+        }
+
+        data = token.data;
+
+        for (i = 0; (i + LANES) <= token.length; i += LANES)
+        {
+            lanes[0][data[i]]++;
+            lanes[1][data[i + 1]]++;
+            lanes[2][data[i + 2]]++;
+            lanes[3][data[i + 3]]++;
+        }
+
+        for (; i < token.length; i++)
+        {
+            lanes[0][data[i]]++;
+        }
+    }
+
+    if (result < 0)
+    {
+        free(work);
+        return -1;
+    }
+
+    stats->length = 0;
+    stats->sum = 0;
+    stats->min = -1;
+    stats->max = -1;
+
+    for (i = 0; i < 256; i++)
+    {
+        histogram[i] = lanes[0][i] + lanes[1][i] + lanes[2][i] + lanes[3][i];
+
+        if (histogram[i] > 0)
+        {
+            if (stats->min < 0)
+            {
+                stats->min = (int)i;
+            }
+
+            stats->max = (int)i;
+            stats->length += histogram[i];
+            stats->sum += histogram[i] * i;
+        }
+    }
+
+    free(work);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : CountValue
+*   Description: This routine visits the encoded data with CountVisitor.
+*   Parameters : source - Pointer to the source of encoded data
+*                format - Encoding used by the data
+*                value - The value to count
+*                count - Set to the number of decoded bytes equal to value
+*   Effects    : Encoded data is read
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+static int CountValue(rle_source_t *source, format_t format,
+    unsigned char value, unsigned long *count)
+{
+    count_t counter;
+
+    if (NULL == count)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    counter.value = value;
+    counter.count = 0;
+
+    if (Visit(source, format, CountVisitor, &counter))
+    {
+        return -1;
+    }
+
+    *count = counter.count;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : CountVisitor
+*   Description: This routine adds the number of symbols in a segment that
+*                equal the value being counted to the count.  A matching
+*                run adds its length.
+*   Parameters : segment - Pointer to the segment
+*                userData - Pointer to the count_t being updated
+*   Effects    : The count is updated
+*   Returned   : 0 (keep going)
+***************************************************************************/
+static int CountVisitor(const rle_segment_t *segment, void *userData)
+{
+    count_t *counter;
+    unsigned long count;
+    size_t i;
+
+    counter = (count_t *)userData;
+
+    if (NULL == segment->data)
+    {
+        if (segment->symbol == counter->value)
+        {
+            counter->count += segment->length;
+        }
+
+        return 0;
+    }
+
+    /* simple enough for the compiler to vectorize */
+    count = 0;
+
+    for (i = 0; i < segment->length; i++)
+    {
+        count += (segment->data[i] == counter->value);
+    }
+
+    counter->count += count;
+    return 0;
+}
@@ -9,7 +9,7 @@
 ****************************************************************************
 *
 * SAMPLE: Sample usage of Run Length Encoding Library
-* Copyright (C) 2004, 2006-2007, 2015, 2017 by
+* Copyright (C) 2004, 2006-2007, 2015, 2017, 2026 by
 *       Michael Dipperstein (mdipperstein@gmail.com)
 *
 * This file is part of the RLE library.
@@ -32,12 +32,33 @@
 /***************************************************************************
 *                             INCLUDED FILES
 ***************************************************************************/
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <signal.h>
 #include "optlist/optlist.h"
 #include "rle.h"
 
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+
+/***************************************************************************
+*                                CONSTANTS
+***************************************************************************/
+#define BLOCK_SIZE      (1024 * 1024)   /* size of each read and write */
+#define PROGRESS_INTERVAL   (16UL << 20)    /* bytes between progress lines */
+#define ASYNC_DEPTH     4               /* blocks in flight with -u */
+
 /***************************************************************************
 *                            TYPE DEFINITIONS
 ***************************************************************************/
@@ -48,13 +69,56 @@ typedef enum
     mode_decode_normal = (1 << 1),
     mode_packbits = (1 << 2),
     mode_encode_packbits = (1 << 2) | 1,
-    mode_decode_packbits = (1 << 2) | (1 << 1)
-} mode_t;
+    mode_decode_packbits = (1 << 2) | (1 << 1),
+    mode_search_normal = (1 << 3),
+    mode_search_packbits = (1 << 3) | (1 << 2),
+    mode_transcode_normal = (1 << 4),
+    mode_transcode_packbits = (1 << 4) | (1 << 2),
+    mode_periodic = (1 << 5),
+    mode_encode_periodic = (1 << 5) | 1,
+    mode_decode_periodic = (1 << 5) | (1 << 1),
+    mode_standard = (1 << 6),
+    mode_encode_standard = (1 << 6) | 1,
+    mode_decode_standard = (1 << 6) | (1 << 1)
+} sample_mode_t;
 
 /***************************************************************************
 *                               PROTOTYPES
 ***************************************************************************/
 static void ShowUsage(const char *progName);
+static int PrintMatch(unsigned long offset, void *userData);
+static FILE *OpenFile(const char *name, FILE *stdFile, const char *mode);
+static FILE *OpenUpdate(const char *name);
+static int RunCodec(sample_mode_t mode, int blocks, int append, int sparse,
+    int progress, int async, const char *pattern, size_t rowBytes,
+    FILE *inFile, FILE *outFile);
+static int CallCodec(sample_mode_t mode, int blocks, int append, int sparse,
+    const char *pattern, size_t rowBytes, FILE *inFile, FILE *outFile,
+    rle_source_t *source, rle_sink_t *sink);
+static int ShowProgress(unsigned long consumed, unsigned long produced,
+    void *userData);
+static void CatchInterrupt(int sig);
+static int FdRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got);
+static int FdWrite(void *handle, const unsigned char *buf, size_t size);
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+#if defined(_WIN32)
+#define FILE_NO(f)          _fileno(f)
+#define READ_FD(fd, b, n)   _read((fd), (b), (unsigned int)(n))
+#define WRITE_FD(fd, b, n)  _write((fd), (b), (unsigned int)(n))
+#else
+#define FILE_NO(f)          fileno(f)
+#define READ_FD(fd, b, n)   read((fd), (b), (n))
+#define WRITE_FD(fd, b, n)  write((fd), (b), (n))
+#endif
+
+/***************************************************************************
+*                            GLOBAL VARIABLES
+***************************************************************************/
+static volatile sig_atomic_t interrupted = 0;   /* Ctrl-C while in progress */
 
 /***************************************************************************
 *                                FUNCTIONS
@@ -65,7 +129,9 @@ static void ShowUsage(const char *progName);
 *   Description: This is the main function for this program, it validates
 *                the command line input and, if valid, it will call
 *                functions to encode or decode a file using a run length
-*                encoding algorithm.
+*                encoding algorithm, or to search an encoded file.  A
+*                missing file name or a file name of "-" means stdin or
+*                stdout, so the program may be used in pipelines.
 *   Parameters : argc - number of parameters
 *                argv - parameter list
 *   Effects    : Encodes/Decodes input file
@@ -77,16 +143,30 @@ int main(int argc, char *argv[])
     option_t *thisOpt;
     FILE *inFile;
     FILE *outFile;
-    mode_t mode;
+    sample_mode_t mode;
+    const char *pattern;
+    size_t rowBytes;
+    int blocks;
+    int append;
+    int sparse;
+    int progress;
+    int async;
     int result;
 
     /* initialize data */
     inFile = NULL;
     outFile = NULL;
     mode = mode_none;
+    pattern = NULL;
+    rowBytes = 0;
+    blocks = 0;
+    append = 0;
+    sparse = 0;
+    progress = 0;
+    async = 0;
 
     /* parse command line */
-    optList = GetOptList(argc, argv, "cdvi:o:h?");
+    optList = GetOptList(argc, argv, "cdvbrtezpus:w:i:o:a:h?");
     thisOpt = optList;
 
     while (thisOpt != NULL)
@@ -105,6 +185,43 @@ int main(int argc, char *argv[])
                 mode |= mode_packbits;
                 break;
 
+            case 'b':       /* use standard packbits */
+                mode |= mode_standard;
+                break;
+
+            case 'w':       /* row length for standard packbits */
+                rowBytes = strtoul(thisOpt->argument, NULL, 0);
+                break;
+
+            case 'r':       /* use periodic pattern runs */
+                mode |= mode_periodic;
+                break;
+
+            case 't':       /* convert to the other encoding */
+                mode |= mode_transcode_normal;
+                break;
+
+            case 'e':       /* block container with entropy coding */
+                blocks = 1;
+                break;
+
+            case 'z':       /* leave holes for long runs of zeros */
+                sparse = 1;
+                break;
+
+            case 'p':       /* show progress */
+                progress = 1;
+                break;
+
+            case 'u':       /* keep several reads and writes in flight */
+                async = 1;
+                break;
+
+            case 's':       /* search mode */
+                mode |= mode_search_normal;
+                pattern = thisOpt->argument;
+                break;
+
             case 'i':       /* input file name */
                 if (inFile != NULL)
                 {
@@ -119,7 +236,8 @@ int main(int argc, char *argv[])
                     FreeOptList(optList);
                     return EINVAL;
                 }
-                else if ((inFile = fopen(thisOpt->argument, "rb")) == NULL)
+                else if ((inFile = OpenFile(thisOpt->argument, stdin, "rb"))
+                    == NULL)
                 {
                     perror("Opening Input File");
 
@@ -133,6 +251,7 @@ int main(int argc, char *argv[])
                 }
                 break;
 
+            case 'a':       /* encoded file to append to */
             case 'o':       /* output file name */
                 if (outFile != NULL)
                 {
@@ -147,7 +266,9 @@ int main(int argc, char *argv[])
                     FreeOptList(optList);
                     return EINVAL;
                 }
-                else if ((outFile = fopen(thisOpt->argument, "wb")) == NULL)
+                else if ((outFile = ('a' == thisOpt->option) ?
+                    OpenUpdate(thisOpt->argument) :
+                    OpenFile(thisOpt->argument, stdout, "wb")) == NULL)
                 {
                     perror("Opening Output File");
 
@@ -159,6 +280,8 @@ int main(int argc, char *argv[])
                     FreeOptList(optList);
                     return errno;
                 }
+
+                append = ('a' == thisOpt->option);
                 break;
 
             case 'h':
@@ -173,49 +296,113 @@ int main(int argc, char *argv[])
         thisOpt = optList;
     }
 
-    /* validate command line */
+    /* missing files are stdin and stdout */
     if (inFile == NULL)
     {
-        fprintf(stderr, "Input file must be provided\n");
-        ShowUsage(argv[0]);
+        inFile = OpenFile("-", stdin, "rb");
+    }
 
-        if (outFile != NULL)
-        {
-            free(outFile);
-        }
+    if (outFile == NULL)
+    {
+        outFile = OpenFile("-", stdout, "wb");
+    }
 
-        return EINVAL;
+    /* options used by only some modes are usage errors in the others */
+    if ((0 != rowBytes) && (mode_encode_standard != mode))
+    {
+        fprintf(stderr, "-w can only be used with -b -c\n");
+        mode = mode_none;
     }
-    else if (outFile == NULL)
+    else if (sparse && (mode & (mode_search_normal | mode_transcode_normal)))
     {
-        fprintf(stderr, "Output file must be provided\n");
-        ShowUsage(argv[0]);
-
-        if (inFile != NULL)
-        {
-            free(inFile);
-        }
-
-        return EINVAL;
+        fprintf(stderr, "-z can only be used with -c or -d\n");
+        mode = mode_none;
     }
 
-    /* we have valid parameters encode or decode */
+    /* we have valid parameters encode, decode, or search */
     switch (mode)
     {
         case mode_encode_normal:
-            result = RleEncodeFile(inFile, outFile);
+        case mode_decode_normal:
+        case mode_encode_packbits:
+        case mode_decode_packbits:
+            if (append && (blocks || (mode & mode_decode_normal)))
+            {
+                fprintf(stderr, "Only encoding without -e can append\n");
+                result = EINVAL;
+                break;
+            }
+
+            if (sparse && (blocks || append))
+            {
+                fprintf(stderr, "-z can't be used with -e or -a\n");
+                result = EINVAL;
+                break;
+            }
+
+            if (async && (sparse || append))
+            {
+                fprintf(stderr, "-u can't be used with -z or -a\n");
+                result = EINVAL;
+                break;
+            }
+
+            result = RunCodec(mode, blocks, append, sparse, progress, async,
+                pattern, rowBytes, inFile, outFile);
             break;
 
-        case mode_decode_normal:
-            result = RleDecodeFile(inFile, outFile);
+        case mode_encode_periodic:
+        case mode_decode_periodic:
+            if (!blocks && !append && !sparse)
+            {
+                result = RunCodec(mode, 0, 0, 0, progress, async, pattern,
+                    rowBytes, inFile, outFile);
+                break;
+            }
+
+            fprintf(stderr, "-r can't be used with -e, -a, or -z\n");
+            result = EINVAL;
             break;
 
-        case mode_encode_packbits:
-            result = VPackBitsEncodeFile(inFile, outFile);
+        case mode_encode_standard:
+        case mode_decode_standard:
+            if (!blocks && !append && !sparse)
+            {
+                result = RunCodec(mode, 0, 0, 0, progress, async, pattern,
+                    rowBytes, inFile, outFile);
+                break;
+            }
+
+            fprintf(stderr, "-b can't be used with -e, -a, or -z\n");
+            result = EINVAL;
             break;
 
-        case mode_decode_packbits:
-            result = VPackBitsDecodeFile(inFile, outFile);
+        case mode_search_normal:
+        case mode_search_packbits:
+            if (!blocks && !append)
+            {
+                result = RunCodec(mode, 0, 0, 0, progress, async, pattern,
+                    rowBytes, inFile, outFile);
+                break;
+            }
+
+            fprintf(stderr, "Block containers can't be searched and "
+                "search results can't be appended\n");
+            result = EINVAL;
+            break;
+
+        case mode_transcode_normal:
+        case mode_transcode_packbits:
+            if (!blocks && !append)
+            {
+                result = RunCodec(mode, 0, 0, 0, progress, async, pattern,
+                    rowBytes, inFile, outFile);
+                break;
+            }
+
+            fprintf(stderr, "Block containers can't be converted and "
+                "converted files can't be appended\n");
+            result = EINVAL;
             break;
 
         default:
@@ -224,8 +411,16 @@ int main(int argc, char *argv[])
             result = EINVAL;
     }
 
-    fclose(inFile);
-    fclose(outFile);
+    if (inFile != stdin)
+    {
+        fclose(inFile);
+    }
+
+    if (outFile != stdout)
+    {
+        fclose(outFile);
+    }
+
     return result;
 }
 
@@ -245,8 +440,537 @@ static void ShowUsage(const char *progName)
     printf("  -c : Encode input file to output file.\n");
     printf("  -d : Decode input file to output file.\n");
     printf("  -v : Use variant of packbits algorithm.\n");
-    printf("  -i <filename> : Name of input file.\n");
-    printf("  -o <filename> : Name of output file.\n");
+    printf("  -b : Use standard (TIFF/Apple) packbits algorithm.\n");
+    printf("  -r : Use periodic pattern runs (repeats of 1 to 8 bytes).\n");
+    printf("  -e : Use block container with entropy coding.\n");
+    printf("  -z : Skip holes in a sparse input when encoding, or decode to a"
+        " sparse file\n       (output must be seekable, with -c or -d"
+        " only).\n");
+    printf("  -t : Convert encoded input file to the other encoding.\n");
+    printf("  -p : Show progress on stderr (Ctrl-C stops cleanly).\n");
+    printf("  -u : Keep several reads and writes in flight (io_uring on"
+        " Linux).\n");
+    printf("  -s <pattern> : Search encoded input file for pattern.\n");
+    printf("  -w <bytes> : Pack rows of this length separately (with -b"
+        " -c).\n");
+    printf("  -i <filename> : Name of input file (default or - : stdin).\n");
+    printf("  -o <filename> : Name of output file (default or - : stdout).\n");
+    printf("  -a <filename> : Encode onto the end of an encoded file.\n");
     printf("  -h | ?  : Print out command line options.\n\n");
     printf("Default: sample -c\n");
 }
+
+/***************************************************************************
+*   Function   : PrintMatch
+*   Description: This function is called by the search routines for each
+*                match found.  It writes the decoded offset of the match to
+*                a file.
+*   Parameters : offset - decoded offset of the match
+*                userData - pointer to the FILE receiving the offsets
+*   Effects    : The offset is written to the file
+*   Returned   : 0 so that the search continues
+***************************************************************************/
+static int PrintMatch(unsigned long offset, void *userData)
+{
+    fprintf((FILE *)userData, "%lu\n", offset);
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : OpenFile
+*   Description: This function opens a file named on the command line.
+*                The name "-" means a standard stream, which is switched to
+*                binary mode where that matters.
+*   Parameters : name - the name of the file
+*                stdFile - stdin or stdout, used if name is "-"
+*                mode - mode passed to fopen
+*   Effects    : The file is opened
+*   Returned   : The opened file, or NULL for failure (errno will be set).
+***************************************************************************/
+static FILE *OpenFile(const char *name, FILE *stdFile, const char *mode)
+{
+    if (0 == strcmp(name, "-"))
+    {
+#if defined(_WIN32)
+        _setmode(_fileno(stdFile), _O_BINARY);
+#endif
+        return stdFile;
+    }
+
+    return fopen(name, mode);
+}
+
+/***************************************************************************
+*   Function   : OpenUpdate
+*   Description: This function opens an encoded file for appending.  The
+*                file must be both read and written, and is created if it
+*                doesn't exist.
+*   Parameters : name - the name of the file
+*   Effects    : The file is opened
+*   Returned   : The opened file, or NULL for failure (errno will be set).
+***************************************************************************/
+static FILE *OpenUpdate(const char *name)
+{
+    FILE *file;
+
+    file = fopen(name, "r+b");
+
+    if ((NULL == file) && (ENOENT == errno))
+    {
+        file = fopen(name, "w+b");
+    }
+
+    return file;
+}
+
+/***************************************************************************
+*   Function   : RunCodec
+*   Description: This function encodes, decodes, converts, or searches the
+*                input file.  The files are read and written a BLOCK_SIZE block
+*                at a time straight from their file descriptors, bypassing
+*                the small stdio buffers, so pipelines aren't slowed down by
+*                lots of tiny reads and writes.  With progress, the reads
+*                and writes go through a progress tap that shows how far
+*                the job has got on stderr and stops it cleanly on Ctrl-C.
+*                With async, the files are read and written by the
+*                library's asynchronous source and sink instead, which
+*                keep ASYNC_DEPTH blocks in flight.
+*   Parameters : mode - what to do with the input file
+*                blocks - non-zero to use the block container
+*                append - non-zero to encode onto the end of outFile
+*                sparse - non-zero to skip holes in inFile when encoding,
+*                         or to decode into a sparse outFile
+*                progress - non-zero to show progress
+*                async - non-zero for asynchronous I/O
+*                pattern - pattern to search for (search modes only)
+*                rowBytes - row length for standard PackBits encoding
+*                inFile - the input file
+*                outFile - the output file
+*   Effects    : The input is encoded, decoded, converted, or searched
+*   Returned   : 0 for success, errno for failure.
+***************************************************************************/
+static int RunCodec(sample_mode_t mode, int blocks, int append, int sparse,
+    int progress, int async, const char *pattern, size_t rowBytes,
+    FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
+    rle_progress_tap_t tap;
+    rle_async_t *inAsync, *outAsync;
+    time_t start;
+    int inFd, outFd;
+    int result;
+
+    inFd = FILE_NO(inFile);
+    outFd = FILE_NO(outFile);
+    source.handle = &inFd;
+    source.read = FdRead;
+    source.borrow = NULL;
+    sink.handle = &outFd;
+    sink.write = FdWrite;
+    sink.borrow = NULL;
+    sink.commit = NULL;
+    inAsync = NULL;
+    outAsync = NULL;
+
+    if (async)
+    {
+        /* search results are printed to outFile, it isn't a sink */
+        inAsync = RleAsyncOpen(inFile, 0, BLOCK_SIZE, ASYNC_DEPTH);
+
+        if ((NULL != inAsync) && !(mode & mode_search_normal))
+        {
+            outAsync = RleAsyncOpen(outFile, 1, BLOCK_SIZE, ASYNC_DEPTH);
+        }
+
+        if ((NULL == inAsync) ||
+            ((NULL == outAsync) && !(mode & mode_search_normal)))
+        {
+            result = errno;
+            perror("Starting Asynchronous I/O");
+
+            if (NULL != inAsync)
+            {
+                RleAsyncClose(inAsync);
+            }
+
+            return result;
+        }
+
+        RleAsyncSource(&source, inAsync);
+
+        if (NULL != outAsync)
+        {
+            RleAsyncSink(&sink, outAsync);
+        }
+    }
+
+    if (!progress)
+    {
+        result = CallCodec(mode, blocks, append, sparse, pattern, rowBytes,
+            inFile, outFile, &source, &sink);
+    }
+    else
+    {
+        start = time(NULL);
+        RleProgressTap(&tap, &source, &sink, PROGRESS_INTERVAL,
+            ShowProgress, &start);
+        signal(SIGINT, CatchInterrupt);
+        result = CallCodec(mode, blocks, append, sparse, pattern, rowBytes,
+            inFile, outFile, &tap.source, &tap.sink);
+        signal(SIGINT, SIG_DFL);
+        ShowProgress(tap.consumed, tap.produced, &start);
+        fprintf(stderr, "\n");
+    }
+
+    if (NULL != inAsync)
+    {
+        RleAsyncClose(inAsync);
+    }
+
+    /* queued writes can still fail */
+    if ((NULL != outAsync) && RleAsyncClose(outAsync) && (0 == result))
+    {
+        result = errno;
+        perror("Writing");
+    }
+
+    return result;
+}
+
+/***************************************************************************
+*   Function   : CallCodec
+*   Description: This function calls the library routine that does what
+*                mode asks for.
+*   Parameters : mode - what to do with the input file
+*                blocks - non-zero to use the block container
+*                append - non-zero to encode onto the end of outFile
+*                sparse - non-zero to skip holes in inFile when encoding,
+*                         or to decode into a sparse outFile
+*                pattern - pattern to search for (search modes only)
+*                rowBytes - row length for standard PackBits encoding
+*                inFile - the input file
+*                outFile - the output file
+*                source - source reading inFile
+*                sink - sink writing outFile
+*   Effects    : The input is encoded, decoded, converted, or searched
+*   Returned   : 0 for success, errno for failure.
+***************************************************************************/
+static int CallCodec(sample_mode_t mode, int blocks, int append, int sparse,
+    const char *pattern, size_t rowBytes, FILE *inFile, FILE *outFile,
+    rle_source_t *source, rle_sink_t *sink)
+{
+    rle_context_t *ctx;
+    void *arena;
+    size_t arenaSize;
+    int result;
+
+    if (mode & mode_search_normal)
+    {
+        if (mode & mode_packbits)
+        {
+            result = VPackBitsSearch(source, (const unsigned char *)pattern,
+                strlen(pattern), PrintMatch, outFile);
+        }
+        else
+        {
+            result = RleSearch(source, (const unsigned char *)pattern,
+                strlen(pattern), PrintMatch, outFile);
+        }
+
+        return (0 == result) ? 0 : errno;
+    }
+
+    if (mode & mode_transcode_normal)
+    {
+        if (mode & mode_packbits)
+        {
+            result = VPackBitsToRle(source, sink);
+        }
+        else
+        {
+            result = RleToVPackBits(source, sink);
+        }
+
+        if (0 != result)
+        {
+            result = errno;
+            perror("Converting");
+        }
+
+        return result;
+    }
+
+    if (mode & mode_standard)
+    {
+        if (mode & mode_decode_normal)
+        {
+            result = PackBitsDecode(source, sink);
+        }
+        else
+        {
+            result = PackBitsEncode(source, sink, rowBytes);
+        }
+
+        if (0 != result)
+        {
+            result = errno;
+            perror("Encoding/Decoding");
+        }
+
+        return result;
+    }
+
+    if (mode & mode_periodic)
+    {
+        if (mode & mode_decode_normal)
+        {
+            result = RlePatternDecode(source, sink);
+        }
+        else
+        {
+            result = RlePatternEncode(source, sink);
+        }
+
+        if (0 != result)
+        {
+            result = errno;
+            perror("Encoding/Decoding");
+        }
+
+        return result;
+    }
+
+    if (append)
+    {
+        /* the encoded file is reworked through stdio, it must seek */
+        if (mode & mode_packbits)
+        {
+            result = VPackBitsEncodeAppend(source, outFile);
+        }
+        else
+        {
+            result = RleEncodeAppend(source, outFile);
+        }
+
+        if (0 != result)
+        {
+            result = errno;
+            perror("Appending");
+        }
+
+        return result;
+    }
+
+    if (sparse && (mode & mode_encode_normal))
+    {
+        /* holes are found from inFile's descriptor */
+        if (mode & mode_packbits)
+        {
+            result = VPackBitsEncodeSparseFile(inFile, outFile);
+        }
+        else
+        {
+            result = RleEncodeSparseFile(inFile, outFile);
+        }
+
+        if (0 != result)
+        {
+            result = errno;
+            perror("Encoding");
+        }
+
+        return result;
+    }
+
+    if (sparse)
+    {
+        /* holes are made by seeking outFile through stdio */
+        if (mode & mode_packbits)
+        {
+            result = VPackBitsDecodeSparseFile(inFile, outFile, 0);
+        }
+        else
+        {
+            result = RleDecodeSparseFile(inFile, outFile, 0);
+        }
+
+        if (0 != result)
+        {
+            result = errno;
+            perror("Decoding");
+        }
+
+        return result;
+    }
+
+    if (blocks)
+    {
+        /* the container does its own buffering */
+        if (mode & mode_decode_normal)
+        {
+            result = RleBlockDecode(source, sink);
+        }
+        else
+        {
+            result = RleBlockEncode(source, sink, RLE_BLOCK_ENTROPY |
+                ((mode & mode_packbits) ? RLE_BLOCK_PACKBITS : 0));
+        }
+
+        if (0 != result)
+        {
+            result = errno;
+            perror("Encoding/Decoding");
+        }
+
+        return result;
+    }
+
+    arenaSize = RleContextSize(BLOCK_SIZE);
+    arena = malloc(arenaSize);
+
+    if (NULL == arena)
+    {
+        perror("Allocating Buffers");
+        return errno;
+    }
+
+    ctx = RleContextInit(arena, arenaSize);
+
+    switch (mode)
+    {
+        case mode_encode_normal:
+            result = RleEncodeCtx(ctx, source, sink);
+            break;
+
+        case mode_decode_normal:
+            result = RleDecodeCtx(ctx, source, sink);
+            break;
+
+        case mode_encode_packbits:
+            result = VPackBitsEncodeCtx(ctx, source, sink);
+            break;
+
+        default:
+            result = VPackBitsDecodeCtx(ctx, source, sink);
+            break;
+    }
+
+    if (0 != result)
+    {
+        result = errno;
+        perror("Encoding/Decoding");
+    }
+
+    free(arena);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : ShowProgress
+*   Description: This function is the progress callback.  It shows the
+*                amount of data read and written and the rate it is read
+*                at on stderr.
+*   Parameters : consumed - bytes read so far
+*                produced - bytes written so far
+*                userData - pointer to the time_t the job started at
+*   Effects    : A progress line is written to stderr
+*   Returned   : Non-zero to cancel the job after Ctrl-C, otherwise 0
+***************************************************************************/
+static int ShowProgress(unsigned long consumed, unsigned long produced,
+    void *userData)
+{
+    double seconds;
+
+    seconds = difftime(time(NULL), *(time_t *)userData);
+    fprintf(stderr, "\r%lu MB read, %lu MB written", consumed >> 20,
+        produced >> 20);
+
+    if (seconds >= 1.0)
+    {
+        fprintf(stderr, ", %.1f MB/s", (consumed / seconds) / 1048576.0);
+    }
+
+    return interrupted;
+}
+
+/***************************************************************************
+*   Function   : CatchInterrupt
+*   Description: This function is the SIGINT handler used while progress
+*                is shown.  It asks for the job to be cancelled, so the
+*                output is left complete for the input read so far.
+*   Parameters : sig - the signal number
+*   Effects    : interrupted is set
+*   Returned   : None
+***************************************************************************/
+static void CatchInterrupt(int sig)
+{
+    (void)sig;
+    interrupted = 1;
+}
+
+/***************************************************************************
+*   Function   : FdRead
+*   Description: This function is the read callback of a source reading
+*                from a file descriptor.
+*   Parameters : handle - pointer to the file descriptor
+*                buf - buffer receiving the data
+*                size - size of buf
+*                got - set to the number of bytes read (0 at end of file)
+*   Effects    : Data is read from the file descriptor
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int FdRead(void *handle, unsigned char *buf, size_t size,
+    size_t *got)
+{
+    long n;
+
+    do
+    {
+        n = (long)READ_FD(*(int *)handle, buf, size);
+    } while ((n < 0) && (EINTR == errno));
+
+    if (n < 0)
+    {
+        return -1;
+    }
+
+    *got = (size_t)n;
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : FdWrite
+*   Description: This function is the write callback of a sink writing to
+*                a file descriptor.  Short writes (common with pipes) are
+*                retried until all of the data is written.
+*   Parameters : handle - pointer to the file descriptor
+*                buf - data to write
+*                size - number of bytes to write
+*   Effects    : Data is written to the file descriptor
+*   Returned   : 0 for success, -1 for failure (errno will be set).
+***************************************************************************/
+static int FdWrite(void *handle, const unsigned char *buf, size_t size)
+{
+    long n;
+
+    while (size > 0)
+    {
+        n = (long)WRITE_FD(*(int *)handle, buf, size);
+
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        buf += n;
+        size -= (size_t)n;
+    }
+
+    return 0;
+}
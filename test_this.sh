@@ -28,10 +28,69 @@ do
         ./sample -d -v -i foo -o bar
         diff $X bar
         filesize=$(stat -c '%s' foo)
-        printf "vpackbits size:\t\t%d\n\n" $filesize
+        printf "vpackbits size:\t\t%d\n" $filesize
+        cat $X | ./sample -c | ./sample -d > bar
+        cmp $X bar
+        ./sample -c -e -i $X -o foo
+        ./sample -d -e -i foo -o bar
+        cmp $X bar
+        filesize=$(stat -c '%s' foo)
+        printf "block size:\t\t%d\n" $filesize
+        ./sample -c -e -v -i $X -o foo
+        ./sample -d -e -i foo -o bar
+        cmp $X bar
+        filesize=$(stat -c '%s' foo)
+        printf "vpackbits block size:\t%d\n" $filesize
+        ./sample -c -r -i $X -o foo
+        ./sample -d -r -i foo -o bar
+        cmp $X bar
+        filesize=$(stat -c '%s' foo)
+        printf "pattern size:\t\t%d\n" $filesize
+        ./sample -c -b -i $X -o foo
+        ./sample -d -b -i foo -o bar
+        cmp $X bar
+        filesize=$(stat -c '%s' foo)
+        printf "packbits size:\t\t%d\n" $filesize
+        ./sample -c -b -w 77 -i $X -o foo
+        ./sample -d -b -i foo -o bar
+        cmp $X bar
+        half=$(($(stat -c '%s' $X) / 2))
+        head -c $half $X | ./sample -c -o foo
+        tail -c +$(($half + 1)) $X | ./sample -c -a foo
+        ./sample -d -i foo -o bar
+        cmp $X bar
+        head -c $half $X | ./sample -c -v -o foo
+        tail -c +$(($half + 1)) $X | ./sample -c -v -a foo
+        ./sample -d -v -i foo -o bar
+        cmp $X bar
+        ./sample -c -z -i $X -o foo
+        ./sample -d -z -i foo -o bar
+        cmp $X bar
+        ./sample -c -z -v -i $X -o foo
+        ./sample -d -z -v -i foo -o bar
+        cmp $X bar
+        printf "\n"
         rm foo
         rm bar
     fi
 done
 
+printf "checking packbits example\n"
+printf '\xfe\xaa\x02\x80\x00\x2a\xfd\xaa\x03\x80\x00\x2a\x22\xf7\xaa' > foo
+printf '\xaa\xaa\xaa\x80\x00\x2a\xaa\xaa\xaa\xaa\x80\x00\x2a\x22' > bar
+printf '\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa\xaa' >> bar
+./sample -d -b -i foo | cmp - bar
+./sample -c -b -i bar | cmp - foo
+rm foo
+rm bar
+
+printf "checking sparse input\n"
+printf abc > foo
+truncate -s 3000000 foo
+printf xyz >> foo
+./sample -c -z -i foo -o bar
+./sample -d -i bar | cmp - foo
+rm foo
+rm bar
+
 exit 0
@@ -11,13 +11,17 @@
 *             0 - 127    | Copy the next n + 1 bytes
 *             -128 - -1  | Make -n + 2 copies of the next byte
 *
+*             The encoder and decoder process whole chunks of data from an
+*             rle_source_t and keep their state between chunks, so data
+*             may be delivered in any size pieces.
+*
 *   Author  : Michael Dipperstein
 *   Date    : September 7, 2006
 *
 ****************************************************************************
 *
 * VPackBits: ANSI C PackBits Style Run Length Encoding/Decoding Routines
-* Copyright (C) 2006-2007, 2015 by
+* Copyright (C) 2006-2007, 2015, 2026 by
 *       Michael Dipperstein (mdipperstein@gmail.com)
 *
 * This file is part of the RLE library.
@@ -41,8 +45,12 @@
 *                             INCLUDED FILES
 ***************************************************************************/
 #include <stdio.h>
-#include <limits.h>
+#include <string.h>
 #include <errno.h>
+#include "rle.h"
+#include "rleio.h"
+#include "rlecodec.h"
+#include "rlescan.h"
 
 /***************************************************************************
 *                                CONSTANTS
@@ -54,6 +62,78 @@
 /* maximum that can be read before copy block is written */
 #define MAX_READ    (MAX_COPY + MIN_RUN - 1)
 
+/* the fast decoder always stores FAST_STORE bytes at a time, so it needs
+ * this much readable input and writable output past the current token */
+#define FAST_STORE  32
+#define FAST_IN     (1 + MAX_COPY + FAST_STORE)
+#define FAST_OUT    (MAX_RUN + FAST_STORE)
+
+/***************************************************************************
+*                            TYPE DEFINITIONS
+***************************************************************************/
+typedef struct
+{
+    unsigned char charBuf[MAX_READ];    /* symbols not yet written */
+    size_t count;                       /* number of symbols in charBuf */
+    int inRun;                          /* non-zero while counting a run */
+    unsigned char runChar;              /* symbol in the current run */
+    size_t runLen;                      /* length of the current run */
+} vpb_encoder_t;
+
+typedef struct
+{
+    size_t copyLeft;                    /* symbols left in a copy block */
+    size_t runLen;                      /* run waiting for its symbol */
+} vpb_decoder_t;
+
+/* how to decode a block header */
+typedef struct
+{
+    unsigned char length;               /* decoded length of the block */
+    unsigned char size;                 /* encoded size with the header */
+    unsigned char copy;                 /* 1 for copy block, 0 for run */
+} vpb_header_t;
+
+/***************************************************************************
+*                                 MACROS
+***************************************************************************/
+
+/* build the header table entries for headers h through h + 15 */
+#define COPY(h)     {(h) + 1, (h) + 2, 1}
+#define RUN(h)      {(MIN_RUN - 1) + 256 - (h), 2, 0}
+#define COPY4(h)    COPY(h), COPY((h) + 1), COPY((h) + 2), COPY((h) + 3)
+#define RUN4(h)     RUN(h), RUN((h) + 1), RUN((h) + 2), RUN((h) + 3)
+#define COPY16(h)   COPY4(h), COPY4((h) + 4), COPY4((h) + 8), COPY4((h) + 12)
+#define RUN16(h)    RUN4(h), RUN4((h) + 4), RUN4((h) + 8), RUN4((h) + 12)
+
+/***************************************************************************
+*                               PROTOTYPES
+***************************************************************************/
+static void EncodeChunk(vpb_encoder_t *enc, const unsigned char *data,
+    size_t len, out_stream_t *out);
+static void AddSymbol(vpb_encoder_t *enc, unsigned char c,
+    out_stream_t *out);
+static void WriteCopies(out_stream_t *out, const unsigned char *first,
+    size_t firstLen, const unsigned char *second, size_t total);
+static void WriteRun(out_stream_t *out, unsigned char c, size_t len);
+static void DecodeChunk(vpb_decoder_t *dec, const unsigned char *data,
+    size_t len, out_stream_t *out);
+static const unsigned char *DecodeFast(const unsigned char *data,
+    const unsigned char *end, out_stream_t *out);
+
+/***************************************************************************
+*                            GLOBAL VARIABLES
+***************************************************************************/
+
+/* header byte -> block description.  0 - 127 copy, 128 - 255 run */
+static const vpb_header_t headerTable[256] =
+{
+    COPY16(0), COPY16(16), COPY16(32), COPY16(48),
+    COPY16(64), COPY16(80), COPY16(96), COPY16(112),
+    RUN16(128), RUN16(144), RUN16(160), RUN16(176),
+    RUN16(192), RUN16(208), RUN16(224), RUN16(240)
+};
+
 /***************************************************************************
 *                                FUNCTIONS
 ***************************************************************************/
@@ -72,9 +152,37 @@
 ***************************************************************************/
 int VPackBitsEncodeFile(FILE *inFile, FILE *outFile)
 {
-    int currChar;                       /* current character */
-    unsigned char charBuf[MAX_READ];    /* buffer of already read characters */
-    unsigned char count;                /* number of characters in a run */
+    rle_source_t source;
+    rle_sink_t sink;
+
+    /* validate input and output files */
+    if ((NULL == inFile) || (NULL == outFile))
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return VPackBitsEncode(&source, &sink);
+}
+
+/***************************************************************************
+*   Function   : VPackBitsDecodeFile
+*   Description: This routine opens a file encoded by a variant of the
+*                packbits run length encoding, and decodes it to an output
+*                file.
+*   Parameters : inFile - Pointer to the file to decode
+*                outFile - Pointer to the file to write decoded output to
+*   Effects    : Encoded file is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.  Either way, inFile and outFile will
+*                be left open.
+***************************************************************************/
+int VPackBitsDecodeFile(FILE *inFile, FILE *outFile)
+{
+    rle_source_t source;
+    rle_sink_t sink;
 
     /* validate input and output files */
     if ((NULL == inFile) || (NULL == outFile))
@@ -83,188 +191,652 @@ int VPackBitsEncodeFile(FILE *inFile, FILE *outFile)
         return -1;
     }
 
-    /* prime the read loop */
-    currChar = fgetc(inFile);
-    count = 0;
+    RleFileSource(&source, inFile);
+    RleFileSink(&sink, outFile);
+    return VPackBitsDecode(&source, &sink);
+}
+
+/***************************************************************************
+*   Function   : VPackBitsEncode
+*   Description: This routine reads data from a source and writes a
+*                version of it encoded with the packbits variant to a sink.
+*   Parameters : source - Pointer to the source of data to encode
+*                sink - Pointer to the sink receiving the encoded output
+*   Effects    : Data is encoded using RLE
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int VPackBitsEncode(rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
+
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
+
+    result = VPackBitsEncodeStream(&in, &out);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsEncodeStream
+*   Description: This routine encodes everything read from an input stream
+*                using the packbits variant, writing the results to an
+*                output stream.
+*                It does the work for every VPackBitsEncode variant, which only
+*                differ in where the stream buffers come from.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*   Effects    : Data is encoded using RLE
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int VPackBitsEncodeStream(in_stream_t *in, out_stream_t *out)
+{
+    vpb_encoder_t enc;
+    int result;
+
+    result = 0;
+
+    enc.count = 0;
+    enc.inRun = 0;
+    enc.runChar = 0;
+    enc.runLen = 0;
+
+    /* encode chunks until there's nothing left */
+    while (!out->error && ((result = InFill(in)) > 0))
+    {
+        EncodeChunk(&enc, in->next, in->end - in->next, out);
+        in->next = in->end;
+    }
+
+    if (enc.inRun)
+    {
+        /* file ends in a run */
+        WriteRun(out, enc.runChar, enc.runLen);
+    }
+    else
+    {
+        /* write out last buffer */
+        WriteCopies(out, enc.charBuf, enc.count, NULL, enc.count);
+    }
+
+    if (OutFinish(out) || (result < 0))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsDecode
+*   Description: This routine reads data encoded by a variant of the
+*                packbits run length encoding from a source and writes the
+*                decoded data to a sink.
+*   Parameters : source - Pointer to the source of encoded data
+*                sink - Pointer to the sink receiving the decoded output
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int VPackBitsDecode(rle_source_t *source, rle_sink_t *sink)
+{
+    in_stream_t in;
+    out_stream_t out;
+    int result;
+
+    /* validate source and sink */
+    if ((NULL == source) || (NULL == sink))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (OpenStreams(&in, source, &out, sink))
+    {
+        return -1;
+    }
+
+    result = VPackBitsDecodeStream(&in, &out);
+    CloseStreams(&in, &out);
+    return result;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsDecodeStream
+*   Description: This routine decodes packbits variant data read from an input
+*                stream, writing the results to an output stream.
+*                It does the work for every VPackBitsDecode variant, which only
+*                differ in where the stream buffers come from.
+*   Parameters : in - Pointer to the initialized input stream
+*                out - Pointer to the initialized output stream
+*   Effects    : Encoded data is decoded
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure.
+***************************************************************************/
+int VPackBitsDecodeStream(in_stream_t *in, out_stream_t *out)
+{
+    vpb_decoder_t dec;
+    int result;
+
+    result = 0;
+
+    dec.copyLeft = 0;
+    dec.runLen = 0;
+
+    /* decode chunks until there's nothing left */
+    while (!out->error && ((result = InFill(in)) > 0))
+    {
+        DecodeChunk(&dec, in->next, in->end - in->next, out);
+        in->next = in->end;
+    }
+
+    if (dec.runLen > 0)
+    {
+        fprintf(stderr, "Run block is too short!\n");
+    }
+    else if (dec.copyLeft > 0)
+    {
+        fprintf(stderr, "Copy block is too short!\n");
+    }
 
-    /* read input until there's nothing left */
-    while (currChar != EOF)
+    if (OutFinish(out) || (result < 0))
     {
-        charBuf[count] = (unsigned char)currChar;
+        return -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsMaxEncodedSize
+*   Description: This routine returns the largest possible size of data
+*                encoded by VPackBitsEncode.  The worst case is all
+*                literals, which costs one header for every MAX_COPY bytes.
+*   Parameters : len - Number of bytes being encoded
+*   Effects    : None
+*   Returned   : Worst case encoded size
+***************************************************************************/
+size_t VPackBitsMaxEncodedSize(size_t len)
+{
+    return len + (len + MAX_COPY - 1) / MAX_COPY;
+}
+
+/***************************************************************************
+*   Function   : VPackBitsInPlaceMargin
+*   Description: This routine returns the number of bytes that a buffer
+*                used by VPackBitsDecodeInPlace must have beyond the
+*                decoded length.  It is the most any encoded data can grow,
+*                one byte for every MAX_COPY decoded bytes.
+*   Parameters : decodedLen - Length of the decoded data
+*   Effects    : None
+*   Returned   : Margin that always allows an in place decode
+***************************************************************************/
+size_t VPackBitsInPlaceMargin(size_t decodedLen)
+{
+    return VPackBitsMaxEncodedSize(decodedLen) - decodedLen;
+}
 
-        count++;
+/***************************************************************************
+*   Function   : VPackBitsDecodeInPlace
+*   Description: This routine decodes packbits variant data stored at the
+*                end of a buffer, writing the results to the start of the
+*                same buffer.  Copy blocks are moved down, and a run is
+*                only filled after checking that it ends before the next
+*                unread byte of input.  Truncated blocks are handled the
+*                same way VPackBitsDecode handles them.
+*   Parameters : buf - Buffer holding the encoded data in its last
+*                      encodedLen bytes
+*                bufSize - Size of buf.  The decoded length plus
+*                          VPackBitsInPlaceMargin is always large enough.
+*                encodedLen - Length of the encoded data
+*                outLen - Set to the number of bytes decoded
+*   Effects    : Encoded data is decoded to the start of buf
+*   Returned   : 0 for success, -1 for failure.  errno will be set in the
+*                event of a failure (ENOSPC if the decoded data would
+*                overwrite unread input).  Failure leaves the contents of
+*                buf undefined.
+***************************************************************************/
+int VPackBitsDecodeInPlace(unsigned char *buf, size_t bufSize,
+    size_t encodedLen, size_t *outLen)
+{
+    size_t r;                           /* next encoded byte to read */
+    size_t w;                           /* next decoded byte to write */
+
+    if ((NULL == buf) || (NULL == outLen) || (encodedLen > bufSize))
+    {
+        errno = EINVAL;
+        return -1;
+    }
 
-        if (count >= MIN_RUN)
+    r = bufSize - encodedLen;
+    w = 0;
+
+    /* every header is read before its block is written, so copies always
+     * move data down and w never passes r.  runs are checked. */
+    while (r < bufSize)
+    {
+        int header;
+        size_t len;
+
+        header = (signed char)buf[r++];
+
+        if (header < 0)
         {
-            int i;
+            if (r == bufSize)
+            {
+                break;          /* run block is too short */
+            }
+
+            len = (MIN_RUN - 1) - header;
 
-            /* check for run  charBuf[count - 1] .. charBuf[count - MIN_RUN]*/
-            for (i = 2; i <= MIN_RUN; i++)
+            if (len > (r + 1 - w))
             {
-                if (currChar != charBuf[count - i])
-                {
-                    /* no run */
-                    i = 0;
-                    break;
-                }
+                *outLen = w;
+                errno = ENOSPC;
+                return -1;
             }
 
-            if (i != 0)
+            memset(buf + w, buf[r], len);
+            w += len;
+            r++;
+        }
+        else
+        {
+            len = header + 1;
+
+            if (len > (bufSize - r))
             {
-                /* we have a run write out buffer before run*/
-                int nextChar;
+                len = bufSize - r;      /* copy block is too short */
+            }
 
-                if (count > MIN_RUN)
-                {
-                    /* block size - 1 followed by contents */
-                    fputc(count - MIN_RUN - 1, outFile);
-                    fwrite(charBuf, sizeof(unsigned char), count - MIN_RUN,
-                        outFile);
-                }
+            memmove(buf + w, buf + r, len);
+            w += len;
+            r += len;
+        }
+    }
 
+    *outLen = w;
+    return 0;
+}
 
-                /* determine run length (MIN_RUN so far) */
-                count = MIN_RUN;
+/***************************************************************************
+*   Function   : EncodeChunk
+*   Description: This routine encodes a chunk of data.  Symbols are
+*                collected into copy blocks of up to MAX_COPY symbols until
+*                MIN_RUN matching symbols are found, then the run is
+*                counted up to MAX_RUN.  Symbols that might still start a
+*                run, and runs that reach the end of the chunk, are kept in
+*                the encoder state for the next chunk.
+*   Parameters : enc - Pointer to the encoder state
+*                data - Pointer to the chunk of data
+*                len - Number of bytes in the chunk
+*                out - Pointer to the stream receiving encoded data
+*   Effects    : Encoded data is written to out and enc is updated
+*   Returned   : None
+***************************************************************************/
+static void EncodeChunk(vpb_encoder_t *enc, const unsigned char *data,
+    size_t len, out_stream_t *out)
+{
+    const unsigned char *end;
 
-                while ((nextChar = fgetc(inFile)) == currChar)
-                {
-                    count++;
-                    if (MAX_RUN == count)
-                    {
-                        /* run is at max length */
-                        break;
-                    }
-                }
+    end = data + len;
 
-                /* write out encoded run length and run symbol */
-                fputc((char)((int)(MIN_RUN - 1) - (int)(count)), outFile);
-                fputc(currChar, outFile);
+    while (data < end)
+    {
+        const unsigned char *start;     /* literals not yet in charBuf */
+        size_t pending;                 /* charBuf symbols before start */
+        size_t avail;
+        size_t run;
 
-                if ((nextChar != EOF) && (count != MAX_RUN))
-                {
-                    /* make run breaker start of next buffer */
-                    charBuf[0] = nextChar;
-                    count = 1;
-                }
-                else
-                {
-                    /* file or max run ends in a run */
-                    count = 0;
-                }
+        if (enc->inRun)
+        {
+            size_t limit;
+            size_t k;
+
+            /* determine run length */
+            limit = MAX_RUN - enc->runLen;
+
+            if (limit > (size_t)(end - data))
+            {
+                limit = end - data;
+            }
+
+            k = ScanRun(data, limit, enc->runChar);
+            enc->runLen += k;
+            data += k;
+
+            if ((MAX_RUN == enc->runLen) || (data < end))
+            {
+                /* run is at max length or a new symbol ended it */
+                WriteRun(out, enc->runChar, enc->runLen);
+                enc->inRun = 0;
             }
+
+            continue;
         }
 
-        if (MAX_READ == count)
+        if (enc->count > 0)
         {
-            int i;
+            size_t fed;
 
-            /* write out buffer */
-            fputc(MAX_COPY - 1, outFile);
-            fwrite(charBuf, sizeof(unsigned char), MAX_COPY, outFile);
+            /* a run may start in the buffered symbols, check one at a time */
+            for (fed = 0; (fed < MIN_RUN - 1) && (data < end); fed++)
+            {
+                AddSymbol(enc, *data, out);
+                data++;
 
-            /* start a new buffer */
-            count = MAX_READ - MAX_COPY;
+                if (enc->inRun)
+                {
+                    break;
+                }
+            }
 
-            /* copy excess to front of buffer */
-            for (i = 0; i < count; i++)
+            if (enc->inRun || (fed < MIN_RUN - 1))
             {
-                charBuf[i] = charBuf[MAX_COPY + i];
+                continue;
             }
+
+            /* the last MIN_RUN - 1 symbols in charBuf came from data */
+            start = data - (MIN_RUN - 1);
+            pending = enc->count - (MIN_RUN - 1);
+        }
+        else
+        {
+            start = data;
+            pending = 0;
         }
 
-        currChar = fgetc(inFile);
-    }
+        /* charBuf[0 .. pending - 1] followed by start are literals */
+        avail = end - start;
+        run = FindTriple(start, avail);
 
-    /* write out last buffer */
-    if (0 != count)
-    {
-        if (count <= MAX_COPY)
+        if (run < avail)
         {
-            /* write out entire copy buffer */
-            fputc(count - 1, outFile);
-            fwrite(charBuf, sizeof(unsigned char), count, outFile);
+            /* we have a run write out buffer before run */
+            WriteCopies(out, enc->charBuf, pending, start, pending + run);
+            enc->count = 0;
+            enc->inRun = 1;
+            enc->runChar = start[run];
+            enc->runLen = MIN_RUN;
+            data = start + run + MIN_RUN;
         }
         else
         {
-            /* we read more than the maximum for a single copy buffer */
-            fputc(MAX_COPY - 1, outFile);
-            fwrite(charBuf, sizeof(unsigned char), MAX_COPY, outFile);
-
-            /* write out remainder */
-            count -= MAX_COPY;
-            fputc(count - 1, outFile);
-            fwrite(&charBuf[MAX_COPY], sizeof(unsigned char), count, outFile);
+            size_t total;
+            size_t written;
+
+            /* write every full copy block the end of the chunk can't
+             * extend into a run, then buffer the rest */
+            total = pending + avail;
+            written = 0;
+
+            if (total >= MAX_READ)
+            {
+                written = ((total - (MAX_READ - MAX_COPY)) / MAX_COPY) *
+                    MAX_COPY;
+                WriteCopies(out, enc->charBuf, pending, start, written);
+            }
+
+            if (written < pending)
+            {
+                memmove(enc->charBuf, enc->charBuf + written,
+                    pending - written);
+                memcpy(enc->charBuf + pending - written, start, avail);
+            }
+            else
+            {
+                memcpy(enc->charBuf, start + (written - pending),
+                    total - written);
+            }
+
+            enc->count = total - written;
+            data = end;
         }
     }
-
-    return 0;
 }
 
 /***************************************************************************
-*   Function   : VPackBitsDecodeFile
-*   Description: This routine opens a file encoded by a variant of the
-*                packbits run length encoding, and decodes it to an output
-*                file.
-*   Parameters : inFile - Pointer to the file to decode
-*                outFile - Pointer to the file to write decoded output to
-*   Effects    : Encoded file is decoded
-*   Returned   : 0 for success, -1 for failure.  errno will be set in the
-*                event of a failure.  Either way, inFile and outFile will
-*                be left open.
+*   Function   : AddSymbol
+*   Description: This routine adds one symbol to the encoder's buffer.  If
+*                the symbol completes a run, the symbols before the run are
+*                written as a copy block and the encoder starts counting
+*                the run.  If the buffer fills, a maximum sized copy block
+*                is written.
+*   Parameters : enc - Pointer to the encoder state
+*                c - The symbol to add
+*                out - Pointer to the stream receiving encoded data
+*   Effects    : Encoded data may be written to out and enc is updated
+*   Returned   : None
 ***************************************************************************/
-int VPackBitsDecodeFile(FILE *inFile, FILE *outFile)
+static void AddSymbol(vpb_encoder_t *enc, unsigned char c,
+    out_stream_t *out)
 {
-    int countChar;                      /* run/copy count */
-    int currChar;                       /* current character */
+    enc->charBuf[enc->count] = c;
+    enc->count++;
 
-    /* validate input and output files */
-    if ((NULL == inFile) || (NULL == outFile))
+    if ((enc->count >= MIN_RUN) &&
+        (enc->charBuf[enc->count - 2] == c) &&
+        (enc->charBuf[enc->count - 3] == c))
     {
-        errno = ENOENT;
-        return -1;
+        /* we have a run write out buffer before run */
+        WriteCopies(out, enc->charBuf, enc->count - MIN_RUN, NULL,
+            enc->count - MIN_RUN);
+        enc->count = 0;
+        enc->inRun = 1;
+        enc->runChar = c;
+        enc->runLen = MIN_RUN;
+    }
+    else if (MAX_READ == enc->count)
+    {
+        /* write out buffer and copy excess to front of buffer */
+        WriteCopies(out, enc->charBuf, MAX_COPY, NULL, MAX_COPY);
+        enc->count = MAX_READ - MAX_COPY;
+        memmove(enc->charBuf, enc->charBuf + MAX_COPY, enc->count);
+    }
+}
+
+/***************************************************************************
+*   Function   : WriteCopies
+*   Description: This routine writes symbols as copy blocks of up to
+*                MAX_COPY symbols each.  The symbols are taken from the
+*                end of one block followed by the start of a second block.
+*   Parameters : out - Pointer to the stream receiving encoded data
+*                first - Pointer to the first block of symbols
+*                firstLen - Number of symbols in first
+*                second - Pointer to the second block of symbols
+*                total - Total number of symbols to write
+*   Effects    : Copy blocks are written to out
+*   Returned   : None
+***************************************************************************/
+static void WriteCopies(out_stream_t *out, const unsigned char *first,
+    size_t firstLen, const unsigned char *second, size_t total)
+{
+    while (total > 0)
+    {
+        size_t n;
+        size_t k;
+
+        n = (total < MAX_COPY) ? total : MAX_COPY;
+        k = (firstLen < n) ? firstLen : n;
+
+        /* block size - 1 followed by contents */
+        OUT_PUTC(out, n - 1);
+        OutWrite(out, first, k);
+        first += k;
+        firstLen -= k;
+
+        if (n > k)
+        {
+            OutWrite(out, second, n - k);
+            second += n - k;
+        }
+
+        total -= n;
     }
+}
 
-    /* decode inFile */
+/***************************************************************************
+*   Function   : WriteRun
+*   Description: This routine writes a run block.
+*   Parameters : out - Pointer to the stream receiving encoded data
+*                c - The symbol in the run
+*                len - Length of the run (MIN_RUN to MAX_RUN)
+*   Effects    : A run block is written to out
+*   Returned   : None
+***************************************************************************/
+static void WriteRun(out_stream_t *out, unsigned char c, size_t len)
+{
+    /* write out encoded run length and run symbol */
+    OUT_PUTC(out, (int)(MIN_RUN - 1) - (int)len);
+    OUT_PUTC(out, c);
+}
+
+/***************************************************************************
+*   Function   : DecodeChunk
+*   Description: This routine decodes a chunk of packbits variant data.
+*                Blocks may be split across chunks.
+*   Parameters : dec - Pointer to the decoder state
+*                data - Pointer to the chunk of encoded data
+*                len - Number of bytes in the chunk
+*                out - Pointer to the stream receiving decoded data
+*   Effects    : Decoded data is written to out and dec is updated
+*   Returned   : None
+***************************************************************************/
+static void DecodeChunk(vpb_decoder_t *dec, const unsigned char *data,
+    size_t len, out_stream_t *out)
+{
+    const unsigned char *end;
 
-    /* read input until there's nothing left */
-    while ((countChar = fgetc(inFile)) != EOF)
+    end = data + len;
+
+    while (data < end)
     {
-        countChar = (char)countChar;    /* force sign extension */
+        if ((0 == dec->copyLeft) && (0 == dec->runLen) &&
+            ((size_t)(end - data) >= FAST_IN) &&
+            ((size_t)(out->end - out->next) >= FAST_OUT))
+        {
+            /* whole blocks with room to spare */
+            data = DecodeFast(data, end, out);
+        }
 
-        if (countChar < 0)
+        if (data == end)
         {
-            /* we have a run write out  2 - countChar copies */
-            countChar = (MIN_RUN - 1) - countChar;
+            break;
+        }
 
-            if (EOF == (currChar = fgetc(inFile)))
-            {
-                fprintf(stderr, "Run block is too short!\n");
-                countChar = 0;
-            }
+        if (dec->copyLeft > 0)
+        {
+            size_t k;
 
-            while (countChar > 0)
+            /* copy the rest of the block that is in this chunk */
+            k = end - data;
+
+            if (k > dec->copyLeft)
             {
-                fputc(currChar, outFile);
-                countChar--;
+                k = dec->copyLeft;
             }
+
+            OutWrite(out, data, k);
+            data += k;
+            dec->copyLeft -= k;
+        }
+        else if (dec->runLen > 0)
+        {
+            /* we have a run write out its symbol runLen times */
+            OutFill(out, *data, dec->runLen);
+            data++;
+            dec->runLen = 0;
         }
         else
         {
-            /* we have a block of countChar + 1 symbols to copy */
-            for (countChar++; countChar > 0; countChar--)
+            int countChar;
+
+            countChar = (signed char)*data;     /* force sign extension */
+            data++;
+
+            if (countChar < 0)
             {
-                if ((currChar = fgetc(inFile)) != EOF)
-                {
-                    fputc(currChar, outFile);
-                }
-                else
-                {
-                    fprintf(stderr, "Copy block is too short!\n");
-                    break;
-                }
+                /* we have a run write out  2 - countChar copies */
+                dec->runLen = (MIN_RUN - 1) - countChar;
+            }
+            else
+            {
+                /* we have a block of countChar + 1 symbols to copy */
+                dec->copyLeft = countChar + 1;
             }
         }
     }
+}
 
-    return 0;
+/***************************************************************************
+*   Function   : DecodeFast
+*   Description: This routine decodes whole blocks for as long as there is
+*                slack in both the encoded data and the output space.  The
+*                header table gives each block's length, so the only data
+*                dependent choice is where the symbols come from: the
+*                encoded data for a copy block, or a buffer filled with the
+*                run symbol for a run block.  Symbols are always stored
+*                FAST_STORE bytes at a time, so short blocks are written
+*                with one fixed size copy and the bytes past the end of the
+*                block are overwritten by the next one.
+*   Parameters : data - Pointer to the header of the next block
+*                end - End of the encoded data
+*                out - Pointer to encoded output stream
+*   Effects    : Decoded blocks are written to out->next
+*   Returned   : Pointer to the first header that wasn't decoded
+***************************************************************************/
+static const unsigned char *DecodeFast(const unsigned char *data,
+    const unsigned char *end, out_stream_t *out)
+{
+    unsigned char splat[FAST_STORE];
+    const unsigned char *source[2];
+    const unsigned char *inLast;
+    unsigned char *next;
+    unsigned char *outLast;
+
+    inLast = end - FAST_IN;
+    outLast = out->end - FAST_OUT;
+    next = out->next;
+
+    while ((data <= inLast) && (next <= outLast))
+    {
+        const vpb_header_t *header;
+        const unsigned char *from;
+        size_t i, j, step;
+
+        header = &headerTable[*data];
+
+        /* runs read from splat, copies from the encoded data */
+        memset(splat, data[1], FAST_STORE);
+        source[0] = splat;
+        source[1] = data + 1;
+        from = source[header->copy];
+        step = header->copy * FAST_STORE;
+        memcpy(next, from, FAST_STORE);
+
+        for (i = FAST_STORE, j = step; i < header->length;
+            i += FAST_STORE, j += step)
+        {
+            memcpy(next + i, from + j, FAST_STORE);
+        }
+
+        next += header->length;
+        data += header->size;
+    }
+
+    out->next = next;
+    return data;
 }